@@ -0,0 +1,175 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_ADAPTIVE_THROTTLER_H_
+#define GAPIC_GENERATOR_CPP_GAX_ADAPTIVE_THROTTLER_H_
+
+#include "gax/internal/random.h"
+#include "gax/retry_policy.h"
+#include "gax/status.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+namespace google {
+namespace gax {
+
+/**
+ * Shed load on the client when the backend is overloaded.
+ *
+ * This implements the "adaptive throttling" scheme described in the Site
+ * Reliability Engineering book. The throttler counts, over a sliding window,
+ * the requests made and the requests the backend accepted. A request is
+ * accepted unless it fails with `kResourceExhausted` or `kUnavailable`. New
+ * requests are rejected locally, with `kResourceExhausted`, with probability
+ *
+ *     max(0, (requests - k * accepts) / (requests + 1))
+ *
+ * While the backend accepts everything nothing is rejected. As the backend
+ * starts to refuse requests the client sends at most about `k` times the
+ * number of requests the backend accepts, so overload is shed before it
+ * reaches the wire. Locally rejected requests count as requests, so the
+ * rejection rate keeps up as long as the backend keeps refusing.
+ *
+ * A single throttler is usually shared by all the methods of a stub. The
+ * counters are atomics, the per-call hot path does not take any locks.
+ *
+ * @par Example
+ * @code
+ * auto throttler = std::make_shared<gax::AdaptiveThrottler<>>(
+ *     2.0, std::chrono::minutes(2));
+ * @endcode
+ */
+template <typename Clock = DefaultClock>
+class AdaptiveThrottler {
+ public:
+  /**
+   * @param k how many requests to send per accepted request before throttling,
+   *     values closer to 1 throttle more aggressively.
+   * @param window the length of the sliding window.
+   */
+  template <typename Rep, typename Period>
+  AdaptiveThrottler(double k, std::chrono::duration<Rep, Period> window,
+                    Clock c = Clock{})
+      : c_(std::move(c)),
+        k_(k),
+        bucket_width_(std::max(
+            std::chrono::duration_cast<std::chrono::milliseconds>(window) /
+                static_cast<int>(kBuckets),
+            std::chrono::milliseconds(1))) {
+    for (auto& bucket : buckets_) {
+      bucket.index.store(kStaleIndex, std::memory_order_relaxed);
+      bucket.requests.store(0, std::memory_order_relaxed);
+      bucket.accepts.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  AdaptiveThrottler(AdaptiveThrottler const&) = delete;
+  AdaptiveThrottler& operator=(AdaptiveThrottler const&) = delete;
+
+  /**
+   * Invoke @p call unless the request is throttled, and record its result.
+   *
+   * @return the status returned by @p call, or `kResourceExhausted` if the
+   *     request was rejected locally.
+   */
+  template <typename Functor>
+  gax::Status Call(Functor&& call) {
+    auto const p = RejectionProbability();
+    CurrentBucket().requests.fetch_add(1, std::memory_order_relaxed);
+    if (p > 0 && std::uniform_real_distribution<double>(0, 1)(
+                     internal::ThreadLocalRandom()) < p) {
+      return gax::Status(gax::StatusCode::kResourceExhausted,
+                         "Request throttled by the client: the service is "
+                         "rejecting too many requests");
+    }
+    gax::Status status = call();
+    if (status.code() != gax::StatusCode::kResourceExhausted &&
+        status.code() != gax::StatusCode::kUnavailable) {
+      CurrentBucket().accepts.fetch_add(1, std::memory_order_relaxed);
+    }
+    return status;
+  }
+
+  /// The probability that the next request is rejected locally.
+  double RejectionProbability() {
+    auto const current = CurrentIndex();
+    std::int64_t requests = 0;
+    std::int64_t accepts = 0;
+    for (auto const& bucket : buckets_) {
+      auto const index = bucket.index.load(std::memory_order_relaxed);
+      if (current - index < static_cast<std::int64_t>(kBuckets)) {
+        requests += bucket.requests.load(std::memory_order_relaxed);
+        accepts += bucket.accepts.load(std::memory_order_relaxed);
+      }
+    }
+    return std::max(0.0, (requests - k_ * accepts) / (requests + 1));
+  }
+
+ private:
+  // The window is split in this many buckets, older buckets are discarded as
+  // time moves on.
+  static constexpr std::size_t kBuckets = 10;
+  // No bucket index is this far in the past, so buckets start out stale.
+  static constexpr std::int64_t kStaleIndex =
+      std::numeric_limits<std::int64_t>::min() / 2;
+
+  struct Bucket {
+    std::atomic<std::int64_t> index;
+    std::atomic<std::int64_t> requests;
+    std::atomic<std::int64_t> accepts;
+  };
+
+  std::int64_t CurrentIndex() const {
+    return static_cast<std::int64_t>(c_.now().time_since_epoch() /
+                                     bucket_width_);
+  }
+
+  // Return the bucket for the current time, recycling a stale bucket if
+  // needed. Only the thread that wins the race to update the index resets the
+  // counters; updates racing with the reset may be lost, which is fine for an
+  // estimate.
+  Bucket& CurrentBucket() {
+    auto const current = CurrentIndex();
+    auto& bucket = buckets_[static_cast<std::size_t>(current) % kBuckets];
+    auto index = bucket.index.load(std::memory_order_relaxed);
+    if (index != current &&
+        bucket.index.compare_exchange_strong(index, current,
+                                             std::memory_order_relaxed)) {
+      bucket.requests.store(0, std::memory_order_relaxed);
+      bucket.accepts.store(0, std::memory_order_relaxed);
+    }
+    return bucket;
+  }
+
+  Clock c_;
+  double const k_;
+  std::chrono::milliseconds const bucket_width_;
+  std::array<Bucket, kBuckets> buckets_;
+};
+
+template <typename Clock>
+constexpr std::size_t AdaptiveThrottler<Clock>::kBuckets;
+
+template <typename Clock>
+constexpr std::int64_t AdaptiveThrottler<Clock>::kStaleIndex;
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_ADAPTIVE_THROTTLER_H_
@@ -0,0 +1,123 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/adaptive_throttler.h"
+#include "gax/internal/test_clock.h"
+#include "gax/status.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+using namespace ::google;
+using Throttler = gax::AdaptiveThrottler<gax::internal::TestClock>;
+
+gax::Status Accept() { return gax::Status{}; }
+gax::Status Overloaded() {
+  return gax::Status(gax::StatusCode::kResourceExhausted, "overloaded");
+}
+
+TEST(AdaptiveThrottler, HealthyBackendIsNotThrottled) {
+  std::chrono::steady_clock::time_point now_point;
+  Throttler tested(2.0, std::chrono::seconds(60),
+                   gax::internal::TestClock(now_point));
+  for (int i = 0; i != 1000; ++i) {
+    EXPECT_TRUE(tested.Call(Accept).IsOk());
+  }
+  EXPECT_EQ(tested.RejectionProbability(), 0.0);
+}
+
+TEST(AdaptiveThrottler, RejectionProbability) {
+  std::chrono::steady_clock::time_point now_point;
+  Throttler tested(2.0, std::chrono::seconds(60),
+                   gax::internal::TestClock(now_point));
+  // 10 accepted requests allow 20 requests before any throttling.
+  for (int i = 0; i != 10; ++i) {
+    tested.Call(Accept);
+  }
+  for (int i = 0; i != 10; ++i) {
+    tested.Call(Overloaded);
+  }
+  EXPECT_EQ(tested.RejectionProbability(), 0.0);
+
+  // Past that point, the rejection probability grows with the refusals.
+  for (int i = 0; i != 9; ++i) {
+    tested.Call(Overloaded);
+  }
+  auto const p = tested.RejectionProbability();
+  EXPECT_GT(p, 0.0);
+  EXPECT_LT(p, 1.0);
+}
+
+TEST(AdaptiveThrottler, OverloadedBackendIsShed) {
+  std::chrono::steady_clock::time_point now_point;
+  Throttler tested(2.0, std::chrono::seconds(60),
+                   gax::internal::TestClock(now_point));
+  for (int i = 0; i != 1000; ++i) {
+    tested.Call(Overloaded);
+  }
+  int sent = 0;
+  auto counted = [&sent] {
+    ++sent;
+    return Overloaded();
+  };
+  int rejected = 0;
+  for (int i = 0; i != 100; ++i) {
+    auto status = tested.Call(counted);
+    EXPECT_EQ(status.code(), gax::StatusCode::kResourceExhausted);
+    if (status.message() != "overloaded") {
+      ++rejected;
+    }
+  }
+  // The rejection probability is above 99.9%, allow for some slack.
+  EXPECT_GE(rejected, 90);
+  EXPECT_EQ(sent + rejected, 100);
+}
+
+TEST(AdaptiveThrottler, WindowSlides) {
+  std::chrono::steady_clock::time_point now_point;
+  Throttler tested(2.0, std::chrono::seconds(60),
+                   gax::internal::TestClock(now_point));
+  for (int i = 0; i != 100; ++i) {
+    tested.Call(Overloaded);
+  }
+  EXPECT_GT(tested.RejectionProbability(), 0.9);
+  now_point += std::chrono::seconds(61);
+  EXPECT_EQ(tested.RejectionProbability(), 0.0);
+}
+
+TEST(AdaptiveThrottler, Concurrent) {
+  std::chrono::steady_clock::time_point now_point;
+  Throttler tested(2.0, std::chrono::seconds(60),
+                   gax::internal::TestClock(now_point));
+  std::atomic<int> ok(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t != 4; ++t) {
+    threads.emplace_back([&tested, &ok] {
+      for (int i = 0; i != 1000; ++i) {
+        if (tested.Call(Accept).IsOk()) {
+          ++ok;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(ok.load(), 4000);
+}
+
+}  // namespace
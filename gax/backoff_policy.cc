@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "gax/backoff_policy.h"
+#include "gax/internal/random.h"
 #include <algorithm>
 #include <chrono>
 #include <memory>
@@ -21,17 +22,33 @@
 namespace google {
 namespace gax {
 
-std::chrono::microseconds ExponentialBackoffPolicy::OnCompletion() {
-  if (!generator_) {
-    generator_ = std::unique_ptr<std::mt19937_64>(
-        new std::mt19937_64(std::random_device()()));
-  }
+namespace {
 
+// A random delay in [min, max], from @p jitter or the per-thread default.
+std::chrono::microseconds RandomDelay(JitterSource* jitter,
+                                      std::chrono::microseconds min,
+                                      std::chrono::microseconds max) {
+  if (jitter) {
+    return std::chrono::microseconds(jitter->Uniform(min.count(), max.count()));
+  }
   std::uniform_int_distribution<std::chrono::microseconds::rep> dist(
-      current_delay_range_.count() / 2, current_delay_range_.count());
-  auto delay = std::chrono::microseconds(dist(*generator_));
+      min.count(), max.count());
+  return std::chrono::microseconds(dist(internal::ThreadLocalRandom()));
+}
 
-  current_delay_range_ = std::min(maximum_delay_, current_delay_range_ * 2);
+}  // namespace
+
+std::chrono::microseconds ExponentialBackoffPolicy::OnCompletion() {
+  auto delay = RandomDelay(jitter_.get(), current_delay_range_ / 2,
+                           current_delay_range_);
+
+  // Compare before converting back, the scaled range may not fit.
+  auto const next = current_delay_range_.count() * scaling_;
+  current_delay_range_ =
+      next < static_cast<double>(maximum_delay_.count())
+          ? std::chrono::microseconds(
+                static_cast<std::chrono::microseconds::rep>(next))
+          : maximum_delay_;
   return delay;
 }
 
@@ -39,5 +56,29 @@ std::unique_ptr<BackoffPolicy> ExponentialBackoffPolicy::clone() const {
   return std::unique_ptr<BackoffPolicy>(new ExponentialBackoffPolicy(*this));
 }
 
+std::chrono::microseconds FullJitterBackoffPolicy::OnCompletion() {
+  auto delay = RandomDelay(jitter_.get(), std::chrono::microseconds(0),
+                           current_delay_range_);
+  current_delay_range_ = std::min(maximum_delay_, current_delay_range_ * 2);
+  return delay;
+}
+
+std::unique_ptr<BackoffPolicy> FullJitterBackoffPolicy::clone() const {
+  return std::unique_ptr<BackoffPolicy>(new FullJitterBackoffPolicy(*this));
+}
+
+std::chrono::microseconds DecorrelatedJitterBackoffPolicy::OnCompletion() {
+  previous_delay_ = std::min(
+      maximum_delay_,
+      RandomDelay(jitter_.get(), initial_delay_,
+                  std::max(initial_delay_, previous_delay_ * 3)));
+  return previous_delay_;
+}
+
+std::unique_ptr<BackoffPolicy> DecorrelatedJitterBackoffPolicy::clone() const {
+  return std::unique_ptr<BackoffPolicy>(
+      new DecorrelatedJitterBackoffPolicy(*this));
+}
+
 }  // namespace gax
 }  // namespace google
@@ -16,9 +16,11 @@
 #define GAPIC_GENERATOR_CPP_GAX_BACKOFF_POLICY_H_
 
 #include "gax/internal/gtest_prod.h"
+#include "gax/policy_holder.h"
+#include "gax/status.h"
 #include <chrono>
+#include <cstdint>
 #include <memory>
-#include <random>
 
 namespace google {
 namespace gax {
@@ -56,12 +58,52 @@ class BackoffPolicy {
    */
   virtual std::chrono::microseconds OnCompletion() = 0;
 
+  /**
+   * Handle a failed attempt, honoring the server's retry advice.
+   *
+   * If the server requested a specific delay in @p status that delay replaces
+   * the computed one. The policy still advances its state, so later attempts
+   * without advice keep backing off.
+   *
+   * @return the delay to wait before the next retry attempt.
+   */
+  virtual std::chrono::microseconds OnFailure(gax::Status const& status) {
+    auto delay = OnCompletion();
+    if (status.HasRetryDelay()) {
+      return status.retry_delay();
+    }
+    return delay;
+  }
+
   /**
    * Return a new copy of this object.
    */
   virtual std::unique_ptr<BackoffPolicy> clone() const = 0;
 };
 
+/// A copyable backoff policy, stored inline when it is small enough.
+using BackoffPolicyHolder = PolicyHolder<BackoffPolicy>;
+
+/**
+ * Define the interface for the source of randomness in backoff policies.
+ *
+ * Backoff policies randomize their delays to spread out the retries of many
+ * clients. By default they use a small per-thread generator, seeded once per
+ * thread. Applications may provide their own source, e.g. to make delays
+ * reproducible in tests or simulations.
+ *
+ * A single source is shared by all the copies and clones of a policy, and is
+ * used concurrently by the calls that own them: implementations must be
+ * thread-safe.
+ */
+class JitterSource {
+ public:
+  virtual ~JitterSource() = default;
+
+  /// Return a uniformly distributed value in the closed range [@p min, @p max].
+  virtual std::int64_t Uniform(std::int64_t min, std::int64_t max) = 0;
+};
+
 /**
  * Implements a truncated exponential backoff with randomization policy.
  *
@@ -73,8 +115,9 @@ class BackoffPolicy {
  * policy also randomizes the delay each time, to avoid [thundering herd
  * problem](https://en.wikipedia.org/wiki/Thundering_herd_problem).
  *
- * Note: The random number generator used when calculating backoff time in
- *       OnCompletion is lazily created.
+ * Note: Unless a JitterSource is provided, the delays are randomized with a
+ *       per-thread generator shared by all the policies used on that thread.
+ *       Creating, copying, or cloning a policy does not allocate a generator.
  */
 class ExponentialBackoffPolicy : public BackoffPolicy {
  public:
@@ -115,20 +158,49 @@ class ExponentialBackoffPolicy : public BackoffPolicy {
    */
   template <typename duration1_t, typename duration2_t>
   ExponentialBackoffPolicy(duration1_t d1, duration2_t d2)
+      : ExponentialBackoffPolicy(d1, d2, nullptr) {}
+
+  /**
+   * Constructor for an exponential backoff policy with a custom jitter source.
+   *
+   * @param jitter the source of randomness for the delays, shared with the
+   *     copies and clones of this policy. If null, the per-thread default is
+   *     used.
+   */
+  template <typename duration1_t, typename duration2_t>
+  ExponentialBackoffPolicy(duration1_t d1, duration2_t d2,
+                           std::shared_ptr<JitterSource> jitter)
+      : ExponentialBackoffPolicy(d1, d2, 2.0, std::move(jitter)) {}
+
+  /**
+   * Constructor for an exponential backoff policy with a custom growth rate.
+   *
+   * @param scaling how much the delay range grows after each failure, must
+   *     be at least 1.0. The other constructors use 2.0.
+   * @param jitter the source of randomness for the delays, if null the
+   *     per-thread default is used.
+   */
+  template <typename duration1_t, typename duration2_t>
+  ExponentialBackoffPolicy(duration1_t d1, duration2_t d2, double scaling,
+                           std::shared_ptr<JitterSource> jitter = nullptr)
       : initial_delay_(
             std::chrono::duration_cast<std::chrono::microseconds>(d1)),
         current_delay_range_(initial_delay_),
         maximum_delay_(
-            std::chrono::duration_cast<std::chrono::microseconds>(d2)) {}
+            std::chrono::duration_cast<std::chrono::microseconds>(d2)),
+        scaling_(scaling),
+        jitter_(std::move(jitter)) {}
 
   ExponentialBackoffPolicy(ExponentialBackoffPolicy const& rhs) noexcept
-      : ExponentialBackoffPolicy(rhs.initial_delay_, rhs.maximum_delay_) {}
+      : ExponentialBackoffPolicy(rhs.initial_delay_, rhs.maximum_delay_,
+                                 rhs.scaling_, rhs.jitter_) {}
 
   ExponentialBackoffPolicy(ExponentialBackoffPolicy&& rhs) noexcept
       : initial_delay_(std::move(rhs.initial_delay_)),
         current_delay_range_(initial_delay_),
         maximum_delay_(std::move(rhs.maximum_delay_)),
-        generator_(std::move(rhs.generator_)) {}
+        scaling_(rhs.scaling_),
+        jitter_(std::move(rhs.jitter_)) {}
 
   std::chrono::microseconds OnCompletion() override;
 
@@ -139,17 +211,110 @@ class ExponentialBackoffPolicy : public BackoffPolicy {
   FRIEND_TEST(ExponentialBackoffPolicy, CopyConstruct);
   FRIEND_TEST(ExponentialBackoffPolicy, MoveConstruct);
   FRIEND_TEST(ExponentialBackoffPolicy, Clone);
-  FRIEND_TEST(ExponentialBackoffPolicy, LazyGenerator);
+  FRIEND_TEST(ExponentialBackoffPolicy, JitterSource);
+  FRIEND_TEST(ExponentialBackoffPolicy, Scaling);
 
   std::chrono::microseconds const initial_delay_;
   std::chrono::microseconds current_delay_range_;
   std::chrono::microseconds const maximum_delay_;
+  double const scaling_;
 
-  // Store via pointer and do not initialize until OnCompletion is called.
-  // The 19937 refers to bits of state: as a result, generator_ is very large,
-  // is expensive to create, and in any case most rpcs succeed on the first
-  // call.
-  std::unique_ptr<std::mt19937_64> generator_;
+  // Null for the per-thread default.
+  std::shared_ptr<JitterSource> jitter_;
+};
+
+/**
+ * Implements a truncated exponential backoff with "full jitter".
+ *
+ * The delay range grows like in ExponentialBackoffPolicy, but each delay is
+ * drawn from the whole range `[0, range]` rather than its upper half. When
+ * many clients fail at the same time their retries are spread out more,
+ * which lowers the peak load on the service at the cost of some clients
+ * retrying very quickly.
+ *
+ * @see https://aws.amazon.com/blogs/architecture/exponential-backoff-and-jitter/
+ */
+class FullJitterBackoffPolicy : public BackoffPolicy {
+ public:
+  /**
+   * @param initial_delay the delay range after the first failure.
+   * @param maximum_delay the maximum value for the delay range.
+   * @param jitter the source of randomness for the delays, shared with the
+   *     copies and clones of this policy. If null, the per-thread default is
+   *     used.
+   */
+  template <typename duration1_t, typename duration2_t>
+  FullJitterBackoffPolicy(duration1_t initial_delay, duration2_t maximum_delay,
+                          std::shared_ptr<JitterSource> jitter = nullptr)
+      : initial_delay_(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                initial_delay)),
+        current_delay_range_(initial_delay_),
+        maximum_delay_(std::chrono::duration_cast<std::chrono::microseconds>(
+            maximum_delay)),
+        jitter_(std::move(jitter)) {}
+
+  FullJitterBackoffPolicy(FullJitterBackoffPolicy const& rhs) noexcept
+      : FullJitterBackoffPolicy(rhs.initial_delay_, rhs.maximum_delay_,
+                                rhs.jitter_) {}
+
+  std::chrono::microseconds OnCompletion() override;
+
+  std::unique_ptr<BackoffPolicy> clone() const override;
+
+ private:
+  std::chrono::microseconds const initial_delay_;
+  std::chrono::microseconds current_delay_range_;
+  std::chrono::microseconds const maximum_delay_;
+  std::shared_ptr<JitterSource> jitter_;
+};
+
+/**
+ * Implements a backoff with "decorrelated jitter".
+ *
+ * Each delay is drawn from `[initial_delay, 3 * previous_delay]`, truncated
+ * to the maximum delay. The delays grow about as fast as with exponential
+ * backoff, but each one depends on the previous random draw rather than on
+ * the number of failures, so clients that failed together drift apart
+ * quickly.
+ *
+ * @see https://aws.amazon.com/blogs/architecture/exponential-backoff-and-jitter/
+ */
+class DecorrelatedJitterBackoffPolicy : public BackoffPolicy {
+ public:
+  /**
+   * @param initial_delay the smallest delay, and the first upper bound.
+   * @param maximum_delay the maximum value for any delay.
+   * @param jitter the source of randomness for the delays, shared with the
+   *     copies and clones of this policy. If null, the per-thread default is
+   *     used.
+   */
+  template <typename duration1_t, typename duration2_t>
+  DecorrelatedJitterBackoffPolicy(
+      duration1_t initial_delay, duration2_t maximum_delay,
+      std::shared_ptr<JitterSource> jitter = nullptr)
+      : initial_delay_(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                initial_delay)),
+        previous_delay_(initial_delay_),
+        maximum_delay_(std::chrono::duration_cast<std::chrono::microseconds>(
+            maximum_delay)),
+        jitter_(std::move(jitter)) {}
+
+  DecorrelatedJitterBackoffPolicy(
+      DecorrelatedJitterBackoffPolicy const& rhs) noexcept
+      : DecorrelatedJitterBackoffPolicy(rhs.initial_delay_, rhs.maximum_delay_,
+                                        rhs.jitter_) {}
+
+  std::chrono::microseconds OnCompletion() override;
+
+  std::unique_ptr<BackoffPolicy> clone() const override;
+
+ private:
+  std::chrono::microseconds const initial_delay_;
+  std::chrono::microseconds previous_delay_;
+  std::chrono::microseconds const maximum_delay_;
+  std::shared_ptr<JitterSource> jitter_;
 };
 
 }  // namespace gax
@@ -0,0 +1,78 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/backoff_policy.h"
+#include "gax/internal/thundering_herd.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory>
+
+namespace {
+using namespace ::google;
+
+// The first backoff of a call: every failed call clones the policy and asks
+// it for one delay.
+void BM_FirstBackoff(benchmark::State& state) {
+  gax::ExponentialBackoffPolicy const prototype(std::chrono::milliseconds(10),
+                                                std::chrono::seconds(1));
+  for (auto _ : state) {
+    auto policy = prototype.clone();
+    benchmark::DoNotOptimize(policy->OnCompletion());
+  }
+}
+BENCHMARK(BM_FirstBackoff)->ThreadRange(1, 8);
+
+// Subsequent backoffs on the same policy.
+void BM_NextBackoff(benchmark::State& state) {
+  gax::ExponentialBackoffPolicy policy(std::chrono::milliseconds(10),
+                                       std::chrono::seconds(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(policy.OnCompletion());
+  }
+}
+BENCHMARK(BM_NextBackoff);
+
+// Many clients retrying against an overloaded service, on virtual time. The
+// interesting output is in the counters rather than in the timings.
+template <typename Policy>
+void BM_ThunderingHerd(benchmark::State& state) {
+  gax::internal::ThunderingHerdConfig const config{
+      static_cast<int>(state.range(0)), 10, std::chrono::milliseconds(10),
+      100};
+  Policy const prototype(
+      std::chrono::milliseconds(10), std::chrono::seconds(1),
+      std::make_shared<gax::internal::SeededJitterSource>(42));
+  gax::internal::ThunderingHerdResult result{};
+  for (auto _ : state) {
+    result = gax::internal::SimulateThunderingHerd(config, prototype);
+  }
+  state.counters["attempts"] = static_cast<double>(result.total_attempts);
+  state.counters["peak_load"] = result.peak_load;
+  state.counters["completion_ms"] =
+      static_cast<double>(result.completion_time.count());
+  state.counters["failed_clients"] = result.failed_clients;
+}
+BENCHMARK_TEMPLATE(BM_ThunderingHerd, gax::ExponentialBackoffPolicy)
+    ->Arg(100)
+    ->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ThunderingHerd, gax::FullJitterBackoffPolicy)
+    ->Arg(100)
+    ->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ThunderingHerd, gax::DecorrelatedJitterBackoffPolicy)
+    ->Arg(100)
+    ->Arg(1000);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "gax/backoff_policy.h"
+#include "gax/status.h"
 #include <gtest/gtest.h>
 #include <chrono>
 #include <memory>
@@ -76,28 +77,131 @@ TEST(ExponentialBackoffPolicy, Clone) {
   EXPECT_EQ(cast_clone->maximum_delay_, std::chrono::milliseconds(320));
 }
 
-TEST(ExponentialBackoffPolicy, LazyGenerator) {
+// Always returns the smallest value, and counts the calls.
+class MinimumJitter : public JitterSource {
+ public:
+  std::int64_t Uniform(std::int64_t min, std::int64_t) override {
+    ++calls;
+    return min;
+  }
+  int calls = 0;
+};
+
+TEST(ExponentialBackoffPolicy, JitterSource) {
+  auto jitter = std::make_shared<MinimumJitter>();
   ExponentialBackoffPolicy tested(std::chrono::milliseconds(10),
-                                  std::chrono::milliseconds(320));
-  EXPECT_EQ(tested.generator_, nullptr);
-  tested.OnCompletion();
-  EXPECT_NE(tested.generator_, nullptr);
+                                  std::chrono::milliseconds(320), jitter);
+  EXPECT_EQ(tested.OnCompletion(), std::chrono::milliseconds(5));
+  EXPECT_EQ(tested.OnCompletion(), std::chrono::milliseconds(10));
 
-  // Copies and clones use their own lazily constructed generators
+  // Copies, clones, and moves share the source.
   ExponentialBackoffPolicy copy(tested);
-  EXPECT_EQ(copy.generator_, nullptr);
-  copy.OnCompletion();
-  EXPECT_NE(copy.generator_, nullptr);
+  EXPECT_EQ(copy.jitter_, jitter);
+  EXPECT_EQ(copy.OnCompletion(), std::chrono::milliseconds(5));
 
-  auto clone = std::unique_ptr<ExponentialBackoffPolicy>(
-      static_cast<ExponentialBackoffPolicy*>(copy.clone().release()));
-  EXPECT_EQ(clone->generator_, nullptr);
-  clone->OnCompletion();
-  EXPECT_NE(clone->generator_, nullptr);
+  auto clone = copy.clone();
+  EXPECT_EQ(clone->OnCompletion(), std::chrono::milliseconds(5));
 
-  // Moves reuse the existing generator
   ExponentialBackoffPolicy move(std::move(tested));
-  EXPECT_NE(move.generator_, nullptr);
+  EXPECT_EQ(move.jitter_, jitter);
+  EXPECT_EQ(jitter->calls, 4);
+
+  // The default source is not allocated per policy.
+  ExponentialBackoffPolicy default_source(std::chrono::milliseconds(10),
+                                          std::chrono::milliseconds(320));
+  EXPECT_EQ(default_source.jitter_, nullptr);
+  default_source.OnCompletion();
+  EXPECT_EQ(default_source.jitter_, nullptr);
+}
+
+TEST(ExponentialBackoffPolicy, Scaling) {
+  auto jitter = std::make_shared<MinimumJitter>();
+  ExponentialBackoffPolicy tested(std::chrono::milliseconds(10),
+                                  std::chrono::milliseconds(40), 1.5, jitter);
+  EXPECT_EQ(tested.scaling_, 1.5);
+  EXPECT_EQ(tested.OnCompletion(), std::chrono::microseconds(5000));
+  EXPECT_EQ(tested.OnCompletion(), std::chrono::microseconds(7500));
+  EXPECT_EQ(tested.OnCompletion(), std::chrono::microseconds(11250));
+  EXPECT_EQ(tested.OnCompletion(), std::chrono::microseconds(16875));
+  EXPECT_EQ(tested.OnCompletion(), std::chrono::microseconds(20000));
+
+  ExponentialBackoffPolicy copy(tested);
+  EXPECT_EQ(copy.scaling_, 1.5);
+  EXPECT_EQ(copy.OnCompletion(), std::chrono::microseconds(5000));
+}
+
+// Always returns the largest value.
+class MaximumJitter : public JitterSource {
+ public:
+  std::int64_t Uniform(std::int64_t, std::int64_t max) override { return max; }
+};
+
+TEST(FullJitterBackoffPolicy, Basic) {
+  auto minimum = std::make_shared<MinimumJitter>();
+  FullJitterBackoffPolicy lower(std::chrono::milliseconds(10),
+                                std::chrono::milliseconds(40), minimum);
+  EXPECT_EQ(lower.OnCompletion(), std::chrono::milliseconds(0));
+  EXPECT_EQ(lower.OnCompletion(), std::chrono::milliseconds(0));
+
+  FullJitterBackoffPolicy upper(std::chrono::milliseconds(10),
+                                std::chrono::milliseconds(40),
+                                std::make_shared<MaximumJitter>());
+  EXPECT_EQ(upper.OnCompletion(), std::chrono::milliseconds(10));
+  EXPECT_EQ(upper.OnCompletion(), std::chrono::milliseconds(20));
+  EXPECT_EQ(upper.OnCompletion(), std::chrono::milliseconds(40));
+  EXPECT_EQ(upper.OnCompletion(), std::chrono::milliseconds(40));
+
+  // Clones start over.
+  auto clone = upper.clone();
+  EXPECT_EQ(clone->OnCompletion(), std::chrono::milliseconds(10));
+
+  FullJitterBackoffPolicy random(std::chrono::milliseconds(10),
+                                 std::chrono::milliseconds(40));
+  for (int i = 0; i != 10; ++i) {
+    auto delay = random.OnCompletion();
+    EXPECT_GE(delay, std::chrono::milliseconds(0));
+    EXPECT_LE(delay, std::chrono::milliseconds(40));
+  }
+}
+
+TEST(DecorrelatedJitterBackoffPolicy, Basic) {
+  DecorrelatedJitterBackoffPolicy lower(std::chrono::milliseconds(10),
+                                        std::chrono::milliseconds(100),
+                                        std::make_shared<MinimumJitter>());
+  EXPECT_EQ(lower.OnCompletion(), std::chrono::milliseconds(10));
+  EXPECT_EQ(lower.OnCompletion(), std::chrono::milliseconds(10));
+
+  DecorrelatedJitterBackoffPolicy upper(std::chrono::milliseconds(10),
+                                        std::chrono::milliseconds(100),
+                                        std::make_shared<MaximumJitter>());
+  EXPECT_EQ(upper.OnCompletion(), std::chrono::milliseconds(30));
+  EXPECT_EQ(upper.OnCompletion(), std::chrono::milliseconds(90));
+  EXPECT_EQ(upper.OnCompletion(), std::chrono::milliseconds(100));
+  EXPECT_EQ(upper.OnCompletion(), std::chrono::milliseconds(100));
+
+  auto clone = upper.clone();
+  EXPECT_EQ(clone->OnCompletion(), std::chrono::milliseconds(30));
+
+  DecorrelatedJitterBackoffPolicy random(std::chrono::milliseconds(10),
+                                         std::chrono::milliseconds(100));
+  for (int i = 0; i != 10; ++i) {
+    auto delay = random.OnCompletion();
+    EXPECT_GE(delay, std::chrono::milliseconds(10));
+    EXPECT_LE(delay, std::chrono::milliseconds(100));
+  }
+}
+
+TEST(ExponentialBackoffPolicy, ServerRetryDelay) {
+  ExponentialBackoffPolicy tested(std::chrono::milliseconds(10),
+                                  std::chrono::milliseconds(320));
+  Status pushback(StatusCode::kUnavailable, "", "",
+                  std::chrono::milliseconds(100));
+  EXPECT_EQ(tested.OnFailure(pushback), std::chrono::milliseconds(100));
+
+  // The policy still backs off as usual when the server gives no advice.
+  auto delay = tested.OnFailure(Status(StatusCode::kUnavailable, ""));
+  EXPECT_GE(delay, std::chrono::milliseconds(10));
+  EXPECT_LE(delay, std::chrono::milliseconds(20));
 }
 
 }  // namespace gax
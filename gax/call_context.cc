@@ -13,59 +13,184 @@
 // limitations under the License.
 
 #include "gax/call_context.h"
+#include "gax/internal/request_params.h"
+#include <atomic>
 #include <chrono>
 
 namespace google {
 namespace gax {
 
-void CallContext::SetDeadline(std::chrono::system_clock::time_point deadline) {
+namespace {
+CallContext::MetadataList const& EmptyMetadata() {
+  static auto const* const kEmpty = new CallContext::MetadataList;
+  return *kEmpty;
+}
+
+bool HasKey(CallContext::MetadataList const& metadata,
+            std::string const& key) {
+  for (auto const& m : metadata) {
+    if (m.first == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string const& RequestParamsHeader() {
+  static auto const* const kHeader =
+      new std::string(internal::kRequestParamsHeader);
+  return *kHeader;
+}
+}  // namespace
+
+CallContext::Settings& CallContext::MutableSettings() {
+  if (!settings_) {
+    settings_ = std::make_shared<Settings>();
+  } else if (settings_.use_count() != 1) {
+    settings_ = std::make_shared<Settings>(*settings_);
+  } else {
+    // Another context may have released the settings just now, make its
+    // reads happen before our writes.
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  return *settings_;
+}
+
+void CallContext::SetDeadline(std::chrono::steady_clock::time_point deadline) {
   deadline_ = std::move(deadline);
 }
 
+void CallContext::SetDeadline(std::chrono::system_clock::time_point deadline) {
+  deadline_ = internal::ToSteadyDeadline(deadline);
+}
+
+void CallContext::SetTimeout(std::chrono::steady_clock::duration timeout) {
+  auto const now = std::chrono::steady_clock::now();
+  // Compare the remaining time, `now + timeout` may overflow.
+  if (deadline_ - now > timeout) {
+    deadline_ = now + timeout;
+  }
+}
+
+CallContext CallContext::Child(MethodInfo method_info) const {
+  CallContext child(std::move(method_info));
+  child.deadline_ = deadline_;
+  child.cancellation_token_ = cancellation_token_;
+  return child;
+}
+
 void CallContext::AddGrpcContextPolicy(GrpcContextPolicyFunc f) {
-  context_policies_.emplace_back(std::move(f));
+  MutableSettings().context_policies.emplace_back(std::move(f));
 }
 
 void CallContext::PrepareGrpcContext(grpc::ClientContext* context) {
-  context->set_deadline(deadline_);
+  PrepareGrpcContext(context, std::string());
+}
 
-  for (auto const& m : metadata_) {
-    context->AddMetadata(m.first, m.second);
+void CallContext::PrepareGrpcContext(grpc::ClientContext* context,
+                                     std::string const& request_params) {
+  context->set_deadline(internal::ToGrpcDeadline(deadline_));
+  VisitMetadata(request_params,
+                [context](std::string const& key, std::string const& value) {
+                  context->AddMetadata(key, value);
+                });
+  if (!settings_) {
+    return;
   }
 
-  for (auto const& f : context_policies_) {
+  for (auto const& f : settings_->context_policies) {
     f(context);
   }
 }
 
+void CallContext::VisitMetadata(std::string const& request_params,
+                                MetadataVisitor const& visitor) const {
+  if (metadata_set_) {
+    for (auto const& entry : *metadata_set_) {
+      visitor(*entry.key, entry.value);
+    }
+  }
+  if (!request_params.empty()) {
+    auto const& header = RequestParamsHeader();
+    bool const caller_set =
+        (settings_ && HasKey(settings_->metadata, header)) ||
+        (metadata_set_ && metadata_set_->Find(header));
+    if (!caller_set) {
+      visitor(header, request_params);
+    }
+  }
+  if (settings_) {
+    for (auto const& m : settings_->metadata) {
+      visitor(m.first, m.second);
+    }
+  }
+}
+
 void CallContext::AddMetadata(std::string key, std::string val) {
-  metadata_.emplace(std::move(key), std::move(val));
+  MutableSettings().metadata.emplace_back(std::move(key), std::move(val));
+}
+
+CallContext::MetadataList const& CallContext::Metadata() const {
+  return settings_ ? settings_->metadata : EmptyMetadata();
 }
 
-std::multimap<std::string, std::string const> const& CallContext::Metadata()
+void CallContext::SetMetadataSet(
+    std::shared_ptr<gax::MetadataSet const> metadata) {
+  metadata_set_ = std::move(metadata);
+}
+
+std::shared_ptr<gax::MetadataSet const> const& CallContext::MetadataSet()
     const {
-  return metadata_;
+  return metadata_set_;
 }
 
 MethodInfo CallContext::Info() const { return method_info_; }
 
-std::unique_ptr<gax::RetryPolicy> CallContext::RetryPolicy() const {
-  return retry_policy_ ? retry_policy_->clone() : nullptr;
+gax::RetryPolicyHolder CallContext::RetryPolicy() const {
+  return retry_policy_;
+}
+
+gax::BackoffPolicyHolder CallContext::BackoffPolicy() const {
+  return backoff_policy_;
+}
+
+bool CallContext::HasRetryPolicy() const {
+  return static_cast<bool>(retry_policy_);
+}
+
+bool CallContext::HasBackoffPolicy() const {
+  return static_cast<bool>(backoff_policy_);
+}
+
+void CallContext::SetRetryBudget(
+    std::shared_ptr<gax::RetryBudget> retry_budget) {
+  retry_budget_ = std::move(retry_budget);
 }
 
-std::unique_ptr<gax::BackoffPolicy> CallContext::BackoffPolicy() const {
-  return backoff_policy_ ? backoff_policy_->clone() : nullptr;
+std::shared_ptr<gax::RetryBudget> CallContext::RetryBudget() const {
+  return retry_budget_;
 }
 
-void CallContext::SetRetryPolicy(gax::RetryPolicy const& retry_policy) {
-  retry_policy_ = retry_policy.clone();
+void CallContext::SetRetryObserver(
+    std::shared_ptr<gax::RetryObserver> observer) {
+  retry_observer_ = std::move(observer);
 }
 
-void CallContext::SetBackoffPolicy(gax::BackoffPolicy const& backoff_policy) {
-  backoff_policy_ = backoff_policy.clone();
+std::shared_ptr<gax::RetryObserver> CallContext::RetryObserver() const {
+  return retry_observer_;
+}
+
+void CallContext::SetCancellationToken(
+    std::shared_ptr<gax::CancellationToken> token) {
+  cancellation_token_ = std::move(token);
+}
+
+std::shared_ptr<gax::CancellationToken> CallContext::CancellationToken()
+    const {
+  return cancellation_token_;
 }
 
-std::chrono::system_clock::time_point CallContext::Deadline() const {
+std::chrono::steady_clock::time_point CallContext::Deadline() const {
   return deadline_;
 }
 
@@ -17,19 +17,28 @@
 
 #include "grpcpp/client_context.h"
 #include "gax/backoff_policy.h"
+#include "gax/cancellation_token.h"
+#include "gax/clock.h"
+#include "gax/internal/small_function.h"
+#include "gax/internal/small_vector.h"
+#include "gax/metadata_set.h"
+#include "gax/retry_budget.h"
+#include "gax/retry_observer.h"
 #include "gax/retry_policy.h"
 #include <chrono>
-#include <functional>
-#include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 /**
  * Callback type for custom manipulation of grpc::ClientContext.
  * These callbacks can be used to manipulate advanced grpc settings.
+ *
+ * Lambdas capturing up to four pointers are stored without allocating.
  */
-using GrpcContextPolicyFunc = std::function<void(grpc::ClientContext*)>;
+using GrpcContextPolicyFunc =
+    google::gax::internal::SmallFunction<void(grpc::ClientContext*)>;
 
 namespace google {
 namespace gax {
@@ -114,25 +123,40 @@ struct MethodInfo {
  */
 class CallContext {
  public:
+  /// The metadata pairs added with AddMetadata(), in the order added.
+  using MetadataList =
+      internal::SmallVector<std::pair<std::string, std::string>, 2>;
+
   CallContext(MethodInfo method_info)
-      : deadline_(std::chrono::system_clock::time_point::max()),
+      : deadline_(std::chrono::steady_clock::time_point::max()),
         method_info_(std::move(method_info)) {}
 
+  /**
+   * Copies are cheap: the context policies and metadata are shared with
+   * @p rhs and only copied when either context modifies them, and the retry
+   * and backoff policies are usually stored inline. A retry loop can make a
+   * fresh copy for each attempt without allocating.
+   */
   CallContext(CallContext const& rhs)
       : deadline_(rhs.deadline_),
-        retry_policy_(rhs.retry_policy_ ? rhs.retry_policy_->clone() : nullptr),
-        backoff_policy_(rhs.backoff_policy_ ? rhs.backoff_policy_->clone()
-                                            : nullptr),
-        context_policies_(rhs.context_policies_),
-        metadata_(rhs.metadata_),
+        retry_policy_(rhs.retry_policy_),
+        backoff_policy_(rhs.backoff_policy_),
+        settings_(rhs.settings_),
+        metadata_set_(rhs.metadata_set_),
+        retry_budget_(rhs.retry_budget_),
+        retry_observer_(rhs.retry_observer_),
+        cancellation_token_(rhs.cancellation_token_),
         method_info_(rhs.method_info_) {}
 
   CallContext(CallContext&& rhs)
       : deadline_(rhs.deadline_),
         retry_policy_(std::move(rhs.retry_policy_)),
         backoff_policy_(std::move(rhs.backoff_policy_)),
-        context_policies_(std::move(rhs.context_policies_)),
-        metadata_(std::move(rhs.metadata_)),
+        settings_(std::move(rhs.settings_)),
+        metadata_set_(std::move(rhs.metadata_set_)),
+        retry_budget_(std::move(rhs.retry_budget_)),
+        retry_observer_(std::move(rhs.retry_observer_)),
+        cancellation_token_(std::move(rhs.cancellation_token_)),
         method_info_(std::move(rhs.method_info_)) {}
 
   /**
@@ -152,6 +176,32 @@ class CallContext {
    */
   void PrepareGrpcContext(grpc::ClientContext* context);
 
+  /**
+   * Initializes a grpc::ClientContext, sending @p request_params in the
+   * `x-goog-request-params` header.
+   *
+   * Generated stubs build @p request_params from the request fields that
+   * identify the resource, see internal::RequestParamsBuilder. The header is
+   * not sent if @p request_params is empty, or if the caller already set it
+   * with AddMetadata() or a MetadataSet. Otherwise it is sent after the
+   * MetadataSet pairs and before the ones added with AddMetadata().
+   */
+  void PrepareGrpcContext(grpc::ClientContext* context,
+                          std::string const& request_params);
+
+  using MetadataVisitor =
+      internal::SmallFunction<void(std::string const&, std::string const&)>;
+
+  /**
+   * Call @p visitor with each metadata pair that
+   * `PrepareGrpcContext(context, request_params)` adds, in the same order.
+   *
+   * That is the MetadataSet pairs, then the `x-goog-request-params` header if
+   * it is sent, then the pairs added with AddMetadata().
+   */
+  void VisitMetadata(std::string const& request_params,
+                     MetadataVisitor const& visitor) const;
+
   /**
    * @brief Register application-specific metadata.
    *
@@ -160,34 +210,163 @@ class CallContext {
    */
   void AddMetadata(std::string key, std::string val);
 
-  std::multimap<std::string, std::string const> const& Metadata() const;
+  /// The metadata added with AddMetadata(), not including the MetadataSet.
+  MetadataList const& Metadata() const;
+
+  /**
+   * @brief Attach metadata shared with other calls.
+   *
+   * The pairs in @p metadata are sent before the ones added with
+   * AddMetadata(). Copies of the context share the set, nothing is copied.
+   */
+  void SetMetadataSet(std::shared_ptr<gax::MetadataSet const> metadata);
+  std::shared_ptr<gax::MetadataSet const> const& MetadataSet() const;
 
   /**
    * @brief Set a deadline for the rpc.
    */
+  void SetDeadline(std::chrono::steady_clock::time_point deadline);
+
+  /**
+   * @brief Set a deadline for the rpc from a wall-clock time point.
+   *
+   * The deadline is converted to the steady clock when it is set, later
+   * changes to the system time do not affect it.
+   */
   void SetDeadline(std::chrono::system_clock::time_point deadline);
 
+  /**
+   * @brief Limit the rpc to @p timeout from now.
+   *
+   * The deadline only moves earlier: if the context already has an earlier
+   * deadline, e.g. one inherited from a parent call, it is kept. Generated
+   * clients use this to apply each method's default timeout.
+   */
+  void SetTimeout(std::chrono::steady_clock::duration timeout);
+
   /**
    * @brief Accessor for configured rpc deadline.
    */
-  std::chrono::system_clock::time_point Deadline() const;
+  std::chrono::steady_clock::time_point Deadline() const;
+
+  /**
+   * @brief Create the context for an rpc made on behalf of this call.
+   *
+   * The child inherits the deadline and the cancellation token, so it gives
+   * up as soon as this call does. Policies and metadata are specific to each
+   * method and are not inherited.
+   */
+  CallContext Child(MethodInfo method_info) const;
+
+  /**
+   * @brief Create the context for an rpc made while serving another one.
+   *
+   * The context inherits the deadline of the incoming call, so a server does
+   * not keep calling other services after its own caller gave up.
+   *
+   * @tparam ServerContext `grpc::ServerContext`, `grpc::CallbackServerContext`
+   *     or any type with a `std::chrono::system_clock::time_point deadline()`
+   *     member function.
+   */
+  template <typename ServerContext>
+  static CallContext FromServerContext(MethodInfo method_info,
+                                       ServerContext const& server_context) {
+    CallContext context(std::move(method_info));
+    context.SetDeadline(server_context.deadline());
+    return context;
+  }
 
   /**
    * @brief Accessor for method info.
    */
   MethodInfo Info() const;
 
-  void SetRetryPolicy(gax::RetryPolicy const& retry_policy);
-  std::unique_ptr<gax::RetryPolicy> RetryPolicy() const;
-  void SetBackoffPolicy(gax::BackoffPolicy const& backoff_policy);
-  std::unique_ptr<gax::BackoffPolicy> BackoffPolicy() const;
+  /**
+   * @brief Set the retry policy used by retry stubs for this call.
+   *
+   * Policies that fit in a RetryPolicyHolder are copied inline, so setting,
+   * copying, and retrieving them does not allocate. Other policies are cloned.
+   */
+  template <typename RetryPolicyT,
+            typename std::enable_if<
+                std::is_base_of<gax::RetryPolicy, RetryPolicyT>::value,
+                int>::type = 0>
+  void SetRetryPolicy(RetryPolicyT const& retry_policy) {
+    retry_policy_ = gax::RetryPolicyHolder(retry_policy);
+  }
+
+  /// Return a copy of the retry policy, empty if none was set.
+  gax::RetryPolicyHolder RetryPolicy() const;
+
+  /// Like SetRetryPolicy(), for the backoff policy.
+  template <typename BackoffPolicyT,
+            typename std::enable_if<
+                std::is_base_of<gax::BackoffPolicy, BackoffPolicyT>::value,
+                int>::type = 0>
+  void SetBackoffPolicy(BackoffPolicyT const& backoff_policy) {
+    backoff_policy_ = gax::BackoffPolicyHolder(backoff_policy);
+  }
+
+  /// Return a copy of the backoff policy, empty if none was set.
+  gax::BackoffPolicyHolder BackoffPolicy() const;
+
+  /**
+   * @brief Return true if a policy was set, without copying it.
+   *
+   * Retry stubs use these to skip cloning the context's policies when they
+   * would use their own defaults anyway.
+   */
+  bool HasRetryPolicy() const;
+  bool HasBackoffPolicy() const;
+
+  /**
+   * @brief Share a retry budget with the call.
+   *
+   * Unlike the retry and backoff policies the budget is not cloned: all the
+   * calls that use the same budget draw from, and replenish, the same tokens.
+   */
+  void SetRetryBudget(std::shared_ptr<gax::RetryBudget> retry_budget);
+  std::shared_ptr<gax::RetryBudget> RetryBudget() const;
+
+  /**
+   * @brief Report the attempts made by retry loops to @p observer.
+   *
+   * Like the retry budget the observer is shared, not cloned.
+   */
+  void SetRetryObserver(std::shared_ptr<gax::RetryObserver> observer);
+  std::shared_ptr<gax::RetryObserver> RetryObserver() const;
+
+  /**
+   * @brief Attach a token that cancels the rpcs made with this context.
+   *
+   * Copies of the context share the token.
+   */
+  void SetCancellationToken(std::shared_ptr<gax::CancellationToken> token);
+  std::shared_ptr<gax::CancellationToken> CancellationToken() const;
 
  private:
-  std::chrono::system_clock::time_point deadline_;
-  std::unique_ptr<gax::RetryPolicy const> retry_policy_;
-  std::unique_ptr<gax::BackoffPolicy const> backoff_policy_;
-  std::vector<GrpcContextPolicyFunc> context_policies_;
-  std::multimap<std::string, std::string const> metadata_;
+  // The settings that stub layers customize. They are never modified once
+  // shared between contexts, see MutableSettings(). A typical call has at
+  // most two of each, stored inline, so customizing a context allocates this
+  // block and nothing else.
+  struct Settings {
+    internal::SmallVector<GrpcContextPolicyFunc, 2> context_policies;
+    MetadataList metadata;
+  };
+
+  // Return settings owned by this context alone, copying the shared ones if
+  // needed.
+  Settings& MutableSettings();
+
+  std::chrono::steady_clock::time_point deadline_;
+  gax::RetryPolicyHolder retry_policy_;
+  gax::BackoffPolicyHolder backoff_policy_;
+  // Null until the first customization, most calls never need any.
+  std::shared_ptr<Settings> settings_;
+  std::shared_ptr<gax::MetadataSet const> metadata_set_;
+  std::shared_ptr<gax::RetryBudget> retry_budget_;
+  std::shared_ptr<gax::RetryObserver> retry_observer_;
+  std::shared_ptr<gax::CancellationToken> cancellation_token_;
   MethodInfo const method_info_;
 };
 
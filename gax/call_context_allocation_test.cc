@@ -0,0 +1,133 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/call_context.h"
+#include "grpcpp/client_context.h"
+#include "gax/metadata_set.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+// Count the allocations made by this program while `counting` is set.
+bool counting = false;
+int allocations = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+  if (counting) {
+    ++allocations;
+  }
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+using namespace ::google;
+
+gax::MethodInfo const kInfo{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                            gax::MethodInfo::Idempotency::IDEMPOTENT};
+
+// Return the number of allocations made by @p f.
+template <typename Functor>
+int CountAllocations(Functor&& f) {
+  allocations = 0;
+  counting = true;
+  f();
+  counting = false;
+  return allocations;
+}
+
+TEST(CallContextAllocations, ConstructAndCopy) {
+  EXPECT_EQ(0, CountAllocations([] {
+              gax::CallContext context(kInfo);
+              context.SetDeadline(std::chrono::steady_clock::now());
+              gax::CallContext copy(context);
+              gax::CallContext moved(std::move(copy));
+            }));
+}
+
+TEST(CallContextAllocations, TypicalCustomization) {
+  gax::CallContext context(kInfo);
+  int attempts = 0;
+  bool wait_for_ready = false;
+  // One block holds both policies and both pairs, none of the values is long
+  // enough to need its own allocation.
+  EXPECT_EQ(1, CountAllocations([&] {
+              context.AddGrpcContextPolicy(
+                  [&attempts](grpc::ClientContext*) { ++attempts; });
+              context.AddGrpcContextPolicy(
+                  [&wait_for_ready](grpc::ClientContext* c) {
+                    c->set_wait_for_ready(wait_for_ready);
+                  });
+              context.AddMetadata("x-a", "1");
+              context.AddMetadata("x-b", "2");
+            }));
+  EXPECT_EQ(0, CountAllocations([&] {
+              gax::CallContext copy(context);
+              gax::CallContext other(copy);
+            }));
+}
+
+TEST(CallContextAllocations, PrepareGrpcContext) {
+  gax::CallContext context(kInfo);
+  int attempts = 0;
+  context.AddGrpcContextPolicy(
+      [&attempts](grpc::ClientContext*) { ++attempts; });
+  context.SetDeadline(std::chrono::steady_clock::now() +
+                      std::chrono::seconds(10));
+
+  grpc::ClientContext client_context;
+  EXPECT_EQ(0, CountAllocations([&] {
+              gax::CallContext copy(context);
+              copy.PrepareGrpcContext(&client_context);
+            }));
+  EXPECT_EQ(attempts, 1);
+}
+
+TEST(CallContextAllocations, PrepareGrpcContextWithMetadata) {
+  // grpc::ClientContext copies the metadata it is given, CallContext must not
+  // allocate anything beyond that.
+  std::vector<std::pair<std::string, std::string>> const pairs = {
+      {"x-goog-api-client", "gl-cpp/0.1.0"}, {"x-a", "1"}, {"x-b", "2"}};
+  grpc::ClientContext baseline_context;
+  auto const baseline = CountAllocations([&] {
+    for (auto const& p : pairs) {
+      baseline_context.AddMetadata(p.first, p.second);
+    }
+  });
+
+  gax::CallContext context(kInfo);
+  context.SetMetadataSet(
+      gax::MetadataSet::Create({{"x-goog-api-client", "gl-cpp/0.1.0"}}));
+  context.AddMetadata("x-a", "1");
+  context.AddMetadata("x-b", "2");
+  grpc::ClientContext client_context;
+  EXPECT_EQ(baseline, CountAllocations([&] {
+              gax::CallContext copy(context);
+              copy.PrepareGrpcContext(&client_context);
+            }));
+}
+
+}  // namespace
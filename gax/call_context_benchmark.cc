@@ -0,0 +1,173 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/call_context.h"
+#include "google/longrunning/operations.pb.h"
+#include "gax/backoff_policy.h"
+#include "gax/metadata_set.h"
+#include "gax/retry_loop.h"
+#include "gax/retry_policy.h"
+#include "gax/status.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+// Count every heap allocation made by the process, so the benchmarks can
+// report allocations per attempt.
+namespace {
+std::atomic<long> allocations(0);
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+using namespace ::google;
+
+// Run `State` iterations of `attempt` and report the allocations each made.
+template <typename Functor>
+void CountAllocations(benchmark::State& state, Functor&& attempt) {
+  auto const before = allocations.load();
+  for (auto _ : state) {
+    attempt();
+  }
+  state.counters["allocs_per_attempt"] =
+      static_cast<double>(allocations.load() - before) / state.iterations();
+}
+
+gax::MethodInfo const kInfo{"GetOperation",
+                            gax::MethodInfo::RpcType::NORMAL_RPC,
+                            gax::MethodInfo::Idempotency::IDEMPOTENT};
+
+// The metadata a client sends on every call, built once.
+std::shared_ptr<gax::MetadataSet const> const& ClientMetadata() {
+  static auto const* const kMetadata =
+      new std::shared_ptr<gax::MetadataSet const>(gax::MetadataSet::Create(
+          {{"x-goog-api-client", "gl-cpp/0.1.0"},
+           {"x-goog-user-project", "my-project"}}));
+  return *kMetadata;
+}
+
+// A context as configured by a typical client: policies, metadata, and a
+// context policy.
+gax::CallContext MakeContext() {
+  gax::CallContext context(kInfo);
+  context.SetRetryPolicy(
+      gax::LimitedErrorCountRetryPolicy<>(3, std::chrono::milliseconds(50)));
+  context.SetBackoffPolicy(gax::ExponentialBackoffPolicy(
+      std::chrono::milliseconds(1), std::chrono::milliseconds(10)));
+  context.SetMetadataSet(ClientMetadata());
+  context.AddMetadata("x-goog-request-params", "name=operations/foo");
+  context.AddGrpcContextPolicy([](grpc::ClientContext*) {});
+  return context;
+}
+
+// The per-attempt copy made by the retry loop, when lower layers do not
+// modify the context.
+void BM_AttemptCopy(benchmark::State& state) {
+  auto context = MakeContext();
+  auto const deadline = std::chrono::steady_clock::now();
+  CountAllocations(state, [&] {
+    gax::CallContext attempt(context);
+    attempt.SetDeadline(deadline);
+    benchmark::DoNotOptimize(&attempt);
+  });
+}
+BENCHMARK(BM_AttemptCopy);
+
+// The per-attempt copy when a lower layer adds metadata.
+void BM_AttemptCopyWithMetadata(benchmark::State& state) {
+  auto context = MakeContext();
+  CountAllocations(state, [&] {
+    gax::CallContext attempt(context);
+    attempt.AddMetadata("x-attempt", "1");
+    benchmark::DoNotOptimize(&attempt);
+  });
+}
+BENCHMARK(BM_AttemptCopyWithMetadata);
+
+// Attaching the per-client metadata to a new call, one pair at a time...
+void BM_CallMetadataAdded(benchmark::State& state) {
+  CountAllocations(state, [&] {
+    gax::CallContext context(kInfo);
+    context.AddMetadata("x-goog-api-client", "gl-cpp/0.1.0");
+    context.AddMetadata("x-goog-user-project", "my-project");
+    benchmark::DoNotOptimize(&context);
+  });
+}
+BENCHMARK(BM_CallMetadataAdded);
+
+// ... and as a shared MetadataSet.
+void BM_CallMetadataSet(benchmark::State& state) {
+  auto const& metadata = ClientMetadata();
+  CountAllocations(state, [&] {
+    gax::CallContext context(kInfo);
+    context.SetMetadataSet(metadata);
+    benchmark::DoNotOptimize(&context);
+  });
+}
+BENCHMARK(BM_CallMetadataSet);
+
+// A call through the retry loop that succeeds on the first attempt, with the
+// policies copied out of the context.
+void BM_RetryCallFirstAttempt(benchmark::State& state) {
+  auto context = MakeContext();
+  longrunning::GetOperationRequest request;
+  longrunning::Operation response;
+  auto succeed = [](gax::CallContext&, longrunning::GetOperationRequest const&,
+                    longrunning::Operation*) { return gax::Status{}; };
+  CountAllocations(state, [&] {
+    auto status = gax::MakeRetryCall(context, request, &response, succeed,
+                                     context.RetryPolicy(),
+                                     context.BackoffPolicy());
+    benchmark::DoNotOptimize(status.IsOk());
+  });
+}
+BENCHMARK(BM_RetryCallFirstAttempt);
+
+// Same as above, with policies of known types passed by value, as generated
+// retry stubs do for their defaults.
+void BM_RetryCallFirstAttemptValuePolicies(benchmark::State& state) {
+  auto context = MakeContext();
+  longrunning::GetOperationRequest request;
+  longrunning::Operation response;
+  auto succeed = [](gax::CallContext&, longrunning::GetOperationRequest const&,
+                    longrunning::Operation*) { return gax::Status{}; };
+  gax::LimitedErrorCountRetryPolicy<> const retry_policy(
+      3, std::chrono::milliseconds(50));
+  gax::ExponentialBackoffPolicy const backoff_policy(
+      std::chrono::milliseconds(1), std::chrono::milliseconds(10));
+  CountAllocations(state, [&] {
+    auto status = gax::MakeRetryCall(context, request, &response, succeed,
+                                     retry_policy, backoff_policy);
+    benchmark::DoNotOptimize(status.IsOk());
+  });
+}
+BENCHMARK(BM_RetryCallFirstAttemptValuePolicies);
+
+}  // namespace
+
+BENCHMARK_MAIN();
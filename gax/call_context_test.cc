@@ -14,13 +14,20 @@
 
 #include "gax/call_context.h"
 #include "grpcpp/client_context.h"
+#include "grpcpp/server_context.h"
 #include "gax/backoff_policy.h"
+#include "gax/cancellation_token.h"
+#include "gax/retry_budget.h"
 #include "gax/retry_policy.h"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <chrono>
+#include <memory>
 #include <set>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace google {
 namespace gax {
@@ -31,33 +38,41 @@ static_assert(std::is_move_constructible<CallContext>::value,
 static_assert(std::is_copy_constructible<CallContext>::value,
               "CallContext must be copy constructable");
 
+int CountKey(CallContext::MetadataList const& metadata,
+             std::string const& key) {
+  return static_cast<int>(std::count_if(
+      metadata.begin(), metadata.end(),
+      [&key](std::pair<std::string, std::string> const& m) {
+        return m.first == key;
+      }));
+}
+
 TEST(CallContext, Basic) {
   gax::MethodInfo mi{"TestMethod", MethodInfo::RpcType::CLIENT_STREAMING,
                      MethodInfo::Idempotency::IDEMPOTENT};
   gax::CallContext ctx(mi);
-  EXPECT_EQ(ctx.Deadline(), std::chrono::system_clock::time_point::max());
+  EXPECT_EQ(ctx.Deadline(), std::chrono::steady_clock::time_point::max());
 
   auto info = ctx.Info();
   EXPECT_EQ(std::string(info.rpc_name), "TestMethod");
   EXPECT_EQ(info.rpc_type, MethodInfo::RpcType::CLIENT_STREAMING);
   EXPECT_EQ(info.idempotency, MethodInfo::Idempotency::IDEMPOTENT);
 
-  auto now = std::chrono::system_clock::now();
+  auto now = std::chrono::steady_clock::now();
   ctx.SetDeadline(now);
   EXPECT_EQ(ctx.Deadline(), now);
 
   ctx.AddMetadata("testKey", "testVal");
-  auto iter = ctx.Metadata().find("testKey");
-  EXPECT_NE(iter, ctx.Metadata().end());
-  EXPECT_EQ(iter->second, "testVal");
+  ASSERT_EQ(ctx.Metadata().size(), std::size_t(1));
+  EXPECT_EQ(ctx.Metadata()[0].first, "testKey");
+  EXPECT_EQ(ctx.Metadata()[0].second, "testVal");
 
   std::set<std::string> const vals = {"testVal", "testVal2"};
   std::set<std::string> tmp;
   ctx.AddMetadata("testKey", "testVal2");
-  EXPECT_EQ(ctx.Metadata().count("testKey"), std::size_t(2));
-  auto range = ctx.Metadata().equal_range("testKey");
-  for (auto i = range.first; i != range.second; ++i) {
-    tmp.insert(i->second);
+  EXPECT_EQ(CountKey(ctx.Metadata(), "testKey"), 2);
+  for (auto const& m : ctx.Metadata()) {
+    tmp.insert(m.second);
   }
   EXPECT_EQ(tmp, vals);
 
@@ -68,7 +83,8 @@ TEST(CallContext, Basic) {
   grpc::ClientContext client_ctx;
   ctx.PrepareGrpcContext(&client_ctx);
   EXPECT_EQ(policy_invoked, 1);
-  EXPECT_EQ(client_ctx.deadline(), now);
+  // The deadline has already passed, on either clock.
+  EXPECT_LE(client_ctx.deadline(), std::chrono::system_clock::now());
 
   // There isn't a good way to examine ClientContext metadata without it being
   // sent to a server, so take it on faith that it was properly added.
@@ -96,6 +112,164 @@ TEST(CallContext, CopyAndMove) {
   gax::CallContext policy_move(std::move(base));
   EXPECT_TRUE(policy_move.RetryPolicy());
   EXPECT_TRUE(policy_move.BackoffPolicy());
+  // The shipped policies are small enough to be copied inline.
+  EXPECT_TRUE(policy_copy.RetryPolicy().is_inline());
+  EXPECT_TRUE(policy_copy.BackoffPolicy().is_inline());
+}
+
+TEST(CallContext, RetryBudgetIsShared) {
+  gax::MethodInfo mi{"TestMethod", MethodInfo::RpcType::NORMAL_RPC,
+                     MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext base(mi);
+  EXPECT_FALSE(base.RetryBudget());
+
+  auto budget = std::make_shared<gax::TokenBucketRetryBudget<>>(0.1, 0, 10);
+  base.SetRetryBudget(budget);
+  gax::CallContext copy(base);
+  EXPECT_EQ(copy.RetryBudget(), budget);
+  gax::CallContext moved(std::move(copy));
+  EXPECT_EQ(moved.RetryBudget(), budget);
+}
+
+TEST(CallContext, MetadataSetIsShared) {
+  gax::MethodInfo mi{"TestMethod", MethodInfo::RpcType::NORMAL_RPC,
+                     MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext base(mi);
+  EXPECT_FALSE(base.MetadataSet());
+
+  auto metadata = gax::MetadataSet::Create({{"x-goog-api-client", "gl-cpp"}});
+  base.SetMetadataSet(metadata);
+  base.AddMetadata("x-attempt", "1");
+  gax::CallContext copy(base);
+  EXPECT_EQ(copy.MetadataSet(), metadata);
+  // The shared pairs are not part of the per-call metadata.
+  EXPECT_EQ(copy.Metadata().size(), std::size_t(1));
+
+  grpc::ClientContext client_ctx;
+  copy.PrepareGrpcContext(&client_ctx);
+}
+
+TEST(CallContext, MetadataOrder) {
+  gax::MethodInfo mi{"TestMethod", MethodInfo::RpcType::NORMAL_RPC,
+                     MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  context.SetMetadataSet(gax::MetadataSet::Create(
+      {{"x-goog-api-client", "gl-cpp"}, {"x-goog-user-project", "p"}}));
+  context.AddMetadata("x-attempt", "1");
+
+  std::vector<std::string> keys;
+  context.VisitMetadata(
+      "name=shelves/1",
+      [&keys](std::string const& key, std::string const&) {
+        keys.push_back(key);
+      });
+  // The MetadataSet pairs first, then the routing header, then the per-call
+  // pairs, as PrepareGrpcContext() sends them.
+  std::vector<std::string> const expected = {
+      "x-goog-api-client", "x-goog-user-project", "x-goog-request-params",
+      "x-attempt"};
+  EXPECT_EQ(keys, expected);
+
+  keys.clear();
+  context.VisitMetadata(
+      "", [&keys](std::string const& key, std::string const&) {
+        keys.push_back(key);
+      });
+  std::vector<std::string> const without_params = {
+      "x-goog-api-client", "x-goog-user-project", "x-attempt"};
+  EXPECT_EQ(keys, without_params);
+}
+
+TEST(CallContext, CopiesShareSettingsUntilModified) {
+  gax::MethodInfo mi{"TestMethod", MethodInfo::RpcType::NORMAL_RPC,
+                     MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext base(mi);
+  base.AddMetadata("key", "base");
+
+  gax::CallContext copy(base);
+  EXPECT_EQ(&copy.Metadata(), &base.Metadata());
+
+  // Modifying the copy leaves the original alone, and vice versa.
+  copy.AddMetadata("key", "copy");
+  EXPECT_NE(&copy.Metadata(), &base.Metadata());
+  EXPECT_EQ(CountKey(copy.Metadata(), "key"), 2);
+  EXPECT_EQ(CountKey(base.Metadata(), "key"), 1);
+
+  gax::CallContext second(base);
+  base.SetRetryPolicy(
+      gax::LimitedErrorCountRetryPolicy<>(10, std::chrono::milliseconds(2)));
+  EXPECT_TRUE(base.RetryPolicy());
+  EXPECT_TRUE(base.HasRetryPolicy());
+  EXPECT_FALSE(base.HasBackoffPolicy());
+  EXPECT_FALSE(second.RetryPolicy());
+  EXPECT_FALSE(second.HasRetryPolicy());
+  EXPECT_EQ(CountKey(second.Metadata(), "key"), 1);
+}
+
+TEST(CallContext, SetTimeoutOnlyShortensTheDeadline) {
+  gax::MethodInfo mi{"TestMethod", MethodInfo::RpcType::NORMAL_RPC,
+                     MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext ctx(mi);
+  auto const before = std::chrono::steady_clock::now();
+  ctx.SetTimeout(std::chrono::seconds(30));
+  EXPECT_GE(ctx.Deadline(), before + std::chrono::seconds(30));
+  EXPECT_LE(ctx.Deadline(),
+            std::chrono::steady_clock::now() + std::chrono::seconds(30));
+
+  auto const deadline = ctx.Deadline();
+  ctx.SetTimeout(std::chrono::minutes(5));
+  EXPECT_EQ(ctx.Deadline(), deadline);
+  ctx.SetTimeout(std::chrono::seconds(1));
+  EXPECT_LT(ctx.Deadline(), deadline);
+}
+
+TEST(CallContext, ChildInheritsDeadlineAndCancellation) {
+  gax::MethodInfo parent_info{"Parent", MethodInfo::RpcType::NORMAL_RPC,
+                              MethodInfo::Idempotency::IDEMPOTENT};
+  gax::MethodInfo child_info{"Child", MethodInfo::RpcType::NORMAL_RPC,
+                             MethodInfo::Idempotency::NON_IDEMPOTENT};
+  gax::CallContext parent(parent_info);
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  parent.SetDeadline(deadline);
+  auto token = std::make_shared<gax::CancellationToken>();
+  parent.SetCancellationToken(token);
+  parent.AddMetadata("key", "parent");
+  parent.SetRetryPolicy(
+      gax::LimitedErrorCountRetryPolicy<>(3, std::chrono::milliseconds(2)));
+
+  auto child = parent.Child(child_info);
+  EXPECT_EQ(std::string(child.Info().rpc_name), "Child");
+  EXPECT_EQ(child.Deadline(), deadline);
+  EXPECT_EQ(child.CancellationToken(), token);
+  EXPECT_TRUE(child.Metadata().empty());
+  EXPECT_FALSE(child.HasRetryPolicy());
+
+  // The child's own default timeout cannot outlive the parent.
+  child.SetTimeout(std::chrono::seconds(60));
+  EXPECT_EQ(child.Deadline(), deadline);
+}
+
+// Stands in for a server context with a deadline, grpc::ServerContext only
+// gets one from an incoming call.
+struct FakeServerContext {
+  std::chrono::system_clock::time_point deadline() const {
+    return std::chrono::system_clock::now() + std::chrono::seconds(10);
+  }
+};
+
+TEST(CallContext, FromServerContext) {
+  gax::MethodInfo mi{"TestMethod", MethodInfo::RpcType::NORMAL_RPC,
+                     MethodInfo::Idempotency::IDEMPOTENT};
+  grpc::ServerContext no_deadline;
+  EXPECT_EQ(gax::CallContext::FromServerContext(mi, no_deadline).Deadline(),
+            std::chrono::steady_clock::time_point::max());
+
+  auto const before = std::chrono::steady_clock::now();
+  auto context = gax::CallContext::FromServerContext(mi, FakeServerContext{});
+  EXPECT_GT(context.Deadline(), before + std::chrono::seconds(9));
+  EXPECT_LE(context.Deadline(),
+            std::chrono::steady_clock::now() + std::chrono::seconds(10));
 }
 
 }  // namespace gax
@@ -0,0 +1,128 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/cancellation_token.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <utility>
+
+namespace google {
+namespace gax {
+
+void CancellationToken::Cancel() {
+  std::vector<std::weak_ptr<CancellationToken>> children;
+  {
+    // The lock is held while cancelling so that a ClientContext cannot be
+    // unregistered, and destroyed, while TryCancel() is running on it.
+    std::lock_guard<std::mutex> lk(mu_);
+    if (cancelled_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    cancelled_.store(true, std::memory_order_release);
+    for (auto* context : contexts_) {
+      context->TryCancel();
+    }
+    children.swap(children_);
+  }
+  cv_.notify_all();
+  for (auto const& weak : children) {
+    auto child = weak.lock();
+    if (child) {
+      child->Cancel();
+    }
+  }
+}
+
+bool CancellationToken::IsCancelled() const {
+  return cancelled_.load(std::memory_order_acquire);
+}
+
+bool CancellationToken::WaitFor(std::chrono::microseconds timeout) {
+  std::unique_lock<std::mutex> lk(mu_);
+  return cv_.wait_for(lk, timeout, [this] {
+    return cancelled_.load(std::memory_order_relaxed);
+  });
+}
+
+std::shared_ptr<CancellationToken> CancellationToken::MakeChild() {
+  auto child = std::make_shared<CancellationToken>();
+  AddChild(child);
+  return child;
+}
+
+std::shared_ptr<CancellationToken> CancellationToken::AnyOf(
+    std::shared_ptr<CancellationToken> const& a,
+    std::shared_ptr<CancellationToken> const& b) {
+  if (!a) {
+    return b;
+  }
+  if (!b) {
+    return a;
+  }
+  auto child = a->MakeChild();
+  b->AddChild(child);
+  return child;
+}
+
+void CancellationToken::AddChild(
+    std::shared_ptr<CancellationToken> const& child) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (cancelled_.load(std::memory_order_relaxed)) {
+    lk.unlock();
+    child->Cancel();
+    return;
+  }
+  // Drop the children that are gone, so long-lived parents do not grow.
+  children_.erase(
+      std::remove_if(children_.begin(), children_.end(),
+                     [](std::weak_ptr<CancellationToken> const& w) {
+                       return w.expired();
+                     }),
+      children_.end());
+  children_.push_back(child);
+}
+
+void CancellationToken::Register(grpc::ClientContext* context) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (cancelled_.load(std::memory_order_relaxed)) {
+    // gRPC remembers the cancellation if the rpc has not started yet.
+    context->TryCancel();
+    return;
+  }
+  contexts_.push_back(context);
+}
+
+void CancellationToken::Unregister(grpc::ClientContext* context) {
+  std::lock_guard<std::mutex> lk(mu_);
+  contexts_.erase(std::remove(contexts_.begin(), contexts_.end(), context),
+                  contexts_.end());
+}
+
+ScopedGrpcCancellation::ScopedGrpcCancellation(
+    std::shared_ptr<CancellationToken> token, grpc::ClientContext* context)
+    : token_(std::move(token)), context_(context) {
+  if (token_) {
+    token_->Register(context_);
+  }
+}
+
+ScopedGrpcCancellation::~ScopedGrpcCancellation() {
+  if (token_) {
+    token_->Unregister(context_);
+  }
+}
+
+}  // namespace gax
+}  // namespace google
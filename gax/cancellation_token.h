@@ -0,0 +1,139 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_CANCELLATION_TOKEN_H_
+#define GAPIC_GENERATOR_CPP_GAX_CANCELLATION_TOKEN_H_
+
+#include "grpcpp/client_context.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace google {
+namespace gax {
+
+/**
+ * Cancel the rpcs made on behalf of a call from another thread.
+ *
+ * A grpc::ClientContext lives on the stack of the stub that makes the rpc, so
+ * code further up the stub stack cannot reach it to cancel the rpc. Instead, a
+ * CancellationToken is attached to the gax::CallContext, and the stub that
+ * makes the rpc registers its ClientContext with the token for the duration
+ * of the rpc (see ScopedGrpcCancellation). Cancelling the token calls
+ * `TryCancel()` on every registered ClientContext.
+ *
+ * Cancellation is sticky: ClientContexts registered after the token is
+ * cancelled are cancelled right away. Retry loops back off through WaitFor(),
+ * so cancelling the token also ends any pending backoff.
+ *
+ * This class is thread-safe.
+ */
+class CancellationToken {
+ public:
+  CancellationToken() : cancelled_(false) {}
+
+  CancellationToken(CancellationToken const&) = delete;
+  CancellationToken& operator=(CancellationToken const&) = delete;
+
+  /**
+   * Cancel all the rpcs currently registered, and any registered later.
+   */
+  void Cancel();
+
+  /**
+   * @return true if Cancel() has been called.
+   */
+  bool IsCancelled() const;
+
+  /**
+   * Wait for @p timeout, or until the token is cancelled.
+   *
+   * @return true if the token is cancelled.
+   */
+  bool WaitFor(std::chrono::microseconds timeout);
+
+  /**
+   * Create a token that is cancelled with this one, and may also be
+   * cancelled on its own.
+   *
+   * Hedged calls give each attempt a child of the caller's token, so they
+   * can cancel the losing attempts without losing the caller's cancellation.
+   */
+  std::shared_ptr<CancellationToken> MakeChild();
+
+  /**
+   * Return a token that is cancelled when either @p a or @p b is.
+   *
+   * Generated clients use this to combine their client-wide token with the
+   * token of a single call, so that call can be cancelled on its own. Neither
+   * argument is cancelled by the other. If one of them is null the other is
+   * returned.
+   */
+  static std::shared_ptr<CancellationToken> AnyOf(
+      std::shared_ptr<CancellationToken> const& a,
+      std::shared_ptr<CancellationToken> const& b);
+
+ private:
+  friend class ScopedGrpcCancellation;
+  void Register(grpc::ClientContext* context);
+  void Unregister(grpc::ClientContext* context);
+  void AddChild(std::shared_ptr<CancellationToken> const& child);
+
+  // Guards the registered contexts and the children. The flag is only set
+  // with it held, but is read without it, so polling IsCancelled() is cheap.
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::atomic<bool> cancelled_;
+  std::vector<grpc::ClientContext*> contexts_;
+  std::vector<std::weak_ptr<CancellationToken>> children_;
+};
+
+/**
+ * Register a grpc::ClientContext with a CancellationToken for its lifetime.
+ *
+ * Stubs that make rpcs create one of these right after the ClientContext, so
+ * that the registration ends before the ClientContext is destroyed:
+ *
+ * @code
+ * grpc::ClientContext grpc_ctx;
+ * context.PrepareGrpcContext(&grpc_ctx);
+ * gax::ScopedGrpcCancellation cancellation(context.CancellationToken(),
+ *                                          &grpc_ctx);
+ * return gax::GrpcStatusToGaxStatus(
+ *     grpc_stub_->GetFoo(&grpc_ctx, request, response));
+ * @endcode
+ *
+ * A null token is allowed and registers nothing.
+ */
+class ScopedGrpcCancellation {
+ public:
+  ScopedGrpcCancellation(std::shared_ptr<CancellationToken> token,
+                         grpc::ClientContext* context);
+  ~ScopedGrpcCancellation();
+
+  ScopedGrpcCancellation(ScopedGrpcCancellation const&) = delete;
+  ScopedGrpcCancellation& operator=(ScopedGrpcCancellation const&) = delete;
+
+ private:
+  std::shared_ptr<CancellationToken> token_;
+  grpc::ClientContext* context_;
+};
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_CANCELLATION_TOKEN_H_
@@ -0,0 +1,145 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/cancellation_token.h"
+#include "grpcpp/client_context.h"
+#include "gax/call_context.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace {
+using namespace ::google;
+
+TEST(CancellationToken, Basic) {
+  gax::CancellationToken token;
+  EXPECT_FALSE(token.IsCancelled());
+  token.Cancel();
+  EXPECT_TRUE(token.IsCancelled());
+  // Cancelling twice is harmless.
+  token.Cancel();
+  EXPECT_TRUE(token.IsCancelled());
+}
+
+TEST(CancellationToken, ScopedRegistration) {
+  auto token = std::make_shared<gax::CancellationToken>();
+  {
+    grpc::ClientContext context;
+    gax::ScopedGrpcCancellation registration(token, &context);
+    token->Cancel();
+  }
+  // The context was unregistered before it was destroyed, and contexts
+  // registered after the cancellation are cancelled right away.
+  grpc::ClientContext late;
+  gax::ScopedGrpcCancellation registration(token, &late);
+  EXPECT_TRUE(token->IsCancelled());
+}
+
+TEST(CancellationToken, WaitFor) {
+  gax::CancellationToken token;
+  EXPECT_FALSE(token.WaitFor(std::chrono::milliseconds(1)));
+
+  std::thread canceller([&token] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    token.Cancel();
+  });
+  auto const start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(token.WaitFor(std::chrono::minutes(1)));
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::seconds(30));
+  canceller.join();
+  // Once cancelled the token does not wait at all.
+  EXPECT_TRUE(token.WaitFor(std::chrono::minutes(1)));
+}
+
+TEST(CancellationToken, Children) {
+  auto parent = std::make_shared<gax::CancellationToken>();
+  auto child = parent->MakeChild();
+  auto sibling = parent->MakeChild();
+
+  // Cancelling a child does not affect the parent or its siblings.
+  sibling->Cancel();
+  EXPECT_FALSE(parent->IsCancelled());
+  EXPECT_FALSE(child->IsCancelled());
+
+  parent->Cancel();
+  EXPECT_TRUE(child->IsCancelled());
+  EXPECT_TRUE(parent->MakeChild()->IsCancelled());
+}
+
+TEST(CancellationToken, AnyOf) {
+  auto client = std::make_shared<gax::CancellationToken>();
+  auto first = std::make_shared<gax::CancellationToken>();
+  auto second = std::make_shared<gax::CancellationToken>();
+  auto first_call = gax::CancellationToken::AnyOf(client, first);
+  auto second_call = gax::CancellationToken::AnyOf(client, second);
+
+  // One call of a fan-out is cancelled without the others, or the client.
+  first->Cancel();
+  EXPECT_TRUE(first_call->IsCancelled());
+  EXPECT_FALSE(second_call->IsCancelled());
+  EXPECT_FALSE(client->IsCancelled());
+  EXPECT_FALSE(second->IsCancelled());
+
+  // Cancelling the client cancels every call, but not the callers' tokens.
+  client->Cancel();
+  EXPECT_TRUE(second_call->IsCancelled());
+  EXPECT_FALSE(second->IsCancelled());
+
+  // Already cancelled tokens cancel the combined token right away.
+  auto late = gax::CancellationToken::AnyOf(
+      std::make_shared<gax::CancellationToken>(), first);
+  EXPECT_TRUE(late->IsCancelled());
+}
+
+TEST(CancellationToken, AnyOfNull) {
+  auto token = std::make_shared<gax::CancellationToken>();
+  EXPECT_EQ(gax::CancellationToken::AnyOf(token, nullptr), token);
+  EXPECT_EQ(gax::CancellationToken::AnyOf(nullptr, token), token);
+  EXPECT_FALSE(gax::CancellationToken::AnyOf(nullptr, nullptr));
+}
+
+TEST(CancellationToken, IsCancelledAcrossThreads) {
+  auto token = std::make_shared<gax::CancellationToken>();
+  std::thread poller([token] {
+    while (!token->IsCancelled()) {
+      std::this_thread::yield();
+    }
+  });
+  token->Cancel();
+  poller.join();
+  EXPECT_TRUE(token->IsCancelled());
+}
+
+TEST(CancellationToken, NullToken) {
+  grpc::ClientContext context;
+  gax::ScopedGrpcCancellation registration(nullptr, &context);
+}
+
+TEST(CancellationToken, SharedByCallContextCopies) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  EXPECT_FALSE(context.CancellationToken());
+
+  auto token = std::make_shared<gax::CancellationToken>();
+  context.SetCancellationToken(token);
+  gax::CallContext copy(context);
+  EXPECT_EQ(copy.CancellationToken(), token);
+  copy.CancellationToken()->Cancel();
+  EXPECT_TRUE(context.CancellationToken()->IsCancelled());
+}
+
+}  // namespace
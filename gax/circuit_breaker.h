@@ -0,0 +1,260 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_CIRCUIT_BREAKER_H_
+#define GAPIC_GENERATOR_CPP_GAX_CIRCUIT_BREAKER_H_
+
+#include "gax/retry_policy.h"
+#include "gax/status.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace google {
+namespace gax {
+
+/**
+ * Configure when a circuit breaker trips, and how it recovers.
+ *
+ * @par Example
+ * @code
+ * // Trip when at least half of the calls in the last 10s failed, provided
+ * // there were at least 20 calls. Stay open for 5s, then let 3 probes through.
+ * gax::CircuitBreakerPolicy policy(0.5, 20, std::chrono::seconds(10),
+ *                                  std::chrono::seconds(5), 3);
+ * @endcode
+ */
+class CircuitBreakerPolicy {
+ public:
+  /**
+   * @param failure_rate_threshold trip when the fraction of failed calls in
+   *     the rolling window reaches this value.
+   * @param minimum_calls do not trip unless the rolling window has at least
+   *     this many calls, so a handful of failures cannot trip the breaker.
+   * @param window the length of the rolling window.
+   * @param open_duration how long the breaker fails fast before probing.
+   * @param half_open_probes the number of probe calls allowed through after
+   *     @p open_duration. The breaker closes once they all succeed.
+   */
+  template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+  CircuitBreakerPolicy(double failure_rate_threshold, int minimum_calls,
+                       std::chrono::duration<Rep1, Period1> window,
+                       std::chrono::duration<Rep2, Period2> open_duration,
+                       int half_open_probes)
+      : failure_rate_threshold_(failure_rate_threshold),
+        minimum_calls_(minimum_calls),
+        window_(std::chrono::duration_cast<std::chrono::milliseconds>(window)),
+        open_duration_(std::chrono::duration_cast<std::chrono::milliseconds>(
+            open_duration)),
+        half_open_probes_(half_open_probes) {}
+
+  double failure_rate_threshold() const { return failure_rate_threshold_; }
+  int minimum_calls() const { return minimum_calls_; }
+  std::chrono::milliseconds window() const { return window_; }
+  std::chrono::milliseconds open_duration() const { return open_duration_; }
+  int half_open_probes() const { return half_open_probes_; }
+
+ private:
+  double failure_rate_threshold_;
+  int minimum_calls_;
+  std::chrono::milliseconds window_;
+  std::chrono::milliseconds open_duration_;
+  int half_open_probes_;
+};
+
+/**
+ * Fail fast while a backend is down.
+ *
+ * The breaker tracks the failure rate of the calls to a single method over a
+ * rolling window. Failures are the statuses that the retry policies consider
+ * transient, i.e. the ones that point at the backend rather than the request.
+ *
+ * - CLOSED: calls go through. If the failure rate reaches the threshold the
+ *   breaker trips open.
+ * - OPEN: calls fail immediately with `kUnavailable`, without reaching the
+ *   backend. After the open duration the breaker becomes half-open.
+ * - HALF_OPEN: a few probe calls go through, the rest fail fast. If all the
+ *   probes succeed the breaker closes, if any fails it opens again.
+ *
+ * This class is thread-safe.
+ */
+template <typename Clock = DefaultClock>
+class CircuitBreaker {
+ public:
+  enum class State { kClosed, kOpen, kHalfOpen };
+
+  CircuitBreaker(CircuitBreakerPolicy policy, std::string name,
+                 Clock c = Clock{})
+      : c_(std::move(c)),
+        policy_(std::move(policy)),
+        name_(std::move(name)),
+        bucket_width_(std::max(policy_.window() / static_cast<int>(kBuckets),
+                               std::chrono::milliseconds(1))),
+        state_(State::kClosed),
+        probes_started_(0),
+        probes_succeeded_(0) {
+    ResetWindow();
+  }
+
+  CircuitBreaker(CircuitBreaker const&) = delete;
+  CircuitBreaker& operator=(CircuitBreaker const&) = delete;
+
+  /**
+   * Invoke @p call unless the breaker is open, and record its result.
+   *
+   * @return the status returned by @p call, or `kUnavailable` if the breaker
+   *     rejected the call.
+   */
+  template <typename Functor>
+  gax::Status Call(Functor&& call) {
+    bool probe = false;
+    gax::Status admitted = Admit(probe);
+    if (!admitted.IsOk()) {
+      return admitted;
+    }
+    gax::Status status = call();
+    OnResult(status, probe);
+    return status;
+  }
+
+  State state() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return state_;
+  }
+
+ private:
+  // The rolling window is split in this many buckets, older buckets are
+  // discarded as time moves on.
+  static constexpr std::size_t kBuckets = 10;
+
+  struct Bucket {
+    std::int64_t index;
+    int calls;
+    int failures;
+  };
+
+  gax::Status Admit(bool& probe) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (state_ == State::kClosed) {
+      return gax::Status{};
+    }
+    if (state_ == State::kOpen) {
+      if (c_.now() < opened_at_ + policy_.open_duration()) {
+        return Rejected();
+      }
+      state_ = State::kHalfOpen;
+      probes_started_ = 0;
+      probes_succeeded_ = 0;
+    }
+    if (probes_started_ >= policy_.half_open_probes()) {
+      return Rejected();
+    }
+    ++probes_started_;
+    probe = true;
+    return gax::Status{};
+  }
+
+  void OnResult(gax::Status const& status, bool probe) {
+    bool const failed = status.IsTransientFailure();
+    std::lock_guard<std::mutex> lk(mu_);
+    auto const now = c_.now();
+    if (probe) {
+      if (state_ != State::kHalfOpen) {
+        return;
+      }
+      if (failed) {
+        Open(now);
+      } else if (++probes_succeeded_ >= policy_.half_open_probes()) {
+        state_ = State::kClosed;
+        ResetWindow();
+      }
+      return;
+    }
+    // Calls admitted while closed may complete after the breaker tripped,
+    // they no longer say anything about the current state.
+    if (state_ != State::kClosed) {
+      return;
+    }
+
+    auto& bucket = CurrentBucket(now);
+    ++bucket.calls;
+    if (failed) {
+      ++bucket.failures;
+    }
+    int calls = 0;
+    int failures = 0;
+    auto const current = bucket.index;
+    for (auto const& b : buckets_) {
+      if (current - b.index < static_cast<std::int64_t>(kBuckets)) {
+        calls += b.calls;
+        failures += b.failures;
+      }
+    }
+    if (failures > 0 && calls >= policy_.minimum_calls() &&
+        failures >= policy_.failure_rate_threshold() * calls) {
+      Open(now);
+    }
+  }
+
+  Bucket& CurrentBucket(std::chrono::steady_clock::time_point now) {
+    auto const index = static_cast<std::int64_t>(
+        now.time_since_epoch() / bucket_width_);
+    auto& bucket = buckets_[static_cast<std::size_t>(index) % kBuckets];
+    if (bucket.index != index) {
+      bucket = Bucket{index, 0, 0};
+    }
+    return bucket;
+  }
+
+  void Open(std::chrono::steady_clock::time_point now) {
+    state_ = State::kOpen;
+    opened_at_ = now;
+  }
+
+  void ResetWindow() {
+    // No bucket index is this far in the past, so they all start out stale.
+    buckets_.fill(Bucket{std::numeric_limits<std::int64_t>::min() / 2, 0, 0});
+  }
+
+  gax::Status Rejected() const {
+    return gax::Status(gax::StatusCode::kUnavailable,
+                       "Circuit breaker for " + name_ +
+                           " is open: failing fast while the service recovers");
+  }
+
+  Clock c_;
+  CircuitBreakerPolicy const policy_;
+  std::string const name_;
+  std::chrono::milliseconds const bucket_width_;
+
+  mutable std::mutex mu_;
+  State state_;
+  std::chrono::steady_clock::time_point opened_at_;
+  int probes_started_;
+  int probes_succeeded_;
+  std::array<Bucket, kBuckets> buckets_;
+};
+
+template <typename Clock>
+constexpr std::size_t CircuitBreaker<Clock>::kBuckets;
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_CIRCUIT_BREAKER_H_
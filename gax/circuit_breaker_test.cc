@@ -0,0 +1,142 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/circuit_breaker.h"
+#include "gax/internal/test_clock.h"
+#include "gax/status.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+
+namespace {
+using namespace ::google;
+using ms = std::chrono::milliseconds;
+using Breaker = gax::CircuitBreaker<gax::internal::TestClock>;
+
+// Trip at 50% failures over a 1s window with at least 4 calls, stay open for
+// 100ms, then send 2 probes.
+gax::CircuitBreakerPolicy TestPolicy() {
+  return gax::CircuitBreakerPolicy(0.5, 4, ms(1000), ms(100), 2);
+}
+
+gax::Status Succeed() { return gax::Status{}; }
+gax::Status Fail() {
+  return gax::Status(gax::StatusCode::kUnavailable, "backend down");
+}
+
+TEST(CircuitBreaker, TripsOnFailureRate) {
+  std::chrono::steady_clock::time_point now_point;
+  Breaker tested(TestPolicy(), "TestMethod",
+                 gax::internal::TestClock(now_point));
+
+  EXPECT_TRUE(tested.Call(Succeed).IsOk());
+  EXPECT_TRUE(tested.Call(Succeed).IsOk());
+  EXPECT_FALSE(tested.Call(Fail).IsOk());
+  EXPECT_EQ(tested.state(), Breaker::State::kClosed);
+  EXPECT_FALSE(tested.Call(Fail).IsOk());
+  EXPECT_EQ(tested.state(), Breaker::State::kOpen);
+
+  int invoked = 0;
+  auto counted = [&invoked] {
+    ++invoked;
+    return gax::Status{};
+  };
+  auto status = tested.Call(counted);
+  EXPECT_EQ(status.code(), gax::StatusCode::kUnavailable);
+  EXPECT_NE(status.message().find("TestMethod"), std::string::npos);
+  EXPECT_EQ(invoked, 0);
+}
+
+TEST(CircuitBreaker, MinimumCalls) {
+  std::chrono::steady_clock::time_point now_point;
+  Breaker tested(TestPolicy(), "TestMethod",
+                 gax::internal::TestClock(now_point));
+  for (int i = 0; i != 3; ++i) {
+    tested.Call(Fail);
+  }
+  EXPECT_EQ(tested.state(), Breaker::State::kClosed);
+}
+
+TEST(CircuitBreaker, PermanentErrorsDoNotTrip) {
+  std::chrono::steady_clock::time_point now_point;
+  Breaker tested(TestPolicy(), "TestMethod",
+                 gax::internal::TestClock(now_point));
+  for (int i = 0; i != 10; ++i) {
+    tested.Call([] {
+      return gax::Status(gax::StatusCode::kNotFound, "no such book");
+    });
+  }
+  EXPECT_EQ(tested.state(), Breaker::State::kClosed);
+}
+
+TEST(CircuitBreaker, OldFailuresExpire) {
+  std::chrono::steady_clock::time_point now_point;
+  Breaker tested(TestPolicy(), "TestMethod",
+                 gax::internal::TestClock(now_point));
+  tested.Call(Fail);
+  tested.Call(Fail);
+  tested.Call(Fail);
+  // The failures fall out of the rolling window.
+  now_point += ms(1500);
+  tested.Call(Fail);
+  tested.Call(Succeed);
+  tested.Call(Succeed);
+  tested.Call(Succeed);
+  EXPECT_EQ(tested.state(), Breaker::State::kClosed);
+}
+
+TEST(CircuitBreaker, HalfOpenProbesClose) {
+  std::chrono::steady_clock::time_point now_point;
+  Breaker tested(TestPolicy(), "TestMethod",
+                 gax::internal::TestClock(now_point));
+  for (int i = 0; i != 4; ++i) {
+    tested.Call(Fail);
+  }
+  ASSERT_EQ(tested.state(), Breaker::State::kOpen);
+
+  now_point += ms(100);
+  // Only two probes are let through while they are in flight.
+  int rejected = -1;
+  auto status = tested.Call([&tested, &rejected] {
+    return tested.Call([&tested, &rejected] {
+      rejected = tested.Call(Succeed).code() == gax::StatusCode::kUnavailable;
+      return gax::Status{};
+    });
+  });
+  EXPECT_TRUE(status.IsOk());
+  EXPECT_EQ(rejected, 1);
+  EXPECT_EQ(tested.state(), Breaker::State::kClosed);
+  EXPECT_TRUE(tested.Call(Succeed).IsOk());
+}
+
+TEST(CircuitBreaker, HalfOpenProbeFailureReopens) {
+  std::chrono::steady_clock::time_point now_point;
+  Breaker tested(TestPolicy(), "TestMethod",
+                 gax::internal::TestClock(now_point));
+  for (int i = 0; i != 4; ++i) {
+    tested.Call(Fail);
+  }
+  now_point += ms(100);
+  EXPECT_FALSE(tested.Call(Fail).IsOk());
+  EXPECT_EQ(tested.state(), Breaker::State::kOpen);
+
+  // The open period restarts from the failed probe.
+  now_point += ms(50);
+  EXPECT_EQ(tested.Call(Succeed).code(), gax::StatusCode::kUnavailable);
+  now_point += ms(50);
+  EXPECT_TRUE(tested.Call(Succeed).IsOk());
+  EXPECT_EQ(tested.state(), Breaker::State::kHalfOpen);
+}
+
+}  // namespace
@@ -0,0 +1,75 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/clock.h"
+#include <time.h>
+
+namespace google {
+namespace gax {
+
+std::chrono::steady_clock::time_point CoarseClock::now() const {
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+  // steady_clock reads CLOCK_MONOTONIC on Linux, the coarse clock has the
+  // same epoch.
+  timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) == 0) {
+    return std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::seconds(ts.tv_sec) +
+            std::chrono::nanoseconds(ts.tv_nsec)));
+  }
+#endif  // defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+  return std::chrono::steady_clock::now();
+}
+
+namespace internal {
+
+gpr_timespec ToGrpcDeadline(std::chrono::steady_clock::time_point deadline) {
+  if (deadline == std::chrono::steady_clock::time_point::max()) {
+    return gpr_inf_future(GPR_CLOCK_MONOTONIC);
+  }
+  auto const now = std::chrono::steady_clock::now();
+  auto const grpc_now = gpr_now(GPR_CLOCK_MONOTONIC);
+  if (deadline <= now) {
+    return grpc_now;
+  }
+  auto const remaining =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now);
+  // gpr_time_add() saturates to the infinite future.
+  return gpr_time_add(grpc_now,
+                      gpr_time_from_nanos(remaining.count(), GPR_TIMESPAN));
+}
+
+std::chrono::steady_clock::time_point ToSteadyDeadline(
+    std::chrono::system_clock::time_point deadline) {
+  if (deadline == std::chrono::system_clock::time_point::max()) {
+    return std::chrono::steady_clock::time_point::max();
+  }
+  auto const now = std::chrono::system_clock::now();
+  auto const steady_now = std::chrono::steady_clock::now();
+  if (deadline <= now) {
+    return steady_now;
+  }
+  auto const remaining =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          deadline - now);
+  if (remaining >= std::chrono::steady_clock::time_point::max() - steady_now) {
+    return std::chrono::steady_clock::time_point::max();
+  }
+  return steady_now + remaining;
+}
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
@@ -0,0 +1,81 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_CLOCK_H_
+#define GAPIC_GENERATOR_CPP_GAX_CLOCK_H_
+
+#include "grpc/support/time.h"
+#include <chrono>
+
+namespace google {
+namespace gax {
+
+/**
+ * The clock used for deadlines and policy bookkeeping.
+ *
+ * All the time points in gax come from `std::chrono::steady_clock`: unlike
+ * the wall clock it never jumps, so adjustments to the system time cannot
+ * expire a deadline early or stretch a retry loop.
+ *
+ * The policies and the retry loop take the clock as a template parameter,
+ * any class with a `now()` member function returning a
+ * `std::chrono::steady_clock::time_point` can be used instead.
+ */
+class DefaultClock {
+ public:
+  std::chrono::steady_clock::time_point now() const {
+    return std::chrono::steady_clock::now();
+  }
+};
+
+/**
+ * A steady clock that trades resolution for a cheaper `now()`.
+ *
+ * On Linux this reads the time the kernel cached at its last tick, which
+ * costs a few nanoseconds and is typically 1 to 4 milliseconds behind. That
+ * is plenty for retry deadlines and sliding windows measured in seconds, and
+ * saves a full clock read per call on very high QPS paths. On other
+ * platforms it is the same as DefaultClock.
+ *
+ * @par Example
+ * @code
+ * gax::LimitedDurationRetryPolicy<gax::CoarseClock> policy(
+ *     std::chrono::seconds(30), std::chrono::seconds(5));
+ * @endcode
+ */
+class CoarseClock {
+ public:
+  std::chrono::steady_clock::time_point now() const;
+};
+
+namespace internal {
+
+/**
+ * Convert a deadline to the form grpc::ClientContext::set_deadline() takes.
+ *
+ * gRPC only converts wall-clock time points, so the remaining time is
+ * measured against gRPC's own monotonic clock instead. The maximum time
+ * point means no deadline.
+ */
+gpr_timespec ToGrpcDeadline(std::chrono::steady_clock::time_point deadline);
+
+/// Convert a wall-clock deadline to a steady clock one.
+std::chrono::steady_clock::time_point ToSteadyDeadline(
+    std::chrono::system_clock::time_point deadline);
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_CLOCK_H_
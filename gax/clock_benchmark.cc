@@ -0,0 +1,44 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gax/clock.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+
+namespace {
+using namespace ::google;
+
+// The policies and the retry loop read the clock at least once per attempt.
+template <typename Clock>
+void BM_Now(benchmark::State& state) {
+  Clock clock;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(clock.now());
+  }
+}
+BENCHMARK_TEMPLATE(BM_Now, gax::DefaultClock);
+BENCHMARK_TEMPLATE(BM_Now, gax::CoarseClock);
+
+// Converting the attempt deadline for grpc::ClientContext::set_deadline().
+void BM_ToGrpcDeadline(benchmark::State& state) {
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(gax::internal::ToGrpcDeadline(deadline));
+  }
+}
+BENCHMARK(BM_ToGrpcDeadline);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gax/clock.h"
+#include "grpcpp/client_context.h"
+#include "gax/call_context.h"
+#include <gtest/gtest.h>
+#include <chrono>
+
+namespace {
+using namespace ::google;
+using std::chrono::steady_clock;
+
+// The remaining time until a gRPC deadline, measured on gRPC's clock.
+std::chrono::milliseconds Remaining(gpr_timespec deadline) {
+  auto remaining = gpr_time_sub(
+      gpr_convert_clock_type(deadline, GPR_CLOCK_MONOTONIC),
+      gpr_now(GPR_CLOCK_MONOTONIC));
+  return std::chrono::milliseconds(gpr_time_to_millis(remaining));
+}
+
+TEST(Clock, DefaultClockIsSteady) {
+  gax::DefaultClock clock;
+  auto const first = clock.now();
+  auto const second = clock.now();
+  EXPECT_LE(first, second);
+}
+
+TEST(Clock, CoarseClockTracksSteadyClock) {
+  gax::CoarseClock coarse;
+  auto const before = steady_clock::now();
+  auto const now = coarse.now();
+  auto const after = steady_clock::now();
+  // The coarse clock lags by up to one kernel tick.
+  EXPECT_GE(now, before - std::chrono::milliseconds(50));
+  EXPECT_LE(now, after);
+}
+
+TEST(Clock, ToGrpcDeadline) {
+  auto infinite = gax::internal::ToGrpcDeadline(steady_clock::time_point::max());
+  EXPECT_EQ(gpr_time_cmp(infinite, gpr_inf_future(infinite.clock_type)), 0);
+
+  auto deadline = gax::internal::ToGrpcDeadline(steady_clock::now() +
+                                                std::chrono::seconds(10));
+  EXPECT_EQ(deadline.clock_type, GPR_CLOCK_MONOTONIC);
+  EXPECT_GT(Remaining(deadline), std::chrono::seconds(9));
+  EXPECT_LE(Remaining(deadline), std::chrono::seconds(10));
+
+  auto expired = gax::internal::ToGrpcDeadline(steady_clock::time_point::min());
+  EXPECT_LE(Remaining(expired), std::chrono::milliseconds(0));
+}
+
+TEST(Clock, ToSteadyDeadline) {
+  EXPECT_EQ(gax::internal::ToSteadyDeadline(
+                std::chrono::system_clock::time_point::max()),
+            steady_clock::time_point::max());
+
+  auto const before = steady_clock::now();
+  auto deadline = gax::internal::ToSteadyDeadline(
+      std::chrono::system_clock::now() + std::chrono::seconds(10));
+  EXPECT_GE(deadline, before + std::chrono::seconds(10));
+  EXPECT_LE(deadline, steady_clock::now() + std::chrono::seconds(10));
+
+  auto expired = gax::internal::ToSteadyDeadline(
+      std::chrono::system_clock::time_point::min());
+  EXPECT_LE(expired, steady_clock::now());
+}
+
+TEST(Clock, GrpcContextDeadline) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  context.SetDeadline(std::chrono::system_clock::now() +
+                      std::chrono::seconds(10));
+  EXPECT_GT(context.Deadline(), steady_clock::now() + std::chrono::seconds(9));
+
+  grpc::ClientContext grpc_context;
+  context.PrepareGrpcContext(&grpc_context);
+  auto const remaining =
+      grpc_context.deadline() - std::chrono::system_clock::now();
+  EXPECT_GT(remaining, std::chrono::seconds(9));
+  EXPECT_LE(remaining, std::chrono::seconds(10));
+}
+
+}  // namespace
@@ -0,0 +1,125 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/hedging.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace google {
+namespace gax {
+
+constexpr int Hedger::kMaxHedgeBurst;
+constexpr std::size_t Hedger::kLatencySamples;
+constexpr std::size_t Hedger::kMinLatencySamples;
+constexpr std::int64_t Hedger::kRecomputeInterval;
+
+HedgingStats::Counters HedgingStats::ForMethod(
+    std::string const& rpc_name) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = counters_.find(rpc_name);
+  if (it == counters_.end()) {
+    return Counters{0, 0, 0};
+  }
+  return Counters{it->second->calls.load(), it->second->hedges_sent.load(),
+                  it->second->hedges_won.load()};
+}
+
+HedgingStats::AtomicCounters& HedgingStats::Register(
+    std::string const& rpc_name) {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto& counters = counters_[rpc_name];
+  if (!counters) {
+    counters.reset(new AtomicCounters);
+  }
+  return *counters;
+}
+
+Hedger::Hedger(HedgingPolicy policy, std::shared_ptr<gax::TimerQueue> timers,
+               std::shared_ptr<gax::ThreadPool> executor,
+               std::shared_ptr<HedgingStats> stats,
+               std::string const& rpc_name)
+    : policy_(std::move(policy)),
+      timers_(std::move(timers)),
+      executor_(std::move(executor)),
+      stats_(stats ? std::move(stats) : std::make_shared<HedgingStats>()),
+      counters_(stats_->Register(rpc_name)),
+      budget_(policy_.max_extra_load(), 0, kMaxHedgeBurst),
+      percentile_delay_us_(-1),
+      next_sample_(0),
+      recorded_(0) {}
+
+std::chrono::microseconds Hedger::HedgeDelay() const {
+  if (policy_.latency_percentile() > 0) {
+    auto delay = percentile_delay_us_.load(std::memory_order_relaxed);
+    if (delay >= 0) {
+      return std::chrono::microseconds(delay);
+    }
+  }
+  return policy_.hedging_delay();
+}
+
+void Hedger::OnCall() {
+  counters_.calls.fetch_add(1, std::memory_order_relaxed);
+  // Every call earns `max_extra_load` backup attempts.
+  budget_.OnSuccess();
+}
+
+bool Hedger::TryStartHedge(std::function<void()> attempt) {
+  // A rejected attempt still spends its share of the load budget: the
+  // executor is saturated, this is not the time for more backups.
+  if (!budget_.TryAcquireRetry()) {
+    return false;
+  }
+  // Count the attempt first, it may complete before TrySubmit() returns.
+  counters_.hedges_sent.fetch_add(1, std::memory_order_relaxed);
+  if (!executor_->TrySubmit(std::move(attempt))) {
+    counters_.hedges_sent.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void Hedger::OnHedgeWon() {
+  counters_.hedges_won.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Hedger::RecordLatency(std::chrono::microseconds latency) {
+  if (policy_.latency_percentile() <= 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(mu_);
+  if (samples_.size() < kLatencySamples) {
+    samples_.push_back(latency.count());
+  } else {
+    samples_[next_sample_] = latency.count();
+    next_sample_ = (next_sample_ + 1) % kLatencySamples;
+  }
+  if (++recorded_ % kRecomputeInterval != 0 ||
+      samples_.size() < kMinLatencySamples) {
+    return;
+  }
+
+  auto sorted = samples_;
+  auto rank = static_cast<std::size_t>(
+      std::ceil(policy_.latency_percentile() / 100.0 * sorted.size()));
+  auto nth = sorted.begin() + (std::min(std::max<std::size_t>(rank, 1),
+                                        sorted.size()) -
+                               1);
+  std::nth_element(sorted.begin(), nth, sorted.end());
+  percentile_delay_us_.store(*nth, std::memory_order_relaxed);
+}
+
+}  // namespace gax
+}  // namespace google
@@ -0,0 +1,414 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_HEDGING_H_
+#define GAPIC_GENERATOR_CPP_GAX_HEDGING_H_
+
+#include "gax/call_context.h"
+#include "gax/cancellation_token.h"
+#include "gax/internal/invoke_result.h"
+#include "gax/retry_budget.h"
+#include "gax/status.h"
+#include "gax/thread_pool.h"
+#include "gax/timer_queue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace gax {
+
+/**
+ * Configure when, and how often, idempotent calls are hedged.
+ *
+ * A hedged call sends a backup attempt if the first attempt has not completed
+ * after the hedging delay, and uses whichever attempt succeeds first. This cuts
+ * tail latency at the cost of extra load, so the number of backup attempts is
+ * capped both per call and across calls.
+ *
+ * @par Example
+ * @code
+ * // Hedge after 20ms, at most once per call, adding at most 5% extra load.
+ * gax::HedgingPolicy policy(std::chrono::milliseconds(20), 1, 0.05);
+ * // Once enough calls have been observed, hedge at the 95th percentile.
+ * policy.UseLatencyPercentile(95);
+ * @endcode
+ */
+class HedgingPolicy {
+ public:
+  /**
+   * @param hedging_delay how long to wait before sending each backup attempt.
+   * @param max_hedges the maximum number of backup attempts per call.
+   * @param max_extra_load the maximum number of backup attempts per call,
+   *     averaged over all the calls made through the stub, e.g. 0.05 allows 5%
+   *     extra load.
+   */
+  template <typename Rep, typename Period>
+  HedgingPolicy(std::chrono::duration<Rep, Period> hedging_delay,
+                int max_hedges, double max_extra_load)
+      : hedging_delay_(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                hedging_delay)),
+        max_hedges_(max_hedges),
+        max_extra_load_(max_extra_load),
+        latency_percentile_(0) {}
+
+  /**
+   * Hedge at a percentile of the observed latency instead of a fixed delay.
+   *
+   * The fixed delay is used until enough successful calls have been observed.
+   *
+   * @param percentile a value in (0, 100], e.g. 95 for the 95th percentile.
+   */
+  HedgingPolicy& UseLatencyPercentile(double percentile) {
+    latency_percentile_ = percentile;
+    return *this;
+  }
+
+  std::chrono::microseconds hedging_delay() const { return hedging_delay_; }
+  int max_hedges() const { return max_hedges_; }
+  double max_extra_load() const { return max_extra_load_; }
+  double latency_percentile() const { return latency_percentile_; }
+
+ private:
+  std::chrono::microseconds hedging_delay_;
+  int max_hedges_;
+  double max_extra_load_;
+  double latency_percentile_;
+};
+
+/**
+ * Per-method counters for hedged calls.
+ *
+ * A single HedgingStats object may be shared by several hedging stubs. The
+ * counters are updated without locks and can be read at any time.
+ */
+class HedgingStats {
+ public:
+  struct Counters {
+    /// The number of hedged calls started.
+    std::int64_t calls;
+    /// The number of backup attempts sent.
+    std::int64_t hedges_sent;
+    /// The number of calls that used the response of a backup attempt.
+    std::int64_t hedges_won;
+  };
+
+  /**
+   * @return a snapshot of the counters for @p rpc_name, all zero if the
+   *     method has not been hedged.
+   */
+  Counters ForMethod(std::string const& rpc_name) const;
+
+ private:
+  friend class Hedger;
+  struct AtomicCounters {
+    std::atomic<std::int64_t> calls{0};
+    std::atomic<std::int64_t> hedges_sent{0};
+    std::atomic<std::int64_t> hedges_won{0};
+  };
+
+  AtomicCounters& Register(std::string const& rpc_name);
+
+  mutable std::mutex mu_;
+  std::map<std::string, std::unique_ptr<AtomicCounters>> counters_;
+};
+
+/**
+ * The shared state used to hedge the calls to a single method.
+ *
+ * Hedging stubs create one Hedger per method. It decides how long to wait
+ * before each backup attempt, enforces the load cap, starts the backup
+ * attempts on the shared executor, and keeps the counters.
+ *
+ * This class is thread-safe.
+ */
+class Hedger {
+ public:
+  /// The maximum number of backup attempts sent in a burst, before the
+  /// `max_extra_load` of the policy is earned by regular calls.
+  static constexpr int kMaxHedgeBurst = 10;
+
+  /**
+   * @param policy when, and how often, calls are hedged.
+   * @param timers schedules the backup attempts, usually shared by all the
+   *     stubs of a client.
+   * @param executor runs the backup attempts. Its size bounds the number of
+   *     threads hedging can use, however many calls are hedged. Backup
+   *     attempts it rejects are not sent.
+   * @param stats receives the counters, if null the counters are kept private.
+   * @param rpc_name the method name, used to key the counters.
+   */
+  Hedger(HedgingPolicy policy, std::shared_ptr<gax::TimerQueue> timers,
+         std::shared_ptr<gax::ThreadPool> executor,
+         std::shared_ptr<HedgingStats> stats, std::string const& rpc_name);
+
+  Hedger(Hedger const&) = delete;
+  Hedger& operator=(Hedger const&) = delete;
+
+  HedgingPolicy const& policy() const { return policy_; }
+  std::shared_ptr<gax::TimerQueue> const& timers() const { return timers_; }
+
+  /// The delay before the next backup attempt.
+  std::chrono::microseconds HedgeDelay() const;
+
+  /// Record a new call.
+  void OnCall();
+
+  /**
+   * Run @p attempt on the executor, and count it, if the load cap allows a
+   * backup attempt and the executor accepts it.
+   *
+   * @return false if @p attempt will not run.
+   */
+  bool TryStartHedge(std::function<void()> attempt);
+
+  /// Record that a backup attempt provided the response.
+  void OnHedgeWon();
+
+  /// Record the latency of a successful attempt.
+  void RecordLatency(std::chrono::microseconds latency);
+
+ private:
+  // Keep this many recent latencies, and recompute the percentile every
+  // kRecomputeInterval samples once at least kMinLatencySamples are known.
+  static constexpr std::size_t kLatencySamples = 256;
+  static constexpr std::size_t kMinLatencySamples = 32;
+  static constexpr std::int64_t kRecomputeInterval = 16;
+
+  HedgingPolicy const policy_;
+  std::shared_ptr<gax::TimerQueue> const timers_;
+  std::shared_ptr<gax::ThreadPool> const executor_;
+  std::shared_ptr<HedgingStats> const stats_;
+  HedgingStats::AtomicCounters& counters_;
+  TokenBucketRetryBudget<> budget_;
+  std::atomic<std::int64_t> percentile_delay_us_;
+
+  std::mutex mu_;
+  std::vector<std::int64_t> samples_;
+  std::size_t next_sample_;
+  std::int64_t recorded_;
+};
+
+namespace internal {
+
+/**
+ * The state of a single hedged call.
+ *
+ * The first attempt runs on the calling thread. Backup attempts are started
+ * from the hedger's TimerQueue and run on its executor, so they work on copies
+ * of the context and request, and keep this object alive until they complete.
+ * Each attempt has its own CancellationToken, which is used to cancel the
+ * losing attempts once one succeeds.
+ */
+template <typename RequestT, typename ResponseT, typename FunctorT>
+class HedgedCall
+    : public std::enable_shared_from_this<
+          HedgedCall<RequestT, ResponseT, FunctorT>> {
+ public:
+  HedgedCall(gax::CallContext const& context, RequestT const& request,
+             FunctorT next_stub, std::shared_ptr<gax::Hedger> hedger)
+      : context_(context),
+        next_stub_(std::move(next_stub)),
+        hedger_(std::move(hedger)),
+        request_(&request),
+        finished_(false),
+        have_winner_(false),
+        hedges_sent_(0),
+        in_flight_(0) {}
+
+  gax::Status Run(ResponseT* response) {
+    gax::CallContext primary_context(context_);
+    auto token = NewAttemptToken();
+    primary_context.SetCancellationToken(token);
+    tokens_.push_back(token);
+    ScheduleHedge();
+
+    auto const start = std::chrono::steady_clock::now();
+    gax::Status status = next_stub_(primary_context, *request_, response);
+
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!have_winner_ && status.IsOk()) {
+      have_winner_ = true;
+      finished_ = true;
+      CancelLosers(token);
+      lk.unlock();
+      hedger_->RecordLatency(ElapsedSince(start));
+      return status;
+    }
+    // If the first attempt failed wait for the backup attempts in flight, one
+    // of them may still succeed.
+    cv_.wait(lk, [this] { return have_winner_ || in_flight_ == 0; });
+    finished_ = true;
+    if (!have_winner_) {
+      return status;
+    }
+    *response = std::move(winner_response_);
+    return gax::Status{};
+  }
+
+ private:
+  // Each attempt gets its own token, cancelled with the caller's, if any.
+  std::shared_ptr<gax::CancellationToken> NewAttemptToken() const {
+    auto parent = context_.CancellationToken();
+    return parent ? parent->MakeChild()
+                  : std::make_shared<gax::CancellationToken>();
+  }
+
+  static std::chrono::microseconds ElapsedSince(
+      std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+  }
+
+  void ScheduleHedge() {
+    // The timer only holds a weak reference: if the call completes before the
+    // timer expires its state is released right away.
+    std::weak_ptr<HedgedCall> weak = this->shared_from_this();
+    hedger_->timers()->Schedule(hedger_->HedgeDelay(),
+                                [weak](gax::Status timer_status) {
+                                  auto self = weak.lock();
+                                  if (self && timer_status.IsOk()) {
+                                    self->StartHedge();
+                                  }
+                                });
+  }
+
+  // Runs on the TimerQueue thread, it must not block.
+  void StartHedge() {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (finished_ || have_winner_ ||
+        hedges_sent_ >= hedger_->policy().max_hedges()) {
+      return;
+    }
+    ++hedges_sent_;
+    ++in_flight_;
+    auto token = NewAttemptToken();
+    tokens_.push_back(token);
+    // The caller's request is only valid until the call finishes, the backup
+    // attempt may outlive it.
+    auto request = std::make_shared<RequestT>(*request_);
+    bool const more = hedges_sent_ < hedger_->policy().max_hedges();
+    lk.unlock();
+
+    auto hedge_context = std::make_shared<gax::CallContext>(context_);
+    hedge_context->SetCancellationToken(token);
+    auto self = this->shared_from_this();
+    bool const started =
+        hedger_->TryStartHedge([self, hedge_context, request, token] {
+          self->RunHedge(*hedge_context, *request, token);
+        });
+    if (!started) {
+      lk.lock();
+      --hedges_sent_;
+      --in_flight_;
+      lk.unlock();
+      cv_.notify_all();
+      return;
+    }
+    if (more) {
+      ScheduleHedge();
+    }
+  }
+
+  void RunHedge(gax::CallContext& hedge_context, RequestT const& request,
+                std::shared_ptr<gax::CancellationToken> const& token) {
+    auto const start = std::chrono::steady_clock::now();
+    ResponseT response;
+    gax::Status status = next_stub_(hedge_context, request, &response);
+
+    std::unique_lock<std::mutex> lk(mu_);
+    --in_flight_;
+    if (status.IsOk() && !have_winner_ && !finished_) {
+      have_winner_ = true;
+      winner_response_ = std::move(response);
+      CancelLosers(token);
+      lk.unlock();
+      hedger_->OnHedgeWon();
+      hedger_->RecordLatency(ElapsedSince(start));
+    } else {
+      lk.unlock();
+    }
+    cv_.notify_all();
+  }
+
+  void CancelLosers(std::shared_ptr<gax::CancellationToken> const& winner) {
+    for (auto const& token : tokens_) {
+      if (token != winner) {
+        token->Cancel();
+      }
+    }
+  }
+
+  gax::CallContext const context_;
+  FunctorT next_stub_;
+  std::shared_ptr<gax::Hedger> const hedger_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  // Valid until finished_ is set.
+  RequestT const* request_;
+  bool finished_;
+  bool have_winner_;
+  int hedges_sent_;
+  int in_flight_;
+  ResponseT winner_response_;
+  std::vector<std::shared_ptr<gax::CancellationToken>> tokens_;
+};
+
+}  // namespace internal
+
+/**
+ * Invoke @p next_stub, hedging the call as configured by @p hedger.
+ *
+ * The first attempt runs on the calling thread. If it has not completed after
+ * the hedging delay, backup attempts are sent on the hedger's executor,
+ * subject to the limits of the hedging policy and of the executor. The
+ * response of the first attempt that succeeds is returned and the other
+ * attempts are cancelled through the CancellationToken on their CallContext.
+ * If all attempts fail, the status of the first attempt is returned.
+ *
+ * Only idempotent methods may be hedged.
+ *
+ * @param next_stub must be copyable, and safe to call from other threads after
+ *     this function returns. Typically it holds a shared_ptr to the next stub.
+ */
+template <typename RequestT, typename ResponseT, typename FunctorT,
+          typename std::enable_if<
+              gax::internal::is_invocable<FunctorT, gax::CallContext&,
+                                          RequestT const&, ResponseT*>::value,
+              int>::type = 0>
+gax::Status MakeHedgedCall(gax::CallContext& context, RequestT const& request,
+                           ResponseT* response, FunctorT&& next_stub,
+                           std::shared_ptr<gax::Hedger> hedger) {
+  using CallT = internal::HedgedCall<RequestT, ResponseT,
+                                     typename std::decay<FunctorT>::type>;
+  hedger->OnCall();
+  auto call = std::make_shared<CallT>(
+      context, request, std::forward<FunctorT>(next_stub), std::move(hedger));
+  return call->Run(response);
+}
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_HEDGING_H_
@@ -0,0 +1,281 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/hedging.h"
+#include "google/longrunning/operations.pb.h"
+#include "gax/call_context.h"
+#include "gax/cancellation_token.h"
+#include "gax/status.h"
+#include "gax/thread_pool.h"
+#include "gax/timer_queue.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+namespace {
+using namespace ::google;
+using ms = std::chrono::milliseconds;
+
+gax::MethodInfo const kInfo{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                            gax::MethodInfo::Idempotency::IDEMPOTENT};
+
+// Block until the attempt is cancelled, like an rpc whose ClientContext was
+// cancelled.
+gax::Status WaitForCancel(gax::CallContext& context) {
+  auto token = context.CancellationToken();
+  EXPECT_TRUE(token);
+  while (token && !token->IsCancelled()) {
+    std::this_thread::sleep_for(ms(1));
+  }
+  return gax::Status(gax::StatusCode::kCancelled, "cancelled");
+}
+
+class HedgingTest : public ::testing::Test {
+ protected:
+  HedgingTest()
+      : timers_(std::make_shared<gax::TimerQueue>()),
+        executor_(std::make_shared<gax::ThreadPool>(4, 16)),
+        stats_(std::make_shared<gax::HedgingStats>()) {}
+  ~HedgingTest() override {
+    timers_->Shutdown();
+    executor_->Shutdown();
+  }
+
+  std::shared_ptr<gax::Hedger> MakeHedger(gax::HedgingPolicy policy) {
+    return std::make_shared<gax::Hedger>(std::move(policy), timers_, executor_,
+                                         stats_, kInfo.rpc_name);
+  }
+
+  std::shared_ptr<gax::TimerQueue> timers_;
+  std::shared_ptr<gax::ThreadPool> executor_;
+  std::shared_ptr<gax::HedgingStats> stats_;
+};
+
+TEST_F(HedgingTest, FastPrimaryIsNotHedged) {
+  auto hedger = MakeHedger(gax::HedgingPolicy(ms(50), 1, 1.0));
+  gax::CallContext context(kInfo);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+
+  std::atomic<int> attempts(0);
+  auto succeed = [&attempts](gax::CallContext&,
+                             longrunning::GetOperationRequest const&,
+                             longrunning::Operation* r) {
+    ++attempts;
+    r->set_name("primary");
+    return gax::Status{};
+  };
+  auto status = gax::MakeHedgedCall(context, req, &resp, succeed, hedger);
+  EXPECT_TRUE(status.IsOk());
+  EXPECT_EQ(resp.name(), "primary");
+  EXPECT_EQ(attempts.load(), 1);
+
+  auto counters = stats_->ForMethod("TestMethod");
+  EXPECT_EQ(counters.calls, 1);
+  EXPECT_EQ(counters.hedges_sent, 0);
+  EXPECT_EQ(counters.hedges_won, 0);
+}
+
+TEST_F(HedgingTest, HedgeWinsAndCancelsPrimary) {
+  auto hedger = MakeHedger(gax::HedgingPolicy(ms(1), 1, 1.0));
+  gax::CallContext context(kInfo);
+  longrunning::GetOperationRequest req;
+  req.set_name("request");
+  longrunning::Operation resp;
+
+  std::atomic<int> attempts(0);
+  std::atomic<bool> primary_cancelled(false);
+  auto slow_primary = [&attempts, &primary_cancelled](
+      gax::CallContext& c, longrunning::GetOperationRequest const& r,
+      longrunning::Operation* response) {
+    EXPECT_EQ(r.name(), "request");
+    if (attempts++ == 0) {
+      auto status = WaitForCancel(c);
+      primary_cancelled = true;
+      return status;
+    }
+    response->set_name("hedge");
+    return gax::Status{};
+  };
+  auto status = gax::MakeHedgedCall(context, req, &resp, slow_primary, hedger);
+  EXPECT_TRUE(status.IsOk());
+  EXPECT_EQ(resp.name(), "hedge");
+  EXPECT_TRUE(primary_cancelled.load());
+
+  auto counters = stats_->ForMethod("TestMethod");
+  EXPECT_EQ(counters.calls, 1);
+  EXPECT_EQ(counters.hedges_sent, 1);
+  EXPECT_EQ(counters.hedges_won, 1);
+}
+
+TEST_F(HedgingTest, FailedPrimaryWaitsForHedge) {
+  auto hedger = MakeHedger(gax::HedgingPolicy(ms(1), 1, 1.0));
+  gax::CallContext context(kInfo);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+
+  std::atomic<int> attempts(0);
+  auto fail_then_slow_success = [&attempts](
+      gax::CallContext&, longrunning::GetOperationRequest const&,
+      longrunning::Operation* response) {
+    if (attempts++ == 0) {
+      // Fail after the hedge has started, but before it completes.
+      std::this_thread::sleep_for(ms(10));
+      return gax::Status(gax::StatusCode::kUnavailable, "try again");
+    }
+    std::this_thread::sleep_for(ms(30));
+    response->set_name("hedge");
+    return gax::Status{};
+  };
+  auto status =
+      gax::MakeHedgedCall(context, req, &resp, fail_then_slow_success, hedger);
+  EXPECT_TRUE(status.IsOk());
+  EXPECT_EQ(resp.name(), "hedge");
+  EXPECT_EQ(stats_->ForMethod("TestMethod").hedges_won, 1);
+}
+
+TEST_F(HedgingTest, AllAttemptsFail) {
+  auto hedger = MakeHedger(gax::HedgingPolicy(ms(1), 2, 1.0));
+  gax::CallContext context(kInfo);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+
+  std::atomic<int> attempts(0);
+  auto always_fail = [&attempts](gax::CallContext&,
+                                 longrunning::GetOperationRequest const&,
+                                 longrunning::Operation*) {
+    auto attempt = attempts++;
+    std::this_thread::sleep_for(ms(20));
+    return gax::Status(gax::StatusCode::kUnavailable,
+                       attempt == 0 ? "primary" : "hedge");
+  };
+  auto status = gax::MakeHedgedCall(context, req, &resp, always_fail, hedger);
+  EXPECT_EQ(status, gax::Status(gax::StatusCode::kUnavailable, "primary"));
+  EXPECT_EQ(attempts.load(), 3);
+  auto counters = stats_->ForMethod("TestMethod");
+  EXPECT_EQ(counters.hedges_sent, 2);
+  EXPECT_EQ(counters.hedges_won, 0);
+}
+
+TEST_F(HedgingTest, ExtraLoadIsCapped) {
+  // No extra load is allowed beyond the initial burst.
+  auto hedger = MakeHedger(gax::HedgingPolicy(ms(1), 1, 0.0));
+  auto const calls = gax::Hedger::kMaxHedgeBurst + 2;
+  for (int i = 0; i != calls; ++i) {
+    gax::CallContext context(kInfo);
+    longrunning::GetOperationRequest req;
+    longrunning::Operation resp;
+    std::atomic<int> attempts(0);
+    auto slow_primary = [&attempts](gax::CallContext& c,
+                                    longrunning::GetOperationRequest const&,
+                                    longrunning::Operation*) {
+      if (attempts++ == 0) {
+        // Succeed after 20ms, unless a hedge wins first.
+        auto token = c.CancellationToken();
+        for (int i = 0; i != 20 && !token->IsCancelled(); ++i) {
+          std::this_thread::sleep_for(ms(1));
+        }
+      }
+      return gax::Status{};
+    };
+    EXPECT_TRUE(
+        gax::MakeHedgedCall(context, req, &resp, slow_primary, hedger).IsOk());
+  }
+  auto counters = stats_->ForMethod("TestMethod");
+  EXPECT_EQ(counters.calls, calls);
+  EXPECT_EQ(counters.hedges_sent, gax::Hedger::kMaxHedgeBurst);
+}
+
+TEST_F(HedgingTest, ExecutorBoundsBackupAttempts) {
+  // A pool whose only worker is busy, with no room to queue.
+  auto busy = std::make_shared<gax::ThreadPool>(1, 0);
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::promise<void> started;
+  ASSERT_TRUE(busy->TrySubmit([&started, released] {
+    started.set_value();
+    released.wait();
+  }));
+  started.get_future().wait();
+
+  auto hedger = std::make_shared<gax::Hedger>(gax::HedgingPolicy(ms(1), 2, 1.0),
+                                              timers_, busy, stats_,
+                                              kInfo.rpc_name);
+  gax::CallContext context(kInfo);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+  std::atomic<int> attempts(0);
+  auto primary = [&attempts](gax::CallContext&,
+                             longrunning::GetOperationRequest const&,
+                             longrunning::Operation*) {
+    ++attempts;
+    std::this_thread::sleep_for(ms(20));
+    return gax::Status(gax::StatusCode::kUnavailable, "primary");
+  };
+  auto status = gax::MakeHedgedCall(context, req, &resp, primary, hedger);
+  // The rejected backup attempts were not sent, and the call did not wait
+  // for them.
+  EXPECT_EQ(status, gax::Status(gax::StatusCode::kUnavailable, "primary"));
+  EXPECT_EQ(attempts.load(), 1);
+  EXPECT_EQ(stats_->ForMethod("TestMethod").hedges_sent, 0);
+
+  release.set_value();
+  busy->Shutdown();
+}
+
+TEST_F(HedgingTest, CallerCancellationReachesAttempts) {
+  auto hedger = MakeHedger(gax::HedgingPolicy(std::chrono::minutes(1), 1, 1.0));
+  gax::CallContext context(kInfo);
+  auto token = std::make_shared<gax::CancellationToken>();
+  context.SetCancellationToken(token);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+
+  auto wait_for_cancel = [token](gax::CallContext& c,
+                                 longrunning::GetOperationRequest const&,
+                                 longrunning::Operation*) {
+    // The attempt has its own token, a child of the caller's.
+    EXPECT_NE(c.CancellationToken(), token);
+    return WaitForCancel(c);
+  };
+  std::thread canceller([token] {
+    std::this_thread::sleep_for(ms(10));
+    token->Cancel();
+  });
+  auto status =
+      gax::MakeHedgedCall(context, req, &resp, wait_for_cancel, hedger);
+  canceller.join();
+  EXPECT_EQ(status.code(), gax::StatusCode::kCancelled);
+}
+
+TEST_F(HedgingTest, PercentileDelay) {
+  auto hedger = MakeHedger(
+      gax::HedgingPolicy(ms(100), 1, 0.1).UseLatencyPercentile(50));
+  EXPECT_EQ(hedger->HedgeDelay(), ms(100));
+  for (int i = 1; i <= 64; ++i) {
+    hedger->RecordLatency(ms(i));
+  }
+  EXPECT_EQ(hedger->HedgeDelay(), ms(32));
+
+  auto fixed = MakeHedger(gax::HedgingPolicy(ms(100), 1, 0.1));
+  for (int i = 1; i <= 64; ++i) {
+    fixed->RecordLatency(ms(i));
+  }
+  EXPECT_EQ(fixed->HedgeDelay(), ms(100));
+}
+
+}  // namespace
@@ -0,0 +1,165 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_INTERNAL_FAULT_INJECTION_H_
+#define GAPIC_GENERATOR_CPP_GAX_INTERNAL_FAULT_INJECTION_H_
+
+#include "gax/call_context.h"
+#include "gax/internal/random.h"
+#include "gax/internal/test_clock.h"
+#include "gax/status.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace gax {
+namespace internal {
+
+/// Draw the latency of one attempt.
+using LatencyDistribution =
+    std::function<std::chrono::microseconds(Xoshiro256StarStar&)>;
+
+/// Every attempt takes exactly @p latency.
+inline LatencyDistribution FixedLatency(std::chrono::microseconds latency) {
+  return [latency](Xoshiro256StarStar&) { return latency; };
+}
+
+/// Attempts take between @p min and @p max, uniformly distributed.
+inline LatencyDistribution UniformLatency(std::chrono::microseconds min,
+                                          std::chrono::microseconds max) {
+  return [min, max](Xoshiro256StarStar& generator) {
+    return std::chrono::microseconds(
+        std::uniform_int_distribution<std::int64_t>(min.count(),
+                                                    max.count())(generator));
+  };
+}
+
+/**
+ * Attempts follow a log-normal distribution with the given @p median.
+ *
+ * Real rpc latencies have a long tail: most attempts are close to the median
+ * and a few are much slower. A larger @p sigma makes the tail heavier, with
+ * `sigma == 1` the 99th percentile is about 10 times the median.
+ */
+inline LatencyDistribution LogNormalLatency(std::chrono::microseconds median,
+                                            double sigma) {
+  return [median, sigma](Xoshiro256StarStar& generator) {
+    std::lognormal_distribution<double> distribution(
+        std::log(static_cast<double>(median.count())), sigma);
+    return std::chrono::microseconds(
+        static_cast<std::int64_t>(distribution(generator)));
+  };
+}
+
+/**
+ * A fake rpc that fails some of its attempts and takes time on virtual time.
+ *
+ * The injector can be used wherever a retry loop expects the next stub: it
+ * is a functor taking a CallContext, a request, and a response. Each call
+ * draws a latency from the configured distribution and advances the virtual
+ * clock by it, or up to the context's deadline if the attempt would outlive
+ * it, in which case the attempt fails with `kDeadlineExceeded`. Calls that
+ * complete in time fail with each configured code with its probability, and
+ * succeed otherwise.
+ *
+ * The faults and latencies are drawn from a generator seeded in the
+ * constructor, so runs with the same seed and the same calls are
+ * reproducible. The injector is not thread-safe.
+ *
+ * @par Example
+ * @code
+ * std::chrono::steady_clock::time_point now;
+ * FaultInjector injector(42, VirtualClock(now));
+ * injector.FailWith(gax::StatusCode::kUnavailable, 0.1)
+ *     .SetLatency(LogNormalLatency(std::chrono::milliseconds(20), 0.5));
+ * gax::MakeRetryCall(context, request, &response, std::ref(injector),
+ *                    retry_policy, backoff_policy, VirtualClock(now));
+ * @endcode
+ */
+class FaultInjector {
+ public:
+  FaultInjector(std::uint64_t seed, VirtualClock clock)
+      : generator_(seed),
+        clock_(clock),
+        latency_(FixedLatency(std::chrono::microseconds(0))),
+        attempts_(0) {}
+
+  /// Fail a fraction @p probability of the attempts with @p code.
+  FaultInjector& FailWith(gax::StatusCode code, double probability) {
+    faults_.push_back(Fault{code, probability});
+    return *this;
+  }
+
+  /// Draw the latency of each attempt from @p latency.
+  FaultInjector& SetLatency(LatencyDistribution latency) {
+    latency_ = std::move(latency);
+    return *this;
+  }
+
+  /// The number of attempts made so far.
+  std::int64_t attempts() const { return attempts_; }
+
+  gax::Status Call(gax::CallContext const& context) {
+    ++attempts_;
+    auto const now = clock_.now();
+    auto const latency = latency_(generator_);
+    auto const deadline = context.Deadline();
+    if (deadline <= now || latency >= deadline - now) {
+      clock_.sleep_for(std::max(deadline - now,
+                                std::chrono::steady_clock::duration(0)));
+      return gax::Status(gax::StatusCode::kDeadlineExceeded,
+                         "injected: the attempt outlived its deadline");
+    }
+    clock_.sleep_for(latency);
+    auto p = std::uniform_real_distribution<double>(0, 1)(generator_);
+    for (auto const& fault : faults_) {
+      if (p < fault.probability) {
+        return gax::Status(fault.code, "injected fault");
+      }
+      p -= fault.probability;
+    }
+    return gax::Status{};
+  }
+
+  template <typename RequestT, typename ResponseT>
+  gax::Status operator()(gax::CallContext& context, RequestT const&,
+                         ResponseT*) {
+    return Call(context);
+  }
+
+ private:
+  struct Fault {
+    gax::StatusCode code;
+    double probability;
+  };
+
+  Xoshiro256StarStar generator_;
+  VirtualClock clock_;
+  LatencyDistribution latency_;
+  std::vector<Fault> faults_;
+  std::int64_t attempts_;
+};
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_INTERNAL_FAULT_INJECTION_H_
@@ -0,0 +1,179 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gax/internal/fault_injection.h"
+#include "gax/backoff_policy.h"
+#include "gax/call_context.h"
+#include "gax/internal/retry_simulation.h"
+#include "gax/internal/test_clock.h"
+#include "gax/internal/thundering_herd.h"
+#include "gax/method_config.h"
+#include "gax/retry_policy.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+
+namespace {
+using namespace ::google;
+using ms = std::chrono::milliseconds;
+using us = std::chrono::microseconds;
+
+gax::MethodInfo const kInfo{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                            gax::MethodInfo::Idempotency::IDEMPOTENT};
+
+TEST(VirtualClock, SleepAdvancesTime) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::internal::VirtualClock clock(now_point);
+  clock.sleep_for(ms(1500));
+  EXPECT_EQ(clock.now().time_since_epoch(), ms(1500));
+  EXPECT_EQ(now_point, clock.now());
+}
+
+TEST(FaultInjector, LatencyAdvancesTheClock) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::internal::FaultInjector injector(42,
+                                        gax::internal::VirtualClock(now_point));
+  injector.SetLatency(gax::internal::FixedLatency(ms(20)));
+  gax::CallContext context(kInfo);
+  EXPECT_TRUE(injector.Call(context).IsOk());
+  EXPECT_TRUE(injector.Call(context).IsOk());
+  EXPECT_EQ(now_point.time_since_epoch(), ms(40));
+  EXPECT_EQ(injector.attempts(), 2);
+}
+
+TEST(FaultInjector, AttemptsOutlivingTheDeadlineFail) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::internal::FaultInjector injector(42,
+                                        gax::internal::VirtualClock(now_point));
+  injector.SetLatency(gax::internal::FixedLatency(ms(20)));
+  gax::CallContext context(kInfo);
+  context.SetDeadline(now_point + ms(5));
+  EXPECT_EQ(injector.Call(context).code(), gax::StatusCode::kDeadlineExceeded);
+  // The attempt is abandoned at the deadline.
+  EXPECT_EQ(now_point.time_since_epoch(), ms(5));
+}
+
+TEST(FaultInjector, FaultRates) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::internal::FaultInjector injector(42,
+                                        gax::internal::VirtualClock(now_point));
+  injector.FailWith(gax::StatusCode::kUnavailable, 0.2)
+      .FailWith(gax::StatusCode::kInternal, 0.1);
+  gax::CallContext context(kInfo);
+  int unavailable = 0;
+  int internal = 0;
+  int const attempts = 10000;
+  for (int i = 0; i != attempts; ++i) {
+    auto code = injector.Call(context).code();
+    unavailable += code == gax::StatusCode::kUnavailable;
+    internal += code == gax::StatusCode::kInternal;
+  }
+  EXPECT_NEAR(unavailable, 0.2 * attempts, 0.02 * attempts);
+  EXPECT_NEAR(internal, 0.1 * attempts, 0.02 * attempts);
+}
+
+TEST(FaultInjector, LatencyDistributions) {
+  gax::internal::Xoshiro256StarStar generator(42);
+  auto uniform = gax::internal::UniformLatency(ms(10), ms(20));
+  auto lognormal = gax::internal::LogNormalLatency(ms(10), 0.5);
+  int below_median = 0;
+  for (int i = 0; i != 1000; ++i) {
+    auto u = uniform(generator);
+    EXPECT_GE(u, ms(10));
+    EXPECT_LE(u, ms(20));
+    auto l = lognormal(generator);
+    EXPECT_GT(l, us(0));
+    below_median += l < ms(10);
+  }
+  EXPECT_NEAR(below_median, 500, 60);
+}
+
+TEST(RetrySimulation, NoFaults) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::internal::VirtualClock clock(now_point);
+  gax::internal::FaultInjector injector(42, clock);
+  injector.SetLatency(gax::internal::FixedLatency(ms(20)));
+  auto result = gax::internal::SimulateRetryCalls(
+      100, injector, clock,
+      gax::LimitedErrorCountRetryPolicy<gax::internal::VirtualClock>(
+          3, ms(100), clock),
+      gax::ExponentialBackoffPolicy(ms(10), ms(100)));
+  EXPECT_EQ(result.calls, 100);
+  EXPECT_EQ(result.succeeded, 100);
+  EXPECT_EQ(result.attempts, 100);
+  EXPECT_DOUBLE_EQ(result.goodput(), 1.0);
+  EXPECT_DOUBLE_EQ(result.amplification(), 1.0);
+  EXPECT_EQ(result.p50, ms(20));
+  EXPECT_EQ(result.p99, ms(20));
+  EXPECT_EQ(result.elapsed, ms(2000));
+}
+
+TEST(RetrySimulation, RetriesTradeAttemptsForGoodput) {
+  auto run = [](int max_failures) {
+    std::chrono::steady_clock::time_point now_point;
+    gax::internal::VirtualClock clock(now_point);
+    gax::internal::FaultInjector injector(42, clock);
+    injector.FailWith(gax::StatusCode::kUnavailable, 0.5)
+        .SetLatency(gax::internal::UniformLatency(ms(10), ms(30)));
+    return gax::internal::SimulateRetryCalls(
+        1000, injector, clock,
+        gax::LimitedErrorCountRetryPolicy<gax::internal::VirtualClock>(
+            max_failures, ms(100), clock),
+        gax::ExponentialBackoffPolicy(
+            ms(10), ms(1000),
+            std::make_shared<gax::internal::SeededJitterSource>(42)));
+  };
+  auto no_retries = run(0);
+  auto retries = run(5);
+  EXPECT_NEAR(no_retries.goodput(), 0.5, 0.05);
+  EXPECT_DOUBLE_EQ(no_retries.amplification(), 1.0);
+  // With 6 attempts only about 1 in 64 calls fails.
+  EXPECT_GT(retries.goodput(), 0.95);
+  EXPECT_NEAR(retries.amplification(), 2.0, 0.2);
+  // The retried calls include the backoffs, many seconds of virtual time.
+  EXPECT_GT(retries.p99, no_retries.p99);
+  EXPECT_GT(retries.elapsed, std::chrono::seconds(10));
+}
+
+TEST(RetrySimulation, MethodConfigCodesAndTimeout) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::internal::VirtualClock clock(now_point);
+  gax::internal::FaultInjector injector(42, clock);
+  injector.FailWith(gax::StatusCode::kInternal, 0.5)
+      .SetLatency(gax::internal::FixedLatency(ms(20)));
+  gax::MethodRetryConfig const config{
+      "TestMethod", gax::RetryableCode(gax::StatusCode::kUnavailable),
+      5,            ms(1000),
+      ms(10),       ms(100),
+      2.0};
+  auto result = gax::internal::SimulateRetryCalls(
+      1000, injector, clock,
+      gax::MethodConfigRetryPolicy<gax::internal::VirtualClock>(config, clock),
+      gax::ExponentialBackoffPolicy(ms(10), ms(100)));
+  // kInternal is not retryable for this method.
+  EXPECT_EQ(result.attempts, 1000);
+  EXPECT_NEAR(result.goodput(), 0.5, 0.05);
+
+  // Attempts slower than the call timeout fail at the deadline.
+  injector.SetLatency(gax::internal::FixedLatency(ms(50)));
+  auto timeouts = gax::internal::SimulateRetryCalls(
+      10, injector, clock,
+      gax::MethodConfigRetryPolicy<gax::internal::VirtualClock>(config, clock),
+      gax::ExponentialBackoffPolicy(ms(10), ms(100)), ms(30));
+  EXPECT_EQ(timeouts.succeeded, 0);
+  EXPECT_EQ(timeouts.p50, ms(30));
+}
+
+}  // namespace
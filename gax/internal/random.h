@@ -0,0 +1,97 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_INTERNAL_RANDOM_H_
+#define GAPIC_GENERATOR_CPP_GAX_INTERNAL_RANDOM_H_
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+namespace google {
+namespace gax {
+namespace internal {
+
+/**
+ * A small, fast pseudo-random generator: xoshiro256** by Blackman and Vigna.
+ *
+ * The state is 32 bytes and each value costs a handful of shifts and
+ * multiplies, which makes it cheap enough to keep one per thread. It is not
+ * suitable for cryptography, only for jitter and sampling.
+ *
+ * Satisfies the UniformRandomBitGenerator requirements, so it can be used
+ * with the `<random>` distributions.
+ */
+class Xoshiro256StarStar {
+ public:
+  using result_type = std::uint64_t;
+
+  /// Expand @p seed into the full state, as recommended by the authors.
+  explicit Xoshiro256StarStar(std::uint64_t seed) {
+    for (auto& s : state_) {
+      s = SplitMix64(seed);
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    auto const result = Rotl(state_[1] * 5, 7) * 9;
+    auto const t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = Rotl(state_[3], 45);
+    return result;
+  }
+
+ private:
+  static std::uint64_t Rotl(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  static std::uint64_t SplitMix64(std::uint64_t& x) {
+    auto z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  std::uint64_t state_[4];
+};
+
+/**
+ * Return this thread's generator.
+ *
+ * The generator is seeded from `std::random_device` once per thread, the
+ * first time the thread asks for it. Callers must not hand the reference to
+ * other threads.
+ */
+inline Xoshiro256StarStar& ThreadLocalRandom() {
+  static thread_local Xoshiro256StarStar generator(
+      (static_cast<std::uint64_t>(std::random_device{}()) << 32) ^
+      std::random_device{}());
+  return generator;
+}
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_INTERNAL_RANDOM_H_
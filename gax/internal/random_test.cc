@@ -0,0 +1,52 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/internal/random.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <thread>
+
+namespace {
+using namespace ::google;
+
+TEST(Xoshiro256StarStar, ReferenceValues) {
+  // Computed with the reference implementation, seeded with splitmix64(42).
+  gax::internal::Xoshiro256StarStar tested(42);
+  EXPECT_EQ(tested(), 0x15780b2e0c2ec716ULL);
+  EXPECT_EQ(tested(), 0x6104d9866d113a7eULL);
+  EXPECT_EQ(tested(), 0xae17533239e499a1ULL);
+}
+
+TEST(Xoshiro256StarStar, Distribution) {
+  gax::internal::Xoshiro256StarStar tested(7);
+  std::uniform_int_distribution<int> dist(5, 10);
+  for (int i = 0; i != 1000; ++i) {
+    auto v = dist(tested);
+    EXPECT_GE(v, 5);
+    EXPECT_LE(v, 10);
+  }
+}
+
+TEST(ThreadLocalRandom, PerThread) {
+  auto& generator = gax::internal::ThreadLocalRandom();
+  EXPECT_EQ(&generator, &gax::internal::ThreadLocalRandom());
+
+  gax::internal::Xoshiro256StarStar* other = nullptr;
+  std::thread t([&other] { other = &gax::internal::ThreadLocalRandom(); });
+  t.join();
+  EXPECT_NE(&generator, other);
+}
+
+}  // namespace
@@ -0,0 +1,92 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gax/internal/request_params.h"
+
+namespace google {
+namespace gax {
+namespace internal {
+
+namespace {
+std::string& ThreadLocalBuffer() {
+  static thread_local std::string buffer;
+  return buffer;
+}
+
+bool IsUnreserved(char c) {
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+         (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' ||
+         c == '~';
+}
+}  // namespace
+
+void AppendUrlEncoded(std::string const& value, std::string& out) {
+  static char const kHex[] = "0123456789ABCDEF";
+  for (char c : value) {
+    if (IsUnreserved(c)) {
+      out += c;
+      continue;
+    }
+    auto const byte = static_cast<unsigned char>(c);
+    out += '%';
+    out += kHex[byte >> 4];
+    out += kHex[byte & 0xF];
+  }
+}
+
+RequestParamsBuilder::RequestParamsBuilder() : buffer_(ThreadLocalBuffer()) {
+  buffer_.clear();
+}
+
+RequestParamsBuilder& RequestParamsBuilder::Add(char const* name,
+                                                std::string const& value) {
+  AppendName(name);
+  AppendUrlEncoded(value, buffer_);
+  return *this;
+}
+
+RequestParamsBuilder& RequestParamsBuilder::Add(char const* name,
+                                                std::int64_t value) {
+  AppendName(name);
+  // Format the digits backwards in a local buffer, which is large enough for
+  // any 64-bit value and its sign.
+  char digits[20];
+  char* end = digits + sizeof(digits);
+  char* p = end;
+  // Work with negative numbers, which can represent the minimum value.
+  bool const negative = value < 0;
+  std::int64_t v = negative ? value : -value;
+  do {
+    *--p = static_cast<char>('0' - v % 10);
+    v /= 10;
+  } while (v != 0);
+  if (negative) {
+    buffer_ += '-';
+  }
+  buffer_.append(p, end);
+  return *this;
+}
+
+void RequestParamsBuilder::AppendName(char const* name) {
+  if (!buffer_.empty()) {
+    buffer_ += '&';
+  }
+  buffer_ += name;
+  buffer_ += '=';
+}
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
@@ -0,0 +1,78 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_INTERNAL_REQUEST_PARAMS_H_
+#define GAPIC_GENERATOR_CPP_GAX_INTERNAL_REQUEST_PARAMS_H_
+
+#include <cstdint>
+#include <string>
+
+namespace google {
+namespace gax {
+namespace internal {
+
+/// The header that tells the backend which resources a request refers to.
+constexpr char kRequestParamsHeader[] = "x-goog-request-params";
+
+/**
+ * Append @p value to @p out, percent-encoding all but the unreserved
+ * characters of RFC 3986.
+ */
+void AppendUrlEncoded(std::string const& value, std::string& out);
+
+/**
+ * Build the value of the `x-goog-request-params` header.
+ *
+ * Generated stubs use this to send the request fields that appear in a
+ * method's `google.api.http` path, e.g. `name=shelves%2F1%2Fbooks%2F2`. The
+ * value is built directly in a per-thread buffer that is reused by every call
+ * on the thread, so after the first call building the header does not
+ * allocate.
+ *
+ * The value returned by str() is valid until another RequestParamsBuilder is
+ * created on the same thread.
+ *
+ * @code
+ * internal::RequestParamsBuilder params;
+ * params.Add("name", request.name());
+ * context.PrepareGrpcContext(&grpc_ctx, params.str());
+ * @endcode
+ */
+class RequestParamsBuilder {
+ public:
+  RequestParamsBuilder();
+
+  RequestParamsBuilder(RequestParamsBuilder const&) = delete;
+  RequestParamsBuilder& operator=(RequestParamsBuilder const&) = delete;
+
+  /// Add `name=value`, with @p value URL-encoded.
+  RequestParamsBuilder& Add(char const* name, std::string const& value);
+
+  /// Add `name=value` for a numeric or enum field.
+  RequestParamsBuilder& Add(char const* name, std::int64_t value);
+
+  std::string const& str() const { return buffer_; }
+
+ private:
+  void AppendName(char const* name);
+
+  std::string& buffer_;
+};
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_INTERNAL_REQUEST_PARAMS_H_
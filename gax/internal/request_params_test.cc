@@ -0,0 +1,89 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gax/internal/request_params.h"
+#include "grpcpp/client_context.h"
+#include "gax/call_context.h"
+#include "gax/metadata_set.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace {
+using namespace ::google;
+
+std::string UrlEncode(std::string const& value) {
+  std::string out;
+  gax::internal::AppendUrlEncoded(value, out);
+  return out;
+}
+
+TEST(RequestParams, UrlEncode) {
+  EXPECT_EQ(UrlEncode(""), "");
+  EXPECT_EQ(UrlEncode("AZaz09-._~"), "AZaz09-._~");
+  EXPECT_EQ(UrlEncode("shelves/1/books/2"), "shelves%2F1%2Fbooks%2F2");
+  EXPECT_EQ(UrlEncode("a b&c=d"), "a%20b%26c%3Dd");
+  EXPECT_EQ(UrlEncode("\xc3\xa9"), "%C3%A9");
+}
+
+TEST(RequestParams, Builder) {
+  gax::internal::RequestParamsBuilder params;
+  EXPECT_EQ(params.str(), "");
+  params.Add("name", "shelves/1").Add("book.id", std::int64_t{42});
+  EXPECT_EQ(params.str(), "name=shelves%2F1&book.id=42");
+}
+
+TEST(RequestParams, Numbers) {
+  auto format = [](std::int64_t value) {
+    gax::internal::RequestParamsBuilder params;
+    params.Add("n", value);
+    return params.str();
+  };
+  EXPECT_EQ(format(0), "n=0");
+  EXPECT_EQ(format(-7), "n=-7");
+  EXPECT_EQ(format(std::numeric_limits<std::int64_t>::max()),
+            "n=9223372036854775807");
+  EXPECT_EQ(format(std::numeric_limits<std::int64_t>::min()),
+            "n=-9223372036854775808");
+}
+
+TEST(RequestParams, BufferIsReused) {
+  std::string const* first;
+  {
+    gax::internal::RequestParamsBuilder params;
+    params.Add("name", "a-long-resource-name-that-does-not-fit-inline");
+    first = &params.str();
+  }
+  gax::internal::RequestParamsBuilder params;
+  EXPECT_EQ(&params.str(), first);
+  EXPECT_EQ(params.str(), "");
+}
+
+TEST(RequestParams, PrepareGrpcContext) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  grpc::ClientContext grpc_ctx;
+  context.PrepareGrpcContext(&grpc_ctx, "name=shelves%2F1");
+
+  // The caller's header, in a MetadataSet or not, takes precedence.
+  context.SetMetadataSet(gax::MetadataSet::Create(
+      {{gax::internal::kRequestParamsHeader, "name=override"}}));
+  grpc::ClientContext overridden;
+  context.PrepareGrpcContext(&overridden, "name=shelves%2F1");
+}
+
+}  // namespace
@@ -0,0 +1,131 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_INTERNAL_RETRY_SIMULATION_H_
+#define GAPIC_GENERATOR_CPP_GAX_INTERNAL_RETRY_SIMULATION_H_
+
+#include "google/longrunning/operations.pb.h"
+#include "gax/call_context.h"
+#include "gax/internal/fault_injection.h"
+#include "gax/internal/test_clock.h"
+#include "gax/retry_loop.h"
+#include "gax/status.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace google {
+namespace gax {
+namespace internal {
+
+struct RetrySimulationResult {
+  /// The calls made, and the ones that eventually succeeded.
+  int calls;
+  int succeeded;
+  /// The attempts made by all the calls, including the successful ones.
+  std::int64_t attempts;
+  /// The virtual time taken by all the calls, made one after the other.
+  std::chrono::microseconds elapsed;
+  /// Percentiles of the latency of each call, including all its attempts
+  /// and backoffs.
+  std::chrono::microseconds p50;
+  std::chrono::microseconds p90;
+  std::chrono::microseconds p99;
+
+  /// The fraction of the calls that succeeded.
+  double goodput() const {
+    return calls == 0 ? 0.0 : static_cast<double>(succeeded) / calls;
+  }
+  /// The attempts per call: 1.0 if no call was retried.
+  double amplification() const {
+    return calls == 0 ? 0.0 : static_cast<double>(attempts) / calls;
+  }
+};
+
+/// Return the @p percentile (0 to 100) of @p sorted, in ascending order.
+inline std::chrono::microseconds LatencyPercentile(
+    std::vector<std::chrono::microseconds> const& sorted, double percentile) {
+  if (sorted.empty()) {
+    return std::chrono::microseconds(0);
+  }
+  auto index = static_cast<std::size_t>(percentile / 100.0 * sorted.size());
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/**
+ * Run @p calls calls through a retry loop against @p injector.
+ *
+ * Each call uses fresh copies of @p retry_prototype and @p backoff_prototype,
+ * like a retry stub does, and a deadline of @p call_timeout, if any. The
+ * calls run one after the other on the virtual time of @p clock, which must
+ * be the clock used by the injector and by the policies. The simulation
+ * completes immediately, and with a seeded injector and jitter source it is
+ * deterministic, which makes it suitable to compare retry settings offline.
+ */
+template <typename RetryPolicyT, typename BackoffPolicyT>
+RetrySimulationResult SimulateRetryCalls(
+    int calls, FaultInjector& injector, VirtualClock clock,
+    RetryPolicyT const& retry_prototype,
+    BackoffPolicyT const& backoff_prototype,
+    std::chrono::microseconds call_timeout = std::chrono::microseconds(0)) {
+  gax::MethodInfo const info{"SimulatedMethod",
+                             gax::MethodInfo::RpcType::NORMAL_RPC,
+                             gax::MethodInfo::Idempotency::IDEMPOTENT};
+  google::longrunning::GetOperationRequest request;
+  google::longrunning::Operation response;
+  auto const attempts_before = injector.attempts();
+  auto const start = clock.now();
+
+  RetrySimulationResult result{calls,
+                               0,
+                               0,
+                               std::chrono::microseconds(0),
+                               std::chrono::microseconds(0),
+                               std::chrono::microseconds(0),
+                               std::chrono::microseconds(0)};
+  std::vector<std::chrono::microseconds> latencies;
+  latencies.reserve(calls);
+  for (int i = 0; i != calls; ++i) {
+    gax::CallContext context(info);
+    auto const call_start = clock.now();
+    if (call_timeout.count() > 0) {
+      context.SetDeadline(call_start + call_timeout);
+    }
+    auto status = gax::MakeRetryCall(context, request, &response,
+                                     std::ref(injector), retry_prototype,
+                                     backoff_prototype, clock);
+    if (status.IsOk()) {
+      ++result.succeeded;
+    }
+    latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+        clock.now() - call_start));
+  }
+  result.attempts = injector.attempts() - attempts_before;
+  result.elapsed =
+      std::chrono::duration_cast<std::chrono::microseconds>(clock.now() - start);
+  std::sort(latencies.begin(), latencies.end());
+  result.p50 = LatencyPercentile(latencies, 50);
+  result.p90 = LatencyPercentile(latencies, 90);
+  result.p99 = LatencyPercentile(latencies, 99);
+  return result;
+}
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_INTERNAL_RETRY_SIMULATION_H_
@@ -0,0 +1,205 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_INTERNAL_SMALL_FUNCTION_H_
+#define GAPIC_GENERATOR_CPP_GAX_INTERNAL_SMALL_FUNCTION_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace google {
+namespace gax {
+namespace internal {
+
+template <typename Signature, std::size_t kInlineSize = 4 * sizeof(void*)>
+class SmallFunction;
+
+/**
+ * A copyable, type-erased callable, like `std::function`, that stores small
+ * callables inline.
+ *
+ * The size of the inline buffer of `std::function` is unspecified, in
+ * practice a lambda capturing more than a pointer or two is allocated on the
+ * heap. This stores callables of up to @p kInlineSize bytes, e.g. a lambda
+ * capturing four pointers, in the object itself. Larger callables, and
+ * callables that may throw when moved, are allocated on the heap.
+ *
+ * @tparam kInlineSize callables up to this size, in bytes, are stored inline.
+ */
+template <typename R, typename... Args, std::size_t kInlineSize>
+class SmallFunction<R(Args...), kInlineSize> {
+ public:
+  SmallFunction() noexcept
+      : invoker_(nullptr), manager_(nullptr), is_heap_(false) {}
+  SmallFunction(std::nullptr_t) noexcept : SmallFunction() {}
+
+  template <typename F,
+            typename std::enable_if<
+                !std::is_same<typename std::decay<F>::type,
+                              SmallFunction>::value,
+                int>::type = 0>
+  SmallFunction(F&& f) : SmallFunction() {
+    using T = typename std::decay<F>::type;
+    Emplace<T>(std::forward<F>(f),
+               std::integral_constant<bool, FitsInline<T>()>{});
+  }
+
+  SmallFunction(SmallFunction const& rhs) : SmallFunction() {
+    if (rhs.manager_) {
+      rhs.manager_(Operation::kCopy, &rhs.storage_, &storage_);
+      invoker_ = rhs.invoker_;
+      manager_ = rhs.manager_;
+    }
+  }
+
+  SmallFunction(SmallFunction&& rhs) noexcept : SmallFunction() {
+    MoveFrom(rhs);
+  }
+
+  SmallFunction& operator=(SmallFunction const& rhs) {
+    if (this != &rhs) {
+      SmallFunction tmp(rhs);
+      Reset();
+      MoveFrom(tmp);
+    }
+    return *this;
+  }
+
+  SmallFunction& operator=(SmallFunction&& rhs) noexcept {
+    if (this != &rhs) {
+      Reset();
+      MoveFrom(rhs);
+    }
+    return *this;
+  }
+
+  ~SmallFunction() { Reset(); }
+
+  explicit operator bool() const { return invoker_ != nullptr; }
+
+  /// Invoke the callable, which must not be empty.
+  R operator()(Args... args) const {
+    return invoker_(&storage_, std::forward<Args>(args)...);
+  }
+
+  /// Return true if the callable is stored inline, mostly for tests.
+  bool is_inline() const { return manager_ != nullptr && !is_heap_; }
+
+ private:
+  enum class Operation { kCopy, kRelocate, kDestroy };
+  using Storage = typename std::aligned_storage<kInlineSize>::type;
+  using Invoker = R (*)(Storage*, Args&&...);
+  // Copy or relocate the callable in @p from to @p to, or destroy the one in
+  // @p from.
+  using Manager = void (*)(Operation, Storage* from, Storage* to);
+
+  template <typename T>
+  static constexpr bool FitsInline() {
+    return sizeof(T) <= sizeof(Storage) && alignof(T) <= alignof(Storage) &&
+           std::is_nothrow_move_constructible<T>::value;
+  }
+
+  template <typename T, typename F>
+  void Emplace(F&& f, std::true_type) {
+    ::new (static_cast<void*>(&storage_)) T(std::forward<F>(f));
+    invoker_ = &InlineInvoker<T>;
+    manager_ = &InlineManager<T>;
+    is_heap_ = false;
+  }
+
+  template <typename T, typename F>
+  void Emplace(F&& f, std::false_type) {
+    ::new (static_cast<void*>(&storage_)) T*(new T(std::forward<F>(f)));
+    invoker_ = &HeapInvoker<T>;
+    manager_ = &HeapManager<T>;
+    is_heap_ = true;
+  }
+
+  template <typename T>
+  static R InlineInvoker(Storage* storage, Args&&... args) {
+    return (*reinterpret_cast<T*>(storage))(std::forward<Args>(args)...);
+  }
+
+  template <typename T>
+  static R HeapInvoker(Storage* storage, Args&&... args) {
+    return (**reinterpret_cast<T**>(storage))(std::forward<Args>(args)...);
+  }
+
+  template <typename T>
+  static void InlineManager(Operation op, Storage* from, Storage* to) {
+    auto* self = reinterpret_cast<T*>(from);
+    switch (op) {
+      case Operation::kCopy:
+        ::new (static_cast<void*>(to)) T(*self);
+        break;
+      case Operation::kRelocate:
+        ::new (static_cast<void*>(to)) T(std::move(*self));
+        self->~T();
+        break;
+      case Operation::kDestroy:
+        self->~T();
+        break;
+    }
+  }
+
+  template <typename T>
+  static void HeapManager(Operation op, Storage* from, Storage* to) {
+    auto* self = *reinterpret_cast<T**>(from);
+    switch (op) {
+      case Operation::kCopy:
+        ::new (static_cast<void*>(to)) T*(new T(*self));
+        break;
+      case Operation::kRelocate:
+        ::new (static_cast<void*>(to)) T*(self);
+        break;
+      case Operation::kDestroy:
+        delete self;
+        break;
+    }
+  }
+
+  void MoveFrom(SmallFunction& rhs) noexcept {
+    if (rhs.manager_) {
+      rhs.manager_(Operation::kRelocate, &rhs.storage_, &storage_);
+      invoker_ = rhs.invoker_;
+      manager_ = rhs.manager_;
+      is_heap_ = rhs.is_heap_;
+      rhs.invoker_ = nullptr;
+      rhs.manager_ = nullptr;
+    }
+  }
+
+  void Reset() noexcept {
+    if (manager_) {
+      manager_(Operation::kDestroy, &storage_, nullptr);
+      invoker_ = nullptr;
+      manager_ = nullptr;
+    }
+  }
+
+  Invoker invoker_;
+  Manager manager_;
+  bool is_heap_;
+  // The callable may be stateful, calling it does not change which callable
+  // the object holds.
+  mutable Storage storage_;
+};
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_INTERNAL_SMALL_FUNCTION_H_
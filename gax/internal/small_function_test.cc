@@ -0,0 +1,89 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/internal/small_function.h"
+#include <gtest/gtest.h>
+#include <array>
+#include <memory>
+#include <utility>
+
+namespace {
+using namespace ::google;
+using Function = gax::internal::SmallFunction<int(int)>;
+
+TEST(SmallFunction, Empty) {
+  Function f;
+  EXPECT_FALSE(f);
+  EXPECT_FALSE(f.is_inline());
+  Function g(nullptr);
+  EXPECT_FALSE(g);
+}
+
+TEST(SmallFunction, SmallCapturesAreInline) {
+  int base = 10;
+  int* p = &base;
+  Function f([p, &base](int x) { return *p + base + x; });
+  EXPECT_TRUE(f);
+  EXPECT_TRUE(f.is_inline());
+  EXPECT_EQ(f(1), 21);
+
+  // Stateful callables keep their state between calls.
+  int calls = 0;
+  gax::internal::SmallFunction<int()> counter(
+      [calls]() mutable { return ++calls; });
+  EXPECT_EQ(counter(), 1);
+  EXPECT_EQ(counter(), 2);
+}
+
+TEST(SmallFunction, LargeCapturesAreOnTheHeap) {
+  std::array<int, 32> values{};
+  values[31] = 5;
+  Function f([values](int x) { return values[31] + x; });
+  EXPECT_FALSE(f.is_inline());
+  EXPECT_EQ(f(1), 6);
+
+  auto copy = f;
+  EXPECT_EQ(copy(2), 7);
+  auto moved = std::move(copy);
+  EXPECT_FALSE(copy);
+  EXPECT_EQ(moved(3), 8);
+}
+
+TEST(SmallFunction, CopyAndMove) {
+  auto value = std::make_shared<int>(42);
+  Function f([value](int x) { return *value + x; });
+  EXPECT_TRUE(f.is_inline());
+  EXPECT_EQ(value.use_count(), 2);
+
+  Function copy(f);
+  EXPECT_EQ(value.use_count(), 3);
+  EXPECT_EQ(copy(1), 43);
+
+  Function moved(std::move(copy));
+  EXPECT_FALSE(copy);
+  EXPECT_EQ(value.use_count(), 3);
+  EXPECT_EQ(moved(2), 44);
+
+  f = Function([](int x) { return x; });
+  EXPECT_EQ(value.use_count(), 2);
+  EXPECT_EQ(f(7), 7);
+  f = moved;
+  EXPECT_EQ(f(0), 42);
+  moved = Function();
+  f = std::move(moved);
+  EXPECT_FALSE(f);
+  EXPECT_EQ(value.use_count(), 1);
+}
+
+}  // namespace
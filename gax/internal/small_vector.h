@@ -0,0 +1,194 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_INTERNAL_SMALL_VECTOR_H_
+#define GAPIC_GENERATOR_CPP_GAX_INTERNAL_SMALL_VECTOR_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace google {
+namespace gax {
+namespace internal {
+
+/**
+ * A vector that stores up to @p N elements inline.
+ *
+ * Most calls customize their CallContext with zero, one, or two context
+ * policies and metadata pairs. Keeping those in the object avoids the heap
+ * allocation a `std::vector` makes for its first element, and the one per
+ * node of a `std::multimap`. Past @p N elements the storage moves to the
+ * heap, as `std::vector` does.
+ *
+ * Only the operations CallContext needs are provided. Elements must be
+ * nothrow move constructible.
+ */
+template <typename T, std::size_t N>
+class SmallVector {
+  static_assert(N > 0, "SmallVector needs room for at least one element");
+  static_assert(std::is_nothrow_move_constructible<T>::value,
+                "SmallVector elements must be nothrow move constructible");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = T const*;
+
+  SmallVector() noexcept : data_(InlineData()), size_(0), capacity_(N) {}
+
+  SmallVector(SmallVector const& rhs) : SmallVector() {
+    reserve(rhs.size_);
+    for (auto const& v : rhs) {
+      ::new (static_cast<void*>(data_ + size_)) T(v);
+      ++size_;
+    }
+  }
+
+  SmallVector(SmallVector&& rhs) noexcept : SmallVector() { MoveFrom(rhs); }
+
+  SmallVector& operator=(SmallVector const& rhs) {
+    if (this != &rhs) {
+      SmallVector tmp(rhs);
+      Reset();
+      MoveFrom(tmp);
+    }
+    return *this;
+  }
+
+  SmallVector& operator=(SmallVector&& rhs) noexcept {
+    if (this != &rhs) {
+      Reset();
+      MoveFrom(rhs);
+    }
+    return *this;
+  }
+
+  ~SmallVector() { Reset(); }
+
+  iterator begin() { return data_; }
+  iterator end() { return data_ + size_; }
+  const_iterator begin() const { return data_; }
+  const_iterator end() const { return data_ + size_; }
+
+  size_type size() const { return size_; }
+  size_type capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  T& operator[](size_type i) { return data_[i]; }
+  T const& operator[](size_type i) const { return data_[i]; }
+  T& back() { return data_[size_ - 1]; }
+  T const& back() const { return data_[size_ - 1]; }
+
+  /// Return true while the elements are stored inline, mostly for tests.
+  bool is_inline() const { return data_ == InlineData(); }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (size_ == capacity_) {
+      // Construct the new element before relocating the others, @p args may
+      // refer to them.
+      auto const capacity = 2 * capacity_;
+      T* data = Allocate(capacity);
+      ::new (static_cast<void*>(data + size_)) T(std::forward<Args>(args)...);
+      Relocate(data, capacity);
+    } else {
+      ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+    }
+    return data_[size_++];
+  }
+
+  void push_back(T const& v) { emplace_back(v); }
+  void push_back(T&& v) { emplace_back(std::move(v)); }
+
+  void reserve(size_type capacity) {
+    if (capacity > capacity_) {
+      Relocate(Allocate(capacity), capacity);
+    }
+  }
+
+  void clear() noexcept {
+    for (auto& v : *this) {
+      v.~T();
+    }
+    size_ = 0;
+  }
+
+ private:
+  using Storage =
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  T* InlineData() { return reinterpret_cast<T*>(&storage_[0]); }
+  T const* InlineData() const {
+    return reinterpret_cast<T const*>(&storage_[0]);
+  }
+
+  static T* Allocate(size_type capacity) {
+    return static_cast<T*>(::operator new(capacity * sizeof(T)));
+  }
+
+  // Move the elements to @p data, which has room for @p capacity elements,
+  // and release the current storage.
+  void Relocate(T* data, size_type capacity) noexcept {
+    for (size_type i = 0; i != size_; ++i) {
+      ::new (static_cast<void*>(data + i)) T(std::move(data_[i]));
+      data_[i].~T();
+    }
+    if (!is_inline()) {
+      ::operator delete(data_);
+    }
+    data_ = data;
+    capacity_ = capacity;
+  }
+
+  void MoveFrom(SmallVector& rhs) noexcept {
+    if (rhs.is_inline()) {
+      for (size_type i = 0; i != rhs.size_; ++i) {
+        ::new (static_cast<void*>(data_ + i)) T(std::move(rhs.data_[i]));
+      }
+      size_ = rhs.size_;
+      rhs.clear();
+      return;
+    }
+    data_ = rhs.data_;
+    size_ = rhs.size_;
+    capacity_ = rhs.capacity_;
+    rhs.data_ = rhs.InlineData();
+    rhs.size_ = 0;
+    rhs.capacity_ = N;
+  }
+
+  // Destroy the elements and return to the (empty) inline storage.
+  void Reset() noexcept {
+    clear();
+    if (!is_inline()) {
+      ::operator delete(data_);
+      data_ = InlineData();
+      capacity_ = N;
+    }
+  }
+
+  Storage storage_[N];
+  T* data_;
+  size_type size_;
+  size_type capacity_;
+};
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_INTERNAL_SMALL_VECTOR_H_
@@ -0,0 +1,107 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/internal/small_vector.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace {
+using namespace ::google;
+
+TEST(SmallVector, StaysInline) {
+  gax::internal::SmallVector<std::string, 2> v;
+  EXPECT_TRUE(v.empty());
+  EXPECT_TRUE(v.is_inline());
+  v.push_back("a");
+  v.emplace_back(3, 'b');
+  EXPECT_TRUE(v.is_inline());
+  ASSERT_EQ(v.size(), std::size_t(2));
+  EXPECT_EQ(v[0], "a");
+  EXPECT_EQ(v[1], "bbb");
+  EXPECT_EQ(v.back(), "bbb");
+}
+
+TEST(SmallVector, GrowsToHeap) {
+  gax::internal::SmallVector<std::string, 2> v;
+  for (int i = 0; i != 10; ++i) {
+    v.push_back(std::to_string(i));
+  }
+  EXPECT_FALSE(v.is_inline());
+  EXPECT_GE(v.capacity(), std::size_t(10));
+  int i = 0;
+  for (auto const& s : v) {
+    EXPECT_EQ(s, std::to_string(i++));
+  }
+  EXPECT_EQ(i, 10);
+
+  // Growing while appending one of the elements.
+  gax::internal::SmallVector<std::string, 1> w;
+  w.push_back("self");
+  w.push_back(w[0]);
+  ASSERT_EQ(w.size(), std::size_t(2));
+  EXPECT_EQ(w[1], "self");
+}
+
+TEST(SmallVector, CopyAndMove) {
+  gax::internal::SmallVector<std::string, 2> small;
+  small.push_back("x");
+  gax::internal::SmallVector<std::string, 2> large;
+  for (int i = 0; i != 3; ++i) {
+    large.push_back(std::to_string(i));
+  }
+
+  auto small_copy = small;
+  EXPECT_TRUE(small_copy.is_inline());
+  EXPECT_EQ(small_copy[0], "x");
+  auto large_copy = large;
+  ASSERT_EQ(large_copy.size(), std::size_t(3));
+  EXPECT_EQ(large_copy[2], "2");
+
+  auto small_moved = std::move(small_copy);
+  EXPECT_TRUE(small_copy.empty());
+  EXPECT_EQ(small_moved[0], "x");
+
+  auto const* data = &large_copy[0];
+  auto large_moved = std::move(large_copy);
+  EXPECT_TRUE(large_copy.empty());
+  EXPECT_TRUE(large_copy.is_inline());
+  // The heap storage is stolen, not copied.
+  EXPECT_EQ(&large_moved[0], data);
+
+  small_moved = large_moved;
+  EXPECT_EQ(small_moved.size(), std::size_t(3));
+  large_moved = std::move(small);
+  ASSERT_EQ(large_moved.size(), std::size_t(1));
+  EXPECT_EQ(large_moved[0], "x");
+  EXPECT_TRUE(large_moved.is_inline());
+}
+
+TEST(SmallVector, DestroysElements) {
+  auto counter = std::make_shared<int>(0);
+  {
+    gax::internal::SmallVector<std::shared_ptr<int>, 2> v;
+    for (int i = 0; i != 5; ++i) {
+      v.push_back(counter);
+    }
+    EXPECT_EQ(counter.use_count(), 6);
+    v.clear();
+    EXPECT_EQ(counter.use_count(), 1);
+    v.push_back(counter);
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+}  // namespace
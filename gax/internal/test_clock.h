@@ -30,19 +30,50 @@ namespace internal {
  *
  * E.g.:
  *
- * std::chrono::system_clock::time_point n;
+ * std::chrono::steady_clock::time_point n;
  * ClockUser<TestClock> cu(TestClock(n));
  * n += std::chrono::milliseconds(20);
  * cu.CheckElapsedTime();
  */
 class TestClock {
  public:
-  TestClock(std::chrono::system_clock::time_point& now_point)
+  TestClock(std::chrono::steady_clock::time_point& now_point)
       : now_point_(now_point) {}
-  std::chrono::system_clock::time_point now() const { return now_point_; }
+  std::chrono::steady_clock::time_point now() const { return now_point_; }
 
  private:
-  std::chrono::system_clock::time_point& now_point_;
+  std::chrono::steady_clock::time_point& now_point_;
+};
+
+/*
+ * A TestClock whose sleeps advance the now point instead of blocking.
+ *
+ * Retry loops back off through their clock's `sleep_for()` when it has one,
+ * so a loop using a VirtualClock runs on virtual time: simulations of many
+ * calls with long backoffs complete immediately, and deterministically.
+ *
+ * E.g.:
+ *
+ * std::chrono::steady_clock::time_point n;
+ * VirtualClock clock(n);
+ * clock.sleep_for(std::chrono::seconds(1));  // returns right away
+ * assert(n == std::chrono::steady_clock::time_point(std::chrono::seconds(1)));
+ */
+class VirtualClock {
+ public:
+  VirtualClock(std::chrono::steady_clock::time_point& now_point)
+      : now_point_(now_point) {}
+  std::chrono::steady_clock::time_point now() const { return now_point_; }
+
+  template <typename Rep, typename Period>
+  void sleep_for(std::chrono::duration<Rep, Period> duration) const {
+    now_point_ +=
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            duration);
+  }
+
+ private:
+  std::chrono::steady_clock::time_point& now_point_;
 };
 
 }  // namespace internal
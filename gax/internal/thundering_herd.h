@@ -0,0 +1,173 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_INTERNAL_THUNDERING_HERD_H_
+#define GAPIC_GENERATOR_CPP_GAX_INTERNAL_THUNDERING_HERD_H_
+
+#include "gax/backoff_policy.h"
+#include "gax/internal/random.h"
+#include "gax/internal/test_clock.h"
+#include "gax/status.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace gax {
+namespace internal {
+
+/**
+ * A JitterSource that produces the same sequence for the same seed.
+ *
+ * Used to make simulations and tests of randomized backoff policies
+ * reproducible.
+ */
+class SeededJitterSource : public JitterSource {
+ public:
+  explicit SeededJitterSource(std::uint64_t seed) : generator_(seed) {}
+
+  std::int64_t Uniform(std::int64_t min, std::int64_t max) override {
+    std::lock_guard<std::mutex> lk(mu_);
+    return std::uniform_int_distribution<std::int64_t>(min, max)(generator_);
+  }
+
+ private:
+  std::mutex mu_;
+  Xoshiro256StarStar generator_;
+};
+
+/**
+ * A fake service that accepts a fixed number of calls per time window.
+ *
+ * Calls beyond the capacity of the current window fail with `kUnavailable`.
+ * The window is determined by the injected clock, so simulations control
+ * time explicitly.
+ */
+class CapacityLimitedServer {
+ public:
+  CapacityLimitedServer(int capacity, std::chrono::milliseconds window,
+                        TestClock clock)
+      : capacity_(capacity), window_(window), clock_(clock), peak_load_(0) {}
+
+  gax::Status Call() {
+    auto const index = clock_.now().time_since_epoch() / window_;
+    auto const load = ++load_[index];
+    peak_load_ = std::max(peak_load_, load);
+    if (load > capacity_) {
+      return gax::Status(gax::StatusCode::kUnavailable, "over capacity");
+    }
+    return gax::Status{};
+  }
+
+  /// The largest number of calls, accepted or not, received in one window.
+  int peak_load() const { return peak_load_; }
+
+ private:
+  int const capacity_;
+  std::chrono::milliseconds const window_;
+  TestClock clock_;
+  std::map<std::int64_t, int> load_;
+  int peak_load_;
+};
+
+struct ThunderingHerdConfig {
+  /// The number of clients, they all make their first attempt at time 0.
+  int clients;
+  /// The calls accepted by the server in each window.
+  int server_capacity;
+  std::chrono::milliseconds server_window;
+  /// Clients give up after this many attempts.
+  int max_attempts;
+};
+
+struct ThunderingHerdResult {
+  /// The attempts made by all the clients, including the successful ones.
+  std::int64_t total_attempts;
+  /// The largest number of attempts the server received in one window.
+  int peak_load;
+  /// When the last client succeeded or gave up.
+  std::chrono::milliseconds completion_time;
+  /// The clients that gave up without succeeding.
+  int failed_clients;
+};
+
+/**
+ * Simulate many clients retrying against an overloaded service.
+ *
+ * All the clients start at the same time, against a server that cannot
+ * serve all of them at once. Each client retries with its own clone of
+ * @p backoff_prototype until it succeeds or runs out of attempts. The
+ * simulation runs on virtual time: it completes immediately, and with a
+ * prototype that uses a SeededJitterSource it is fully deterministic.
+ */
+inline ThunderingHerdResult SimulateThunderingHerd(
+    ThunderingHerdConfig const& config,
+    gax::BackoffPolicy const& backoff_prototype) {
+  std::chrono::steady_clock::time_point const start;
+  std::chrono::steady_clock::time_point now_point = start;
+  CapacityLimitedServer server(config.server_capacity, config.server_window,
+                               TestClock(now_point));
+
+  struct Client {
+    std::unique_ptr<gax::BackoffPolicy> backoff;
+    int attempts;
+  };
+  std::vector<Client> clients;
+  clients.reserve(config.clients);
+  // The next attempts, ordered by time and then by client.
+  using Event = std::pair<std::chrono::steady_clock::time_point, int>;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  for (int i = 0; i != config.clients; ++i) {
+    clients.push_back(Client{backoff_prototype.clone(), 0});
+    events.emplace(start, i);
+  }
+
+  ThunderingHerdResult result{0, 0, std::chrono::milliseconds(0), 0};
+  while (!events.empty()) {
+    auto const event = events.top();
+    events.pop();
+    now_point = event.first;
+    auto& client = clients[event.second];
+    ++client.attempts;
+    ++result.total_attempts;
+    auto status = server.Call();
+    if (status.IsOk() || client.attempts >= config.max_attempts) {
+      if (!status.IsOk()) {
+        ++result.failed_clients;
+      }
+      result.completion_time =
+          std::chrono::duration_cast<std::chrono::milliseconds>(now_point -
+                                                                start);
+      continue;
+    }
+    events.emplace(now_point + client.backoff->OnFailure(status),
+                   event.second);
+  }
+  result.peak_load = server.peak_load();
+  return result;
+}
+
+}  // namespace internal
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_INTERNAL_THUNDERING_HERD_H_
@@ -0,0 +1,103 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/internal/thundering_herd.h"
+#include "gax/backoff_policy.h"
+#include "gax/internal/test_clock.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+
+namespace {
+using namespace ::google;
+using ms = std::chrono::milliseconds;
+
+gax::internal::ThunderingHerdConfig const kConfig{200, 10, ms(10), 100};
+
+TEST(CapacityLimitedServer, Basic) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::internal::CapacityLimitedServer server(2, ms(10),
+                                              gax::internal::TestClock(now_point));
+  EXPECT_TRUE(server.Call().IsOk());
+  EXPECT_TRUE(server.Call().IsOk());
+  EXPECT_EQ(server.Call().code(), gax::StatusCode::kUnavailable);
+  now_point += ms(10);
+  EXPECT_TRUE(server.Call().IsOk());
+  EXPECT_EQ(server.peak_load(), 3);
+}
+
+TEST(ThunderingHerd, Deterministic) {
+  auto run = [] {
+    gax::DecorrelatedJitterBackoffPolicy policy(
+        ms(10), ms(1000),
+        std::make_shared<gax::internal::SeededJitterSource>(42));
+    return gax::internal::SimulateThunderingHerd(kConfig, policy);
+  };
+  auto first = run();
+  auto second = run();
+  EXPECT_EQ(first.total_attempts, second.total_attempts);
+  EXPECT_EQ(first.peak_load, second.peak_load);
+  EXPECT_EQ(first.completion_time, second.completion_time);
+  EXPECT_EQ(first.failed_clients, second.failed_clients);
+}
+
+// Always returns the largest value, i.e., disables the jitter.
+class NoJitter : public gax::JitterSource {
+ public:
+  std::int64_t Uniform(std::int64_t, std::int64_t max) override { return max; }
+};
+
+TEST(ThunderingHerd, JitterSpreadsTheLoad) {
+  auto jitter = std::make_shared<gax::internal::SeededJitterSource>(42);
+  auto none = gax::internal::SimulateThunderingHerd(
+      kConfig, gax::ExponentialBackoffPolicy(ms(10), ms(1000),
+                                             std::make_shared<NoJitter>()));
+  auto equal = gax::internal::SimulateThunderingHerd(
+      kConfig, gax::ExponentialBackoffPolicy(ms(10), ms(1000), jitter));
+  auto full = gax::internal::SimulateThunderingHerd(
+      kConfig, gax::FullJitterBackoffPolicy(ms(10), ms(1000), jitter));
+  auto decorrelated = gax::internal::SimulateThunderingHerd(
+      kConfig, gax::DecorrelatedJitterBackoffPolicy(ms(10), ms(1000), jitter));
+
+  // Everybody eventually gets through.
+  EXPECT_EQ(none.failed_clients, 0);
+  EXPECT_EQ(equal.failed_clients, 0);
+  EXPECT_EQ(full.failed_clients, 0);
+  EXPECT_EQ(decorrelated.failed_clients, 0);
+
+  // Without jitter the herd retries in lockstep, wasting most attempts and
+  // taking much longer to drain.
+  EXPECT_GT(none.total_attempts, 2 * equal.total_attempts);
+  EXPECT_GT(none.completion_time, 10 * equal.completion_time);
+
+  // Drawing from the whole range lets the herd drain sooner, while the
+  // decorrelated delays never retry before the initial delay, so the early
+  // retries do not pile up on top of the first attempts.
+  EXPECT_LT(full.completion_time, equal.completion_time);
+  EXPECT_LT(decorrelated.total_attempts, equal.total_attempts);
+  EXPECT_LT(decorrelated.peak_load, equal.peak_load);
+}
+
+TEST(ThunderingHerd, GiveUp) {
+  // All the retries land in the first window, where only one call succeeds.
+  gax::internal::ThunderingHerdConfig config{50, 1, ms(10), 2};
+  auto result = gax::internal::SimulateThunderingHerd(
+      config, gax::ExponentialBackoffPolicy(ms(1), ms(1)));
+  EXPECT_EQ(result.failed_clients, 49);
+  EXPECT_EQ(result.total_attempts, 1 + 49 * 2);
+  EXPECT_EQ(result.peak_load, 99);
+  EXPECT_LT(result.completion_time, ms(10));
+}
+
+}  // namespace
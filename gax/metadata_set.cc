@@ -0,0 +1,73 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gax/metadata_set.h"
+#include <mutex>
+#include <unordered_set>
+
+namespace google {
+namespace gax {
+
+namespace internal {
+
+std::string const& InternMetadataKey(std::string const& key) {
+  static auto* const kMutex = new std::mutex;
+  // The elements of an unordered_set are never moved, so the references
+  // remain valid as the set grows.
+  static auto* const kKeys = new std::unordered_set<std::string>;
+  std::lock_guard<std::mutex> lk(*kMutex);
+  return *kKeys->insert(key).first;
+}
+
+}  // namespace internal
+
+std::shared_ptr<MetadataSet const> MetadataSet::Create(
+    std::vector<std::pair<std::string, std::string>> metadata) {
+  return Extend(nullptr, std::move(metadata));
+}
+
+std::shared_ptr<MetadataSet const> MetadataSet::Extend(
+    std::shared_ptr<MetadataSet const> const& base,
+    std::vector<std::pair<std::string, std::string>> metadata) {
+  std::vector<Entry> entries;
+  entries.reserve((base ? base->size() : 0) + metadata.size());
+  if (base) {
+    entries.assign(base->begin(), base->end());
+  }
+  for (auto& m : metadata) {
+    entries.push_back(
+        Entry{&internal::InternMetadataKey(m.first), std::move(m.second)});
+  }
+  return std::shared_ptr<MetadataSet const>(
+      new MetadataSet(std::move(entries)));
+}
+
+std::string const* MetadataSet::Find(std::string const& key) const {
+  for (auto const& e : entries_) {
+    if (*e.key == key) {
+      return &e.value;
+    }
+  }
+  return nullptr;
+}
+
+void MetadataSet::AddTo(grpc::ClientContext* context) const {
+  for (auto const& e : entries_) {
+    context->AddMetadata(*e.key, e.value);
+  }
+}
+
+}  // namespace gax
+}  // namespace google
@@ -0,0 +1,121 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_METADATA_SET_H_
+#define GAPIC_GENERATOR_CPP_GAX_METADATA_SET_H_
+
+#include "grpcpp/client_context.h"
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace gax {
+
+namespace internal {
+
+/**
+ * Return the canonical copy of the metadata key @p key.
+ *
+ * Interned keys live for the duration of the program, and equal keys have the
+ * same address, so they can be compared by pointer. The set of metadata keys
+ * used by a program is small and fixed, interning is meant for them, not for
+ * arbitrary strings.
+ *
+ * This function is thread-safe.
+ */
+std::string const& InternMetadataKey(std::string const& key);
+
+}  // namespace internal
+
+/**
+ * An immutable set of metadata, built once and shared by many calls.
+ *
+ * Most of the metadata sent by a client is the same on every call, e.g.
+ * `x-goog-api-client` or `x-goog-user-project`. Instead of adding those pairs
+ * to each CallContext, a client builds a MetadataSet once and attaches it to
+ * its calls by pointer, see CallContext::SetMetadataSet(). Attaching and
+ * copying the set does not copy any strings. The keys are interned.
+ *
+ * Per-call metadata is still added with CallContext::AddMetadata(), it is
+ * sent after the pairs in the set.
+ *
+ * @par Example
+ * @code
+ * auto metadata = gax::MetadataSet::Create({
+ *     {"x-goog-api-client", "gl-cpp/1.0.0 gapic/0.1.0"},
+ *     {"x-goog-user-project", "my-project"}});
+ * for (...) {
+ *   gax::CallContext context(info);
+ *   context.SetMetadataSet(metadata);
+ *   ...
+ * }
+ * @endcode
+ */
+class MetadataSet {
+ public:
+  /// A metadata pair, the key is interned.
+  struct Entry {
+    std::string const* key;
+    std::string value;
+  };
+  using const_iterator = std::vector<Entry>::const_iterator;
+
+  /// Create a set with the given (key, value) pairs, in order.
+  static std::shared_ptr<MetadataSet const> Create(
+      std::vector<std::pair<std::string, std::string>> metadata);
+  static std::shared_ptr<MetadataSet const> Create(
+      std::initializer_list<std::pair<std::string, std::string>> metadata) {
+    return Create(std::vector<std::pair<std::string, std::string>>(metadata));
+  }
+
+  /**
+   * Create a set with the pairs of @p base followed by @p metadata.
+   *
+   * Use this to extend a per-client set, e.g. with the metadata of a method.
+   * @p base is not modified, and may be null.
+   */
+  static std::shared_ptr<MetadataSet const> Extend(
+      std::shared_ptr<MetadataSet const> const& base,
+      std::vector<std::pair<std::string, std::string>> metadata);
+
+  MetadataSet(MetadataSet const&) = delete;
+  MetadataSet& operator=(MetadataSet const&) = delete;
+
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+  std::size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  /// Return the first value for @p key, or null if there is none.
+  std::string const* Find(std::string const& key) const;
+
+  /// Add all the pairs to @p context.
+  void AddTo(grpc::ClientContext* context) const;
+
+ private:
+  explicit MetadataSet(std::vector<Entry> entries)
+      : entries_(std::move(entries)) {}
+
+  std::vector<Entry> const entries_;
+};
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_METADATA_SET_H_
@@ -0,0 +1,72 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gax/metadata_set.h"
+#include "grpcpp/client_context.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+using namespace ::google;
+
+TEST(MetadataSet, InternedKeysHaveOneAddress) {
+  std::string const key = "x-goog-api-client";
+  auto const& first = gax::internal::InternMetadataKey(key);
+  auto const& second = gax::internal::InternMetadataKey(std::string(key));
+  EXPECT_EQ(&first, &second);
+  EXPECT_EQ(first, key);
+  EXPECT_NE(&gax::internal::InternMetadataKey("x-goog-user-project"), &first);
+}
+
+TEST(MetadataSet, Create) {
+  auto metadata = gax::MetadataSet::Create(
+      {{"x-goog-api-client", "gl-cpp/1.0.0"}, {"key", "a"}, {"key", "b"}});
+  ASSERT_EQ(metadata->size(), 3U);
+  std::vector<std::string> pairs;
+  for (auto const& e : *metadata) {
+    pairs.push_back(*e.key + "=" + e.value);
+  }
+  EXPECT_EQ(pairs, (std::vector<std::string>{"x-goog-api-client=gl-cpp/1.0.0",
+                                             "key=a", "key=b"}));
+  ASSERT_TRUE(metadata->Find("key"));
+  EXPECT_EQ(*metadata->Find("key"), "a");
+  EXPECT_FALSE(metadata->Find("missing"));
+
+  // Sets share the interned keys.
+  auto other = gax::MetadataSet::Create({{"key", "c"}});
+  EXPECT_EQ(other->begin()->key, (metadata->begin() + 1)->key);
+}
+
+TEST(MetadataSet, Extend) {
+  auto base = gax::MetadataSet::Create({{"x-goog-api-client", "gl-cpp"}});
+  auto extended = gax::MetadataSet::Extend(base, {{"x-goog-user-project", "p"}});
+  EXPECT_EQ(base->size(), 1U);
+  ASSERT_EQ(extended->size(), 2U);
+  EXPECT_EQ(*extended->Find("x-goog-api-client"), "gl-cpp");
+  EXPECT_EQ(*extended->Find("x-goog-user-project"), "p");
+
+  auto from_null = gax::MetadataSet::Extend(nullptr, {{"k", "v"}});
+  EXPECT_EQ(from_null->size(), 1U);
+}
+
+TEST(MetadataSet, AddTo) {
+  auto metadata = gax::MetadataSet::Create({{"k1", "v1"}, {"k2", "v2"}});
+  grpc::ClientContext context;
+  metadata->AddTo(&context);
+  EXPECT_TRUE(gax::MetadataSet::Create({})->empty());
+}
+
+}  // namespace
@@ -0,0 +1,115 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef GAPIC_GENERATOR_CPP_GAX_METHOD_CONFIG_H_
+#define GAPIC_GENERATOR_CPP_GAX_METHOD_CONFIG_H_
+
+#include "gax/retry_policy.h"
+#include "gax/status.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace google {
+namespace gax {
+
+/**
+ * The retry settings for one method, from the gRPC service config.
+ *
+ * The generator emits a `constexpr` table of these, one row per method, and
+ * the generated retry stub builds each call's default policies from its
+ * method's row.
+ *
+ * @see https://github.com/grpc/grpc/blob/master/doc/service_config.md
+ */
+struct MethodRetryConfig {
+  char const* rpc_name;
+  /// The status codes worth retrying, see RetryableCode().
+  std::uint32_t retryable_codes;
+  /// The maximum number of attempts, including the first one. 0 means no
+  /// limit other than the timeout.
+  int max_attempts;
+  /// The time allowed for the whole call, including all the retries. 0 means
+  /// no limit other than the attempts.
+  std::chrono::milliseconds timeout;
+  std::chrono::milliseconds initial_backoff;
+  std::chrono::milliseconds max_backoff;
+  double backoff_multiplier;
+};
+
+/// The bit for @p code in MethodRetryConfig::retryable_codes.
+constexpr std::uint32_t RetryableCode(StatusCode code) {
+  return std::uint32_t{1} << static_cast<int>(code);
+}
+
+/**
+ * Retry the codes a MethodRetryConfig lists, within its attempts and timeout.
+ *
+ * Unlike the other policies this one does not assume which errors are
+ * transient: the service config says which codes each method can safely
+ * retry.
+ */
+template <typename Clock = DefaultClock>
+class MethodConfigRetryPolicy : public RetryPolicy {
+ public:
+  explicit MethodConfigRetryPolicy(MethodRetryConfig const& config,
+                                   Clock c = Clock{})
+      : c_(std::move(c)),
+        config_(&config),
+        failures_(0),
+        deadline_(config.timeout == std::chrono::milliseconds::zero()
+                      ? std::chrono::steady_clock::time_point::max()
+                      : c_.now() + config.timeout) {}
+
+  MethodConfigRetryPolicy(MethodConfigRetryPolicy const& rhs) noexcept
+      : MethodConfigRetryPolicy(*rhs.config_, rhs.c_) {}
+
+  MethodConfigRetryPolicy(MethodConfigRetryPolicy&& rhs) noexcept
+      : MethodConfigRetryPolicy(*rhs.config_, std::move(rhs.c_)) {}
+
+  std::unique_ptr<RetryPolicy> clone() const override {
+    return std::unique_ptr<RetryPolicy>(
+        new MethodConfigRetryPolicy<Clock>(*this));
+  }
+
+  bool OnFailure(Status const& status) override {
+    ++failures_;
+    if ((config_->retryable_codes & RetryableCode(status.code())) == 0) {
+      return false;
+    }
+    if (config_->max_attempts > 0 && failures_ >= config_->max_attempts) {
+      return false;
+    }
+    return c_.now() < deadline_;
+  }
+
+  std::chrono::steady_clock::time_point OperationDeadline() const override {
+    return deadline_;
+  }
+
+  std::chrono::steady_clock::time_point RetryDeadline() const override {
+    return deadline_;
+  }
+
+ private:
+  Clock c_;
+  // The configs are static tables, policies only refer to them.
+  MethodRetryConfig const* config_;
+  int failures_;
+  std::chrono::steady_clock::time_point const deadline_;
+};
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_METHOD_CONFIG_H_
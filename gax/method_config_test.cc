@@ -0,0 +1,100 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gax/method_config.h"
+#include "gax/internal/test_clock.h"
+#include "gax/status.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+
+namespace {
+using namespace ::google;
+using ms = std::chrono::milliseconds;
+
+constexpr gax::MethodRetryConfig kConfig[] = {
+    {"Retried",
+     gax::RetryableCode(gax::StatusCode::kUnavailable) |
+         gax::RetryableCode(gax::StatusCode::kResourceExhausted),
+     3, ms(100), ms(10), ms(50), 1.5},
+    {"NotRetried", 0, 1, ms(100), ms(10), ms(50), 1.5},
+};
+
+TEST(MethodConfigRetryPolicy, RetryableCodes) {
+  gax::MethodConfigRetryPolicy<> tested(kConfig[0]);
+  EXPECT_TRUE(tested.OnFailure(gax::Status(gax::StatusCode::kUnavailable, "")));
+  EXPECT_FALSE(tested.OnFailure(gax::Status(gax::StatusCode::kAborted, "")));
+
+  gax::MethodConfigRetryPolicy<> other(kConfig[0]);
+  // Not retried by the other policies, but listed in the config.
+  EXPECT_TRUE(
+      other.OnFailure(gax::Status(gax::StatusCode::kResourceExhausted, "")));
+
+  gax::MethodConfigRetryPolicy<> never(kConfig[1]);
+  EXPECT_FALSE(never.OnFailure(gax::Status(gax::StatusCode::kUnavailable, "")));
+}
+
+TEST(MethodConfigRetryPolicy, MaxAttempts) {
+  gax::MethodConfigRetryPolicy<> tested(kConfig[0]);
+  gax::Status unavailable(gax::StatusCode::kUnavailable, "");
+  EXPECT_TRUE(tested.OnFailure(unavailable));
+  EXPECT_TRUE(tested.OnFailure(unavailable));
+  // The third failure was the last attempt.
+  EXPECT_FALSE(tested.OnFailure(unavailable));
+
+  // Copies and clones start over.
+  gax::MethodConfigRetryPolicy<> copy(tested);
+  EXPECT_TRUE(copy.OnFailure(unavailable));
+  auto clone = tested.clone();
+  EXPECT_TRUE(clone->OnFailure(unavailable));
+}
+
+TEST(MethodConfigRetryPolicy, Timeout) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::internal::TestClock clock(now_point);
+  constexpr gax::MethodRetryConfig kUnlimited{
+      "Unlimited", gax::RetryableCode(gax::StatusCode::kUnavailable), 0,
+      ms(100), ms(10), ms(50), 2.0};
+  gax::MethodConfigRetryPolicy<gax::internal::TestClock> tested(kUnlimited,
+                                                                clock);
+  EXPECT_EQ(tested.OperationDeadline(), now_point + ms(100));
+  EXPECT_EQ(tested.RetryDeadline(), now_point + ms(100));
+
+  gax::Status unavailable(gax::StatusCode::kUnavailable, "");
+  for (int i = 0; i != 10; ++i) {
+    EXPECT_TRUE(tested.OnFailure(unavailable));
+  }
+  now_point += ms(100);
+  EXPECT_FALSE(tested.OnFailure(unavailable));
+}
+
+TEST(MethodConfigRetryPolicy, NoTimeout) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::internal::TestClock clock(now_point);
+  constexpr gax::MethodRetryConfig kNoTimeout{
+      "NoTimeout", gax::RetryableCode(gax::StatusCode::kUnavailable), 3, ms(0),
+      ms(10), ms(50), 2.0};
+  gax::MethodConfigRetryPolicy<gax::internal::TestClock> tested(kNoTimeout,
+                                                                clock);
+  EXPECT_EQ(tested.OperationDeadline(),
+            std::chrono::steady_clock::time_point::max());
+
+  // Only the attempts limit the retries.
+  gax::Status unavailable(gax::StatusCode::kUnavailable, "");
+  now_point += std::chrono::hours(1);
+  EXPECT_TRUE(tested.OnFailure(unavailable));
+  EXPECT_TRUE(tested.OnFailure(unavailable));
+  EXPECT_FALSE(tested.OnFailure(unavailable));
+}
+
+}  // namespace
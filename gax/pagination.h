@@ -17,10 +17,16 @@
 
 #include "gax/internal/invoke_result.h"
 #include "gax/status.h"
+#include "gax/status_or.h"
+#include "gax/thread_pool.h"
 #include <google/protobuf/repeated_field.h>
+#include <functional>
+#include <future>
 #include <iterator>
+#include <memory>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 namespace google {
 namespace gax {
@@ -116,6 +122,104 @@ class PageResult {
   PageType raw_page_;
 };
 
+/**
+ * How `Pages` iterators retrieve the pages after the first.
+ */
+enum class PageFetchMode {
+  /// `operator++` blocks on the rpc for the next page.
+  kBlocking,
+  /**
+   * As soon as a page arrives the rpc for the following page is started in
+   * the background, overlapping it with the caller's processing of the
+   * current page. `operator++` then only waits for whatever part of the rpc
+   * is still outstanding.
+   *
+   * Since each request needs the previous page's token at most one rpc is in
+   * flight, and none is started for a page the iteration will not show. The
+   * page retriever runs on a worker thread the iterator starts once and
+   * reuses for every page, so it and anything it captures (e.g. the stub)
+   * must be safe to use from another thread. Destroying an iterator waits for
+   * its in-flight rpc and discards the result.
+   */
+  kPrefetch,
+};
+
+namespace internal {
+
+/**
+ * Runs a page retriever on a worker thread, one page at a time.
+ *
+ * Owns the retriever and the single worker thread that calls it, so the
+ * retriever does not move while an rpc is in flight and no thread is started
+ * per page.
+ */
+template <typename PageType, typename NextPageRetriever>
+class PagePrefetcher {
+ public:
+  explicit PagePrefetcher(NextPageRetriever get_next_page)
+      : get_next_page_(std::move(get_next_page)), worker_(1, 1) {}
+
+  ~PagePrefetcher() {
+    // Nobody will take the page, so an error, or an exception thrown by the
+    // retriever, is dropped rather than rethrown here.
+    if (pending_.valid()) {
+      pending_.wait();
+    }
+  }
+
+  PagePrefetcher(PagePrefetcher const&) = delete;
+  PagePrefetcher& operator=(PagePrefetcher const&) = delete;
+
+  /// Starts retrieving the next page. The previous one must have been taken.
+  void Start() {
+    using Fetch = std::packaged_task<StatusOr<PageType>()>;
+    auto fetch = std::make_shared<Fetch>([this]() -> StatusOr<PageType> {
+      PageType page;
+      gax::Status status = get_next_page_(&page);
+      if (!status.IsOk()) {
+        return StatusOr<PageType>(std::move(status));
+      }
+      return StatusOr<PageType>(std::move(page));
+    });
+    pending_ = fetch->get_future();
+    // The worker has room for one queued fetch, so this is only rejected if
+    // it is not done with the previous one, which has been taken already.
+    if (!worker_.TrySubmit([fetch] { (*fetch)(); })) {
+      (*fetch)();
+    }
+  }
+
+  /**
+   * Waits for the page started by `Start()` and moves it into @p page.
+   *
+   * If no page was started, or its rpc failed, @p page is left empty, i.e.
+   * with an empty page token, which ends the iteration. Exceptions thrown by
+   * the retriever are rethrown here, as they are in the blocking mode.
+   *
+   * @return the status of the rpc, OK if no page was started.
+   */
+  gax::Status Take(PageType* page) {
+    page->Clear();
+    if (!pending_.valid()) {
+      return gax::Status();
+    }
+    StatusOr<PageType> result = pending_.get();
+    if (!result) {
+      return result.status();
+    }
+    page->Swap(&*result);
+    return gax::Status();
+  }
+
+ private:
+  NextPageRetriever get_next_page_;
+  std::future<StatusOr<PageType>> pending_;
+  // Declared last, so its thread is joined before the members it uses go.
+  gax::ThreadPool worker_;
+};
+
+}  // namespace internal
+
 /**
  * Wraps a sequence of pages implied to be serially returned by a paginated API
  * method and provides an iterator that retrieves subsequent pages, usually via
@@ -153,6 +257,11 @@ class PageResult {
  * for(auto& page : pages) {
  *   // Do something with the page
  * }
+ *
+ * // Fetch each page while the previous one is being processed.
+ * Pages<EltType, ListElementsResponse, decltype(get_next_page),
+ *       ElementsAccessor> prefetched(std::move(get_next_page), 0,
+ *                                    PageFetchMode::kPrefetch);
  * @endcode
  *
  * @tparam ElementType the type of the repeated elements in the page.
@@ -168,6 +277,11 @@ class PageResult {
  * Note: the initial page request MUST be captured by value in the
  * NextPageRetriever functor so that calling begin() multiple times on a Pages
  * instance results in valid behavior.
+ *
+ * Note: in `PageFetchMode::kPrefetch` mode the iterators are single pass:
+ * copies of an iterator share the page retriever and the in-flight rpc. With
+ * a page cap, the iterator that reaches it holds an empty page, since the page
+ * at the cap is not fetched.
  */
 template <typename ElementType, typename PageType, typename ElementAccessor,
           typename NextPageRetriever,
@@ -194,12 +308,26 @@ class Pages {
       // Note: if the rpc fails, the page will be untouched,
       // i.e. will have an empty page token and element collection.
       // This invalidates any iterators on the PageResult.
+      if (prefetcher_) {
+        status_ = prefetcher_->Take(&(page_result_.RawPage()));
+        num_pages_++;
+        MaybePrefetch();
+        return *this;
+      }
       page_result_.RawPage().Clear();
-      get_next_page_(&(page_result_.RawPage()));
+      status_ = get_next_page_(&(page_result_.RawPage()));
       num_pages_++;
       return *this;
     }
 
+    /**
+     * @brief The status of the rpc that retrieved the current page.
+     *
+     * A failed rpc ends the iteration, check this to tell a failure from the
+     * last page.
+     */
+    gax::Status const& status() const { return status_; }
+
     // Just want to compare against end()
     bool operator==(iterator const& rhs) const {
       return num_pages_ == rhs.num_pages_ ||
@@ -209,17 +337,42 @@ class Pages {
 
    private:
     friend Pages;
+    using Prefetcher = internal::PagePrefetcher<PageType, NextPageRetriever>;
+
     // Note: copying a message with many repeated elements is expensive.
     // Callers should move pages in when instantiating an iterator.
     iterator(PageType page_result, NextPageRetriever get_next_page,
-             int num_pages)
+             int num_pages, int pages_cap = 0,
+             PageFetchMode mode = PageFetchMode::kBlocking,
+             gax::Status status = gax::Status())
         : page_result_(std::move(page_result)),
-          get_next_page_(std::move(get_next_page)),
-          num_pages_(num_pages) {}
+          get_next_page_(get_next_page),
+          num_pages_(num_pages),
+          pages_cap_(pages_cap),
+          status_(std::move(status)) {
+      if (mode == PageFetchMode::kPrefetch) {
+        prefetcher_ = std::make_shared<Prefetcher>(std::move(get_next_page));
+        MaybePrefetch();
+      }
+    }
+
+    // Starts fetching the next page, unless this one is the last. With a cap
+    // the iteration ends on reaching it, so the page at the cap is not shown
+    // and not fetched.
+    void MaybePrefetch() {
+      if (page_result_.NextPageToken().empty() ||
+          (pages_cap_ != 0 && num_pages_ + 1 >= pages_cap_)) {
+        return;
+      }
+      prefetcher_->Start();
+    }
 
     PageResultT page_result_;
     NextPageRetriever get_next_page_;
     int num_pages_;
+    int pages_cap_;
+    gax::Status status_;
+    std::shared_ptr<Prefetcher> prefetcher_;
   };
 
   /**
@@ -229,17 +382,23 @@ class Pages {
    * @param get_next_page an instance of the page retrieval functor.
    * @param pages_cap the maximum number of pages to retrieve. A value of 0
    * (default) indicates no cap.
+   * @param mode whether iterators fetch each page on `operator++` (default) or
+   * in the background while the previous page is processed.
    */
-  Pages(NextPageRetriever get_next_page, int pages_cap = 0)
-      : get_next_page_(std::move(get_next_page)), pages_cap_(pages_cap) {}
+  Pages(NextPageRetriever get_next_page, int pages_cap = 0,
+        PageFetchMode mode = PageFetchMode::kBlocking)
+      : get_next_page_(std::move(get_next_page)),
+        pages_cap_(pages_cap),
+        mode_(mode) {}
 
   iterator begin() const {
     PageType page;
     // Copying the next-page lambda is necessary to start at the beginning.
     NextPageRetriever fresh_get_next_page_(get_next_page_);
-    fresh_get_next_page_(&page);
+    gax::Status status = fresh_get_next_page_(&page);
 
-    return iterator(std::move(page), std::move(fresh_get_next_page_), 1);
+    return iterator(std::move(page), std::move(fresh_get_next_page_), 1,
+                    pages_cap_, mode_, std::move(status));
   }
 
   iterator end() const {
@@ -254,8 +413,183 @@ class Pages {
   // which means that begin() _really_ starts at the beginning.
   NextPageRetriever get_next_page_;
   const int pages_cap_;
+  const PageFetchMode mode_;
 };
 
+/**
+ * A single-pass range over the elements of a paginated API method, across all
+ * of its pages.
+ *
+ * Pages are fetched lazily: the first one when `begin()` is called, and each
+ * following one only when the elements of the previous page run out. Empty
+ * pages are skipped. The end iterator is a sentinel, so comparing against it
+ * does not look at page tokens.
+ *
+ * If fetching a page fails the iteration ends early, and `status()` reports
+ * the error. Always check it after the loop to distinguish a failure from the
+ * end of the listing.
+ *
+ * @par Example
+ *
+ * @code
+ * PaginatedRange<Book> books = client.ListBooks(request);
+ * for (Book& book : books) {
+ *   // Do something with the book
+ * }
+ * if (!books.status().IsOk()) {
+ *   // Handle the error
+ * }
+ * @endcode
+ *
+ * Iterators point into the range, which must not be moved or destroyed while
+ * they are in use.
+ *
+ * @tparam ElementType the type of the repeated elements in the pages.
+ */
+template <typename ElementType>
+class PaginatedRange {
+ public:
+  using ElementField = protobuf::RepeatedPtrField<ElementType>;
+
+  /**
+   * Retrieves the elements of the next page into its first argument, which is
+   * empty on entry, and sets its second argument to true if that page is the
+   * last one.
+   */
+  using PageLoader = std::function<gax::Status(ElementField*, bool*)>;
+
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = ElementType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = ElementType*;
+    using reference = ElementType&;
+
+    ElementType& operator*() const { return range_->Current(); }
+    ElementType* operator->() const { return &range_->Current(); }
+    iterator& operator++() {
+      range_->Advance();
+      return *this;
+    }
+
+    bool operator==(iterator const& rhs) const {
+      return AtEnd() ? rhs.AtEnd() : range_ == rhs.range_;
+    }
+    bool operator!=(iterator const& rhs) const { return !(*this == rhs); }
+
+   private:
+    friend PaginatedRange;
+    explicit iterator(PaginatedRange* range) : range_(range) {}
+
+    bool AtEnd() const { return range_ == nullptr || range_->done_; }
+
+    PaginatedRange* range_;
+  };
+
+  explicit PaginatedRange(PageLoader load_page)
+      : load_page_(std::move(load_page)),
+        index_(0),
+        started_(false),
+        last_page_(false),
+        done_(false) {}
+
+  PaginatedRange(PaginatedRange&&) = default;
+  PaginatedRange& operator=(PaginatedRange&&) = default;
+
+  PaginatedRange(PaginatedRange const&) = delete;
+  PaginatedRange& operator=(PaginatedRange const&) = delete;
+
+  /**
+   * Fetches the first page on the first call. Later calls return an iterator
+   * at the current position, the range cannot be restarted.
+   */
+  iterator begin() {
+    if (!started_) {
+      started_ = true;
+      Fill();
+    }
+    return iterator(this);
+  }
+
+  iterator end() { return iterator(nullptr); }
+
+  /**
+   * @brief The status of the page retrieval.
+   *
+   * @return OK unless fetching a page failed, in which case the iteration
+   * ended early with this error.
+   */
+  gax::Status const& status() const { return status_; }
+
+ private:
+  ElementType& Current() { return elements_[index_]; }
+
+  void Advance() {
+    ++index_;
+    Fill();
+  }
+
+  // Fetches pages until there is a current element or the listing ends.
+  void Fill() {
+    while (index_ >= elements_.size()) {
+      if (last_page_) {
+        done_ = true;
+        return;
+      }
+      elements_.Clear();
+      index_ = 0;
+      status_ = load_page_(&elements_, &last_page_);
+      if (!status_.IsOk()) {
+        elements_.Clear();
+        done_ = true;
+        return;
+      }
+    }
+  }
+
+  PageLoader load_page_;
+  ElementField elements_;
+  int index_;
+  bool started_;
+  bool last_page_;
+  bool done_;
+  gax::Status status_;
+};
+
+/**
+ * Creates a `PaginatedRange` from the same page retrieval functor and element
+ * accessor that `Pages` uses.
+ *
+ * Each page's elements are swapped out of the page message, not copied.
+ *
+ * @tparam ElementType the type of the repeated elements in the page.
+ * @tparam PageType the type of the page message.
+ * @param get_next_page a functor that takes a mutable PageType*, fills it with
+ * the next page and returns a gax::Status. It must update its request with the
+ * page token of each page it retrieves.
+ * @param accessor a functor that takes a PageType& and returns a mutable
+ * pointer to the repeated field that contains ElementType.
+ */
+template <typename ElementType, typename PageType, typename NextPageRetriever,
+          typename ElementAccessor>
+PaginatedRange<ElementType> MakePaginatedRange(NextPageRetriever get_next_page,
+                                               ElementAccessor accessor) {
+  using ElementField = typename PaginatedRange<ElementType>::ElementField;
+  return PaginatedRange<ElementType>(
+      [get_next_page, accessor](ElementField* elements,
+                                bool* last_page) mutable {
+        PageType page;
+        gax::Status status = get_next_page(&page);
+        if (!status.IsOk()) {
+          return status;
+        }
+        *last_page = page.next_page_token().empty();
+        accessor(page)->Swap(elements);
+        return status;
+      });
+}
+
 }  // namespace gax
 }  // namespace google
 
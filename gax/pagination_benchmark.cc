@@ -0,0 +1,86 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/pagination.h"
+#include "google/longrunning/operations.pb.h"
+#include "gax/status.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace {
+using namespace ::google;
+
+class OperationsAccessor {
+ public:
+  protobuf::RepeatedPtrField<longrunning::Operation>* operator()(
+      longrunning::ListOperationsResponse& lor) const {
+    return lor.mutable_operations();
+  }
+};
+
+// Stands in for a ListOperations rpc with a fixed round trip time.
+class SlowPageRetriever {
+ public:
+  SlowPageRetriever(int max_pages, std::chrono::microseconds latency)
+      : page_(0), max_pages_(max_pages), latency_(latency) {}
+  gax::Status operator()(longrunning::ListOperationsResponse* lor) {
+    std::this_thread::sleep_for(latency_);
+    ++page_;
+    lor->add_operations()->set_name("operation-" + std::to_string(page_));
+    if (page_ < max_pages_) {
+      lor->set_next_page_token("token-" + std::to_string(page_));
+    }
+    return gax::Status{};
+  }
+
+ private:
+  int page_;
+  int max_pages_;
+  std::chrono::microseconds latency_;
+};
+
+using SlowPages =
+    gax::Pages<longrunning::Operation, longrunning::ListOperationsResponse,
+               OperationsAccessor, SlowPageRetriever>;
+
+// Lists 20 pages with a 2ms round trip, spending range(0) microseconds
+// processing each page. Prefetching overlaps the processing with the next
+// round trip.
+void RunListing(benchmark::State& state, gax::PageFetchMode mode) {
+  auto const latency = std::chrono::microseconds(2000);
+  auto const processing = std::chrono::microseconds(state.range(0));
+  for (auto _ : state) {
+    SlowPages pages(SlowPageRetriever(20, latency), 0, mode);
+    for (auto const& page : pages) {
+      benchmark::DoNotOptimize(page.NextPageToken());
+      std::this_thread::sleep_for(processing);
+    }
+  }
+}
+
+void BM_ListBlocking(benchmark::State& state) {
+  RunListing(state, gax::PageFetchMode::kBlocking);
+}
+BENCHMARK(BM_ListBlocking)->Arg(0)->Arg(1000)->Arg(2000)->UseRealTime();
+
+void BM_ListPrefetch(benchmark::State& state) {
+  RunListing(state, gax::PageFetchMode::kPrefetch);
+}
+BENCHMARK(BM_ListPrefetch)->Arg(0)->Arg(1000)->Arg(2000)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -18,8 +18,14 @@
 #include <google/protobuf/util/message_differencer.h>
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
+#include <chrono>
 #include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 namespace {
@@ -56,10 +62,39 @@ class PageRetriever {
   const int max_pages_;
 };
 
+// Counts the rpcs and records the threads they run on.
+class CountingPageRetriever {
+ public:
+  struct Calls {
+    std::mutex mu;
+    int count = 0;
+    std::set<std::thread::id> threads;
+  };
+
+  CountingPageRetriever(int max_pages, std::shared_ptr<Calls> calls)
+      : retriever_(max_pages), calls_(std::move(calls)) {}
+  gax::Status operator()(longrunning::ListOperationsResponse* lor) {
+    {
+      std::lock_guard<std::mutex> lk(calls_->mu);
+      ++calls_->count;
+      calls_->threads.insert(std::this_thread::get_id());
+    }
+    return retriever_(lor);
+  }
+
+ private:
+  PageRetriever retriever_;
+  std::shared_ptr<Calls> calls_;
+};
+
 using TestPages =
     gax::Pages<longrunning::Operation, longrunning::ListOperationsResponse,
                OperationsAccessor, PageRetriever>;
 
+using PrefetchPages =
+    gax::Pages<longrunning::Operation, longrunning::ListOperationsResponse,
+               OperationsAccessor, CountingPageRetriever>;
+
 using TestedPageResult =
     gax::PageResult<longrunning::Operation, longrunning::ListOperationsResponse,
                     OperationsAccessor>;
@@ -155,4 +190,277 @@ TEST(Pages, PageCap) {
   EXPECT_EQ(iter->NextPageToken(), "NextPage5");
 }
 
+TEST(Pages, PrefetchIteration) {
+  auto calls = std::make_shared<CountingPageRetriever::Calls>();
+  PrefetchPages pages(CountingPageRetriever(10, calls), 0,
+                      gax::PageFetchMode::kPrefetch);
+  int i = 1;
+  for (auto const& p : pages) {
+    std::stringstream ss;
+    ss << "NextPage" << i;
+
+    EXPECT_EQ(p.NextPageToken(), ss.str());
+    i++;
+  }
+  EXPECT_EQ(i, 10);
+
+  std::lock_guard<std::mutex> lk(calls->mu);
+  // No rpc is started past the last page.
+  EXPECT_EQ(calls->count, 10);
+  // The first page is fetched by the caller, the rest in the background.
+  EXPECT_EQ(calls->threads.size(), 2U);
+  EXPECT_EQ(calls->threads.count(std::this_thread::get_id()), 1U);
+}
+
+TEST(Pages, PrefetchPageCap) {
+  auto calls = std::make_shared<CountingPageRetriever::Calls>();
+  PrefetchPages pages(CountingPageRetriever(10, calls), 5,
+                      gax::PageFetchMode::kPrefetch);
+  int i = 1;
+  auto iter = pages.begin();
+  for (; iter != pages.end(); ++iter) {
+    std::stringstream ss;
+    ss << "NextPage" << i;
+
+    EXPECT_EQ(iter->NextPageToken(), ss.str());
+    i++;
+  }
+  EXPECT_EQ(i, 5);
+  // The page at the cap is never shown, so it is not fetched either.
+  EXPECT_EQ(iter->NextPageToken(), "");
+
+  std::lock_guard<std::mutex> lk(calls->mu);
+  EXPECT_EQ(calls->count, 4);
+}
+
+TEST(Pages, PrefetchStartsBeforeIncrement) {
+  auto calls = std::make_shared<CountingPageRetriever::Calls>();
+  PrefetchPages pages(CountingPageRetriever(10, calls), 0,
+                      gax::PageFetchMode::kPrefetch);
+  auto iter = pages.begin();
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  int count = 0;
+  while (std::chrono::steady_clock::now() < deadline) {
+    {
+      std::lock_guard<std::mutex> lk(calls->mu);
+      count = calls->count;
+    }
+    if (count == 2) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // The second page was requested while the first one was being processed.
+  EXPECT_EQ(count, 2);
+  EXPECT_EQ(iter->NextPageToken(), "NextPage1");
+
+  ++iter;
+  EXPECT_EQ(iter->NextPageToken(), "NextPage2");
+}
+
+TEST(Pages, PrefetchAbandoned) {
+  auto calls = std::make_shared<CountingPageRetriever::Calls>();
+  PrefetchPages pages(CountingPageRetriever(10, calls), 0,
+                      gax::PageFetchMode::kPrefetch);
+  {
+    // Stopping early waits for the in-flight rpc.
+    auto iter = pages.begin();
+    EXPECT_EQ(iter->NextPageToken(), "NextPage1");
+  }
+  std::lock_guard<std::mutex> lk(calls->mu);
+  EXPECT_EQ(calls->count, 2);
+}
+
+// Fails the rpc for page `fail_at` (1-based), with an error or by throwing.
+class FailingPageRetriever {
+ public:
+  FailingPageRetriever(int fail_at, bool throws)
+      : retriever_(10), calls_(0), fail_at_(fail_at), throws_(throws) {}
+  gax::Status operator()(longrunning::ListOperationsResponse* lor) {
+    if (++calls_ == fail_at_) {
+      if (throws_) {
+        throw std::runtime_error("page retriever failed");
+      }
+      lor->set_next_page_token("partial page");
+      return gax::Status(gax::StatusCode::kUnavailable, "try again");
+    }
+    return retriever_(lor);
+  }
+
+ private:
+  PageRetriever retriever_;
+  int calls_;
+  int fail_at_;
+  bool throws_;
+};
+
+using FailingPages =
+    gax::Pages<longrunning::Operation, longrunning::ListOperationsResponse,
+               OperationsAccessor, FailingPageRetriever>;
+
+TEST(Pages, ErrorStatus) {
+  for (auto mode :
+       {gax::PageFetchMode::kBlocking, gax::PageFetchMode::kPrefetch}) {
+    FailingPages pages(FailingPageRetriever(3, false), 0, mode);
+    auto iter = pages.begin();
+    EXPECT_EQ(iter->NextPageToken(), "NextPage1");
+    EXPECT_TRUE(iter.status().IsOk());
+    ++iter;
+    EXPECT_TRUE(iter.status().IsOk());
+    ++iter;
+    EXPECT_EQ(iter.status().code(), gax::StatusCode::kUnavailable);
+  }
+}
+
+TEST(Pages, PrefetchErrorEndsIteration) {
+  FailingPages pages(FailingPageRetriever(3, false), 0,
+                     gax::PageFetchMode::kPrefetch);
+  int count = 0;
+  auto iter = pages.begin();
+  for (; iter != pages.end(); ++iter) {
+    ++count;
+  }
+  EXPECT_EQ(count, 2);
+  EXPECT_EQ(iter.status().code(), gax::StatusCode::kUnavailable);
+  // The partial page of the failed rpc is not shown.
+  EXPECT_EQ(iter->NextPageToken(), "");
+}
+
+TEST(Pages, PrefetchExceptionRethrownOnIncrement) {
+  FailingPages pages(FailingPageRetriever(2, true), 0,
+                     gax::PageFetchMode::kPrefetch);
+  auto iter = pages.begin();
+  EXPECT_THROW(++iter, std::runtime_error);
+}
+
+TEST(Pages, PrefetchExceptionDroppedOnDestruction) {
+  FailingPages pages(FailingPageRetriever(2, true), 0,
+                     gax::PageFetchMode::kPrefetch);
+  {
+    // The failed prefetch is never taken, destroying the iterator must not
+    // rethrow it.
+    auto iter = pages.begin();
+    EXPECT_EQ(iter->NextPageToken(), "NextPage1");
+  }
+  SUCCEED();
+}
+
+// Serves pages with the given number of operations, failing at page
+// `fail_at` (0-based) if it is set.
+class SizedPageRetriever {
+ public:
+  SizedPageRetriever(std::vector<int> sizes, std::shared_ptr<int> calls,
+                     int fail_at = -1)
+      : sizes_(std::move(sizes)),
+        calls_(std::move(calls)),
+        fail_at_(fail_at),
+        page_(0) {}
+
+  gax::Status operator()(longrunning::ListOperationsResponse* lor) {
+    ++*calls_;
+    if (page_ == fail_at_) {
+      return gax::Status(gax::StatusCode::kUnavailable, "try again");
+    }
+    for (int i = 0; i != sizes_[page_]; ++i) {
+      std::stringstream ss;
+      ss << "op-" << page_ << "-" << i;
+      lor->add_operations()->set_name(ss.str());
+    }
+    ++page_;
+    if (page_ < static_cast<int>(sizes_.size())) {
+      std::stringstream ss;
+      ss << "NextPage" << page_;
+      lor->set_next_page_token(ss.str());
+    }
+    return gax::Status{};
+  }
+
+ private:
+  std::vector<int> sizes_;
+  std::shared_ptr<int> calls_;
+  int fail_at_;
+  int page_;
+};
+
+gax::PaginatedRange<longrunning::Operation> MakeRange(
+    std::vector<int> sizes, std::shared_ptr<int> calls, int fail_at = -1) {
+  return gax::MakePaginatedRange<longrunning::Operation,
+                                 longrunning::ListOperationsResponse>(
+      SizedPageRetriever(std::move(sizes), std::move(calls), fail_at),
+      OperationsAccessor{});
+}
+
+TEST(PaginatedRange, FlattensPages) {
+  auto calls = std::make_shared<int>(0);
+  auto range = MakeRange({2, 0, 3}, calls);
+  EXPECT_EQ(*calls, 0);
+
+  std::vector<std::string> names;
+  for (auto const& op : range) {
+    names.push_back(op.name());
+  }
+  EXPECT_EQ(names, (std::vector<std::string>{"op-0-0", "op-0-1", "op-2-0",
+                                             "op-2-1", "op-2-2"}));
+  EXPECT_EQ(*calls, 3);
+  EXPECT_TRUE(range.status().IsOk());
+}
+
+TEST(PaginatedRange, FetchesLazily) {
+  auto calls = std::make_shared<int>(0);
+  auto range = MakeRange({2, 2}, calls);
+  auto iter = range.begin();
+  EXPECT_EQ(*calls, 1);
+  EXPECT_EQ(iter->name(), "op-0-0");
+  ++iter;
+  EXPECT_EQ(iter->name(), "op-0-1");
+  EXPECT_EQ(*calls, 1);
+  // The second page is only fetched when the first one runs out.
+  ++iter;
+  EXPECT_EQ(*calls, 2);
+  EXPECT_EQ(iter->name(), "op-1-0");
+  ++iter;
+  ++iter;
+  EXPECT_EQ(iter, range.end());
+  EXPECT_EQ(*calls, 2);
+}
+
+TEST(PaginatedRange, Empty) {
+  auto calls = std::make_shared<int>(0);
+  auto range = MakeRange({0}, calls);
+  EXPECT_EQ(range.begin(), range.end());
+  EXPECT_EQ(*calls, 1);
+  EXPECT_TRUE(range.status().IsOk());
+}
+
+TEST(PaginatedRange, ErrorEndsIteration) {
+  auto calls = std::make_shared<int>(0);
+  auto range = MakeRange({2, 2, 2}, calls, 1);
+  std::vector<std::string> names;
+  for (auto const& op : range) {
+    names.push_back(op.name());
+  }
+  EXPECT_EQ(names, (std::vector<std::string>{"op-0-0", "op-0-1"}));
+  EXPECT_EQ(*calls, 2);
+  EXPECT_EQ(range.status().code(), gax::StatusCode::kUnavailable);
+  EXPECT_EQ(range.status().message(), "try again");
+}
+
+TEST(PaginatedRange, ErrorOnFirstPage) {
+  auto calls = std::make_shared<int>(0);
+  auto range = MakeRange({2}, calls, 0);
+  EXPECT_EQ(range.begin(), range.end());
+  EXPECT_EQ(range.status().code(), gax::StatusCode::kUnavailable);
+}
+
+TEST(PaginatedRange, MoveElements) {
+  auto calls = std::make_shared<int>(0);
+  auto range = MakeRange({1, 1}, calls);
+  std::vector<longrunning::Operation> ops;
+  for (auto& op : range) {
+    ops.push_back(std::move(op));
+  }
+  ASSERT_EQ(ops.size(), 2U);
+  EXPECT_EQ(ops[0].name(), "op-0-0");
+  EXPECT_EQ(ops[1].name(), "op-1-0");
+}
+
 }  // namespace
@@ -0,0 +1,221 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_POLICY_HOLDER_H_
+#define GAPIC_GENERATOR_CPP_GAX_POLICY_HOLDER_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace google {
+namespace gax {
+
+/**
+ * A copyable, type-erased value holding a retry or backoff policy.
+ *
+ * Policies are prototypes: each call needs its own copy with fresh state.
+ * Cloning them through `std::unique_ptr` allocates on every call, although
+ * the policies are only a few words in size. The holder stores policies of up
+ * to @p kInlineSize bytes inline, and copies them with their copy
+ * constructors, which reset the policy state like `clone()` does. Larger
+ * policies, and policies whose dynamic type is not known when the holder is
+ * created, are cloned to the heap instead.
+ *
+ * @par Example
+ * @code
+ * gax::RetryPolicyHolder prototype(gax::LimitedErrorCountRetryPolicy<>(3, ms));
+ * gax::RetryPolicyHolder policy = prototype;  // does not allocate
+ * while (policy->OnFailure(status)) { ... }
+ * @endcode
+ *
+ * @tparam Policy the policy interface, e.g. `RetryPolicy`. It must have a
+ *     virtual destructor and a `clone()` member function.
+ * @tparam kInlineSize policies up to this size, in bytes, are stored inline.
+ */
+template <typename Policy, std::size_t kInlineSize = 64>
+class PolicyHolder {
+ public:
+  /// Create an empty holder.
+  PolicyHolder() noexcept : manager_(nullptr), policy_(nullptr) {}
+
+  /**
+   * Hold a copy of @p policy.
+   *
+   * The copy is stored inline if the static type of @p policy is also its
+   * dynamic type, it fits in the buffer, and it can be moved without
+   * throwing. Otherwise `policy.clone()` is stored.
+   */
+  template <typename T, typename std::enable_if<
+                            std::is_base_of<Policy, T>::value, int>::type = 0>
+  explicit PolicyHolder(T const& policy)
+      : PolicyHolder() {
+    Hold(policy, std::integral_constant<bool, FitsInline<T>()>{});
+  }
+
+  /// Take ownership of a policy allocated on the heap.
+  explicit PolicyHolder(std::unique_ptr<Policy> policy) noexcept
+      : PolicyHolder() {
+    if (policy) {
+      manager_ = &HeapManager;
+      policy_ = policy.release();
+    }
+  }
+
+  PolicyHolder(PolicyHolder const& rhs) : PolicyHolder() {
+    if (rhs.manager_) {
+      policy_ = rhs.manager_(Operation::kCopy, rhs.policy_, &storage_);
+      manager_ = rhs.manager_;
+    }
+  }
+
+  PolicyHolder(PolicyHolder&& rhs) noexcept : PolicyHolder() {
+    MoveFrom(rhs);
+  }
+
+  PolicyHolder& operator=(PolicyHolder const& rhs) {
+    if (this != &rhs) {
+      PolicyHolder tmp(rhs);
+      Reset();
+      MoveFrom(tmp);
+    }
+    return *this;
+  }
+
+  PolicyHolder& operator=(PolicyHolder&& rhs) noexcept {
+    if (this != &rhs) {
+      Reset();
+      MoveFrom(rhs);
+    }
+    return *this;
+  }
+
+  ~PolicyHolder() { Reset(); }
+
+  explicit operator bool() const { return policy_ != nullptr; }
+
+  Policy* get() { return policy_; }
+  Policy const* get() const { return policy_; }
+  Policy& operator*() { return *policy_; }
+  Policy const& operator*() const { return *policy_; }
+  Policy* operator->() { return policy_; }
+  Policy const* operator->() const { return policy_; }
+
+  /// Return a heap allocated copy, for APIs that take a `std::unique_ptr`.
+  std::unique_ptr<Policy> clone() const {
+    if (!policy_) {
+      return nullptr;
+    }
+    return policy_->clone();
+  }
+
+  /// Return true if the policy is stored inline, mostly for tests.
+  bool is_inline() const {
+    return policy_ != nullptr && manager_ != &HeapManager;
+  }
+
+ private:
+  enum class Operation { kCopy, kRelocate, kDestroy };
+  // Copy, relocate, or destroy the held policy. Copies and relocations
+  // construct the policy in @p storage when it is stored inline, and return
+  // the new policy.
+  using Manager = Policy* (*)(Operation, Policy*, void* storage);
+  using Storage = typename std::aligned_storage<kInlineSize>::type;
+
+  template <typename T>
+  static constexpr bool FitsInline() {
+    return sizeof(T) <= sizeof(Storage) && alignof(T) <= alignof(Storage) &&
+           std::is_copy_constructible<T>::value &&
+           std::is_nothrow_move_constructible<T>::value;
+  }
+
+  template <typename T>
+  void Hold(T const& policy, std::true_type) {
+    // A `T const&` may refer to an object of a derived class, which the copy
+    // constructor would slice.
+    if (typeid(policy) != typeid(T)) {
+      Hold(policy, std::false_type{});
+      return;
+    }
+    policy_ = ::new (static_cast<void*>(&storage_)) T(policy);
+    manager_ = &InlineManager<T>;
+  }
+
+  template <typename T>
+  void Hold(T const& policy, std::false_type) {
+    policy_ = policy.clone().release();
+    manager_ = policy_ ? &HeapManager : nullptr;
+  }
+
+  template <typename T>
+  static Policy* InlineManager(Operation op, Policy* policy, void* storage) {
+    auto* self = static_cast<T*>(policy);
+    switch (op) {
+      case Operation::kCopy:
+        return ::new (storage) T(*self);
+      case Operation::kRelocate: {
+        Policy* moved = ::new (storage) T(std::move(*self));
+        self->~T();
+        return moved;
+      }
+      case Operation::kDestroy:
+        self->~T();
+        break;
+    }
+    return nullptr;
+  }
+
+  static Policy* HeapManager(Operation op, Policy* policy, void*) {
+    switch (op) {
+      case Operation::kCopy:
+        return policy->clone().release();
+      case Operation::kRelocate:
+        return policy;
+      case Operation::kDestroy:
+        delete policy;
+        break;
+    }
+    return nullptr;
+  }
+
+  void MoveFrom(PolicyHolder& rhs) noexcept {
+    if (rhs.manager_) {
+      policy_ = rhs.manager_(Operation::kRelocate, rhs.policy_, &storage_);
+      manager_ = rhs.manager_;
+      rhs.manager_ = nullptr;
+      rhs.policy_ = nullptr;
+    }
+  }
+
+  void Reset() noexcept {
+    if (manager_) {
+      manager_(Operation::kDestroy, policy_, &storage_);
+      manager_ = nullptr;
+      policy_ = nullptr;
+    }
+  }
+
+  Manager manager_;
+  Policy* policy_;
+  Storage storage_;
+};
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_POLICY_HOLDER_H_
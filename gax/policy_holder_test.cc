@@ -0,0 +1,190 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gax/policy_holder.h"
+#include "gax/backoff_policy.h"
+#include "gax/call_context.h"
+#include "gax/retry_policy.h"
+#include "gax/status.h"
+#include <gtest/gtest.h>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace {
+// Count the allocations made by this program while `counting` is set.
+bool counting = false;
+int allocations = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+  if (counting) {
+    ++allocations;
+  }
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+namespace {
+using namespace ::google;
+using ms = std::chrono::milliseconds;
+
+// Return the number of allocations made by @p f.
+template <typename Functor>
+int CountAllocations(Functor&& f) {
+  allocations = 0;
+  counting = true;
+  f();
+  counting = false;
+  return allocations;
+}
+
+// A policy too large to be stored inline.
+class LargeRetryPolicy : public gax::RetryPolicy {
+ public:
+  LargeRetryPolicy() : failures_(0), padding_() {}
+  LargeRetryPolicy(LargeRetryPolicy const&) noexcept
+      : LargeRetryPolicy() {}
+
+  std::unique_ptr<gax::RetryPolicy> clone() const override {
+    return std::unique_ptr<gax::RetryPolicy>(new LargeRetryPolicy(*this));
+  }
+  bool OnFailure(gax::Status const&) override { return failures_++ < 1; }
+  std::chrono::steady_clock::time_point OperationDeadline() const override {
+    return std::chrono::steady_clock::time_point::max();
+  }
+
+ private:
+  int failures_;
+  std::array<char, 128> padding_;
+};
+
+gax::Status const kUnavailable(gax::StatusCode::kUnavailable, "try again");
+
+TEST(PolicyHolder, Empty) {
+  gax::RetryPolicyHolder holder;
+  EXPECT_FALSE(holder);
+  EXPECT_FALSE(holder.is_inline());
+  EXPECT_FALSE(holder.clone());
+  gax::RetryPolicyHolder copy(holder);
+  EXPECT_FALSE(copy);
+}
+
+TEST(PolicyHolder, ShippedPoliciesAreInline) {
+  EXPECT_TRUE(gax::RetryPolicyHolder(
+                  gax::LimitedErrorCountRetryPolicy<>(3, ms(10)))
+                  .is_inline());
+  EXPECT_TRUE(
+      gax::RetryPolicyHolder(gax::LimitedDurationRetryPolicy<>(ms(50), ms(10)))
+          .is_inline());
+  EXPECT_TRUE(
+      gax::BackoffPolicyHolder(gax::ExponentialBackoffPolicy(ms(1), ms(10)))
+          .is_inline());
+  EXPECT_TRUE(
+      gax::BackoffPolicyHolder(gax::FullJitterBackoffPolicy(ms(1), ms(10)))
+          .is_inline());
+  EXPECT_TRUE(gax::BackoffPolicyHolder(
+                  gax::DecorrelatedJitterBackoffPolicy(ms(1), ms(10)))
+                  .is_inline());
+}
+
+TEST(PolicyHolder, CopiesHaveFreshState) {
+  gax::RetryPolicyHolder prototype(
+      gax::LimitedErrorCountRetryPolicy<>(1, ms(10)));
+  EXPECT_TRUE(prototype->OnFailure(kUnavailable));
+  EXPECT_FALSE(prototype->OnFailure(kUnavailable));
+
+  gax::RetryPolicyHolder copy(prototype);
+  EXPECT_TRUE(copy->OnFailure(kUnavailable));
+  EXPECT_FALSE(copy->OnFailure(kUnavailable));
+
+  gax::RetryPolicyHolder assigned;
+  assigned = prototype;
+  EXPECT_TRUE(assigned->OnFailure(kUnavailable));
+}
+
+TEST(PolicyHolder, Move) {
+  gax::RetryPolicyHolder holder(gax::LimitedErrorCountRetryPolicy<>(1, ms(10)));
+  gax::RetryPolicyHolder moved(std::move(holder));
+  EXPECT_FALSE(holder);
+  EXPECT_TRUE(moved.is_inline());
+  EXPECT_TRUE(moved->OnFailure(kUnavailable));
+
+  gax::RetryPolicyHolder assigned(LargeRetryPolicy{});
+  assigned = std::move(moved);
+  EXPECT_FALSE(moved);
+  EXPECT_TRUE(assigned.is_inline());
+
+  gax::RetryPolicyHolder large(LargeRetryPolicy{});
+  auto const* policy = large.get();
+  gax::RetryPolicyHolder moved_large(std::move(large));
+  EXPECT_EQ(moved_large.get(), policy);
+}
+
+TEST(PolicyHolder, LargePoliciesAreCloned) {
+  gax::RetryPolicyHolder holder(LargeRetryPolicy{});
+  ASSERT_TRUE(holder);
+  EXPECT_FALSE(holder.is_inline());
+  EXPECT_TRUE(holder->OnFailure(kUnavailable));
+  EXPECT_FALSE(holder->OnFailure(kUnavailable));
+
+  gax::RetryPolicyHolder copy(holder);
+  EXPECT_FALSE(copy.is_inline());
+  EXPECT_TRUE(copy->OnFailure(kUnavailable));
+}
+
+TEST(PolicyHolder, PolymorphicReferencesAreCloned) {
+  gax::LimitedErrorCountRetryPolicy<> policy(1, ms(10));
+  gax::RetryPolicy const& base = policy;
+  gax::RetryPolicyHolder holder(base);
+  ASSERT_TRUE(holder);
+  EXPECT_FALSE(holder.is_inline());
+  EXPECT_TRUE(holder->OnFailure(kUnavailable));
+  EXPECT_FALSE(holder->OnFailure(kUnavailable));
+
+  gax::RetryPolicyHolder adopted(policy.clone());
+  EXPECT_FALSE(adopted.is_inline());
+  EXPECT_TRUE(adopted->OnFailure(kUnavailable));
+}
+
+TEST(PolicyHolder, CallContextDoesNotAllocate) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  gax::LimitedErrorCountRetryPolicy<> const retry_policy(3, ms(10));
+  gax::ExponentialBackoffPolicy const backoff_policy(ms(1), ms(10));
+
+  EXPECT_EQ(0, CountAllocations([&] {
+              context.SetRetryPolicy(retry_policy);
+              context.SetBackoffPolicy(backoff_policy);
+            }));
+  EXPECT_EQ(0, CountAllocations([&] {
+              gax::CallContext copy(context);
+              auto retry = copy.RetryPolicy();
+              auto backoff = copy.BackoffPolicy();
+              EXPECT_TRUE(retry->OnFailure(kUnavailable));
+              backoff->OnCompletion();
+            }));
+}
+
+}  // namespace
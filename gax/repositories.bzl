@@ -29,6 +29,13 @@ def com_google_gapic_generator_cpp_gax_repositories():
         urls = ["https://github.com/googleapis/googleapis/archive/c69355435cf6ae824a21f2bba31c69697733d3d2.tar.gz"],
     )
 
+    _maybe(
+        http_archive,
+        name = "com_github_google_benchmark",
+        strip_prefix = "benchmark-1.5.0",
+        urls = ["https://github.com/google/benchmark/archive/v1.5.0.tar.gz"],
+    )
+
 def _maybe(repo_rule, name, **kwargs):
     if name not in native.existing_rules():
         repo_rule(name = name, **kwargs)
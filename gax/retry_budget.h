@@ -0,0 +1,194 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_RETRY_BUDGET_H_
+#define GAPIC_GENERATOR_CPP_GAX_RETRY_BUDGET_H_
+
+#include "gax/retry_policy.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace google {
+namespace gax {
+
+/**
+ * Define the interface for limiting the total retry volume of a client.
+ *
+ * Retry policies are cloned for every operation, so each of them only knows
+ * about a single call. During an outage every call retries independently and
+ * the retries multiply the load on an already struggling backend. A
+ * RetryBudget is shared by many calls, usually by all the calls made through a
+ * client or a stub, and caps the retries they make as a group.
+ *
+ * The retry loop consults the budget before each re-attempt. If the budget
+ * refuses, the loop returns the last error instead of retrying.
+ *
+ * Implementations must be thread-safe: a single budget is used concurrently by
+ * all the calls that share it.
+ */
+class RetryBudget {
+ public:
+  virtual ~RetryBudget() = default;
+
+  /**
+   * Try to spend budget on a retry.
+   *
+   * @return true if the retry may proceed.
+   */
+  virtual bool TryAcquireRetry() = 0;
+
+  /**
+   * Report a successful call, which may replenish the budget.
+   */
+  virtual void OnSuccess() = 0;
+};
+
+/**
+ * A token bucket retry budget.
+ *
+ * Each retry costs one token. Every successful call deposits @p retry_ratio
+ * tokens, so in steady state the client retries at most that fraction of its
+ * successful calls. Additionally the bucket refills at
+ * @p min_retries_per_second, which lets a client with little traffic (or no
+ * successes at all) still retry occasionally. The bucket never holds more than
+ * @p max_tokens tokens, which bounds the size of a burst of retries; it starts
+ * out full.
+ *
+ * The hot path is lock-free: the balance and the last refill time are atomic
+ * counters updated with compare-and-swap loops.
+ *
+ * @par Example
+ * @code
+ * // Retry at most 10% of the successful calls, plus 1 retry per second.
+ * auto budget = std::make_shared<gax::TokenBucketRetryBudget<>>(0.1, 1.0, 10);
+ * @endcode
+ */
+template <typename Clock = DefaultClock>
+class TokenBucketRetryBudget : public RetryBudget {
+ public:
+  TokenBucketRetryBudget(double retry_ratio, double min_retries_per_second,
+                         int max_tokens, Clock c = Clock{})
+      : c_(std::move(c)),
+        deposit_(ToMilliTokens(retry_ratio)),
+        milli_tokens_per_second_(ToMilliTokens(min_retries_per_second)),
+        capacity_(ToMilliTokens(max_tokens)),
+        balance_(capacity_),
+        last_refill_(NowNanos()) {}
+
+  TokenBucketRetryBudget(TokenBucketRetryBudget const&) = delete;
+  TokenBucketRetryBudget& operator=(TokenBucketRetryBudget const&) = delete;
+
+  bool TryAcquireRetry() override {
+    Refill();
+    auto balance = balance_.load(std::memory_order_relaxed);
+    do {
+      if (balance < kMilliTokensPerToken) {
+        return false;
+      }
+    } while (!balance_.compare_exchange_weak(balance,
+                                             balance - kMilliTokensPerToken,
+                                             std::memory_order_relaxed));
+    return true;
+  }
+
+  void OnSuccess() override { Deposit(deposit_); }
+
+  /**
+   * The number of whole retries the budget currently allows.
+   *
+   * This is a snapshot, concurrent calls may change it at any time.
+   */
+  std::int64_t AvailableRetries() const {
+    return balance_.load(std::memory_order_relaxed) / kMilliTokensPerToken;
+  }
+
+ private:
+  // Tokens are stored as integer thousandths so fractional deposits do not
+  // need floating point atomics.
+  static constexpr std::int64_t kMilliTokensPerToken = 1000;
+  static constexpr std::int64_t kNanosPerSecond = 1000 * 1000 * 1000;
+
+  static std::int64_t ToMilliTokens(double tokens) {
+    return static_cast<std::int64_t>(tokens * kMilliTokensPerToken);
+  }
+
+  std::int64_t NowNanos() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               c_.now().time_since_epoch())
+        .count();
+  }
+
+  void Deposit(std::int64_t milli_tokens) {
+    if (milli_tokens <= 0) {
+      return;
+    }
+    auto balance = balance_.load(std::memory_order_relaxed);
+    std::int64_t updated;
+    do {
+      if (balance >= capacity_) {
+        return;
+      }
+      updated = std::min(capacity_, balance + milli_tokens);
+    } while (!balance_.compare_exchange_weak(balance, updated,
+                                             std::memory_order_relaxed));
+  }
+
+  // Credit the tokens accrued at the minimum rate since the last refill. Only
+  // the thread that wins the race to advance last_refill_ deposits them, so
+  // each interval is credited once.
+  void Refill() {
+    if (milli_tokens_per_second_ <= 0) {
+      return;
+    }
+    auto const now = NowNanos();
+    auto last = last_refill_.load(std::memory_order_relaxed);
+    std::int64_t accrued;
+    do {
+      if (now <= last) {
+        return;
+      }
+      // Computed in floating point: a long idle period would overflow the
+      // integer product, and the bucket caps the deposit anyway.
+      accrued = static_cast<std::int64_t>(std::min<double>(
+          static_cast<double>(capacity_),
+          static_cast<double>(now - last) * milli_tokens_per_second_ /
+              kNanosPerSecond));
+      if (accrued == 0) {
+        return;
+      }
+    } while (!last_refill_.compare_exchange_weak(last, now,
+                                                 std::memory_order_relaxed));
+    Deposit(accrued);
+  }
+
+  Clock c_;
+  std::int64_t const deposit_;
+  std::int64_t const milli_tokens_per_second_;
+  std::int64_t const capacity_;
+  std::atomic<std::int64_t> balance_;
+  std::atomic<std::int64_t> last_refill_;
+};
+
+template <typename Clock>
+constexpr std::int64_t TokenBucketRetryBudget<Clock>::kMilliTokensPerToken;
+
+template <typename Clock>
+constexpr std::int64_t TokenBucketRetryBudget<Clock>::kNanosPerSecond;
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_RETRY_BUDGET_H_
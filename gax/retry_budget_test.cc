@@ -0,0 +1,111 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/retry_budget.h"
+#include "gax/internal/test_clock.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+using namespace ::google;
+
+TEST(TokenBucketRetryBudget, StartsFull) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::TokenBucketRetryBudget<gax::internal::TestClock> tested(
+      0.1, 0, 3, gax::internal::TestClock(now_point));
+  EXPECT_EQ(tested.AvailableRetries(), 3);
+  EXPECT_TRUE(tested.TryAcquireRetry());
+  EXPECT_TRUE(tested.TryAcquireRetry());
+  EXPECT_TRUE(tested.TryAcquireRetry());
+  EXPECT_FALSE(tested.TryAcquireRetry());
+  EXPECT_EQ(tested.AvailableRetries(), 0);
+}
+
+TEST(TokenBucketRetryBudget, SuccessesDepositRatio) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::TokenBucketRetryBudget<gax::internal::TestClock> tested(
+      0.25, 0, 1, gax::internal::TestClock(now_point));
+  EXPECT_TRUE(tested.TryAcquireRetry());
+  EXPECT_FALSE(tested.TryAcquireRetry());
+
+  // Four successes earn a single retry.
+  for (int i = 0; i != 3; ++i) {
+    tested.OnSuccess();
+    EXPECT_FALSE(tested.TryAcquireRetry());
+  }
+  tested.OnSuccess();
+  EXPECT_TRUE(tested.TryAcquireRetry());
+  EXPECT_FALSE(tested.TryAcquireRetry());
+}
+
+TEST(TokenBucketRetryBudget, CapacityCapsDeposits) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::TokenBucketRetryBudget<gax::internal::TestClock> tested(
+      1, 0, 2, gax::internal::TestClock(now_point));
+  for (int i = 0; i != 10; ++i) {
+    tested.OnSuccess();
+  }
+  EXPECT_EQ(tested.AvailableRetries(), 2);
+}
+
+TEST(TokenBucketRetryBudget, MinimumRateRefills) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::TokenBucketRetryBudget<gax::internal::TestClock> tested(
+      0, 2, 5, gax::internal::TestClock(now_point));
+  while (tested.TryAcquireRetry()) {
+  }
+
+  // Two retries per second: one every 500ms, even without any successes.
+  now_point += std::chrono::milliseconds(400);
+  EXPECT_FALSE(tested.TryAcquireRetry());
+  now_point += std::chrono::milliseconds(100);
+  EXPECT_TRUE(tested.TryAcquireRetry());
+  EXPECT_FALSE(tested.TryAcquireRetry());
+
+  // A long idle period does not earn more than the capacity.
+  now_point += std::chrono::hours(24 * 365);
+  int retries = 0;
+  while (tested.TryAcquireRetry()) {
+    ++retries;
+  }
+  EXPECT_EQ(retries, 5);
+}
+
+TEST(TokenBucketRetryBudget, ConcurrentRetriesNeverOverdraw) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::TokenBucketRetryBudget<gax::internal::TestClock> tested(
+      0, 0, 100, gax::internal::TestClock(now_point));
+
+  std::atomic<int> granted(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t != 8; ++t) {
+    threads.emplace_back([&tested, &granted] {
+      for (int i = 0; i != 50; ++i) {
+        if (tested.TryAcquireRetry()) {
+          ++granted;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(granted.load(), 100);
+  EXPECT_EQ(tested.AvailableRetries(), 0);
+}
+
+}  // namespace
@@ -0,0 +1,103 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gax/backoff_policy.h"
+#include "gax/internal/fault_injection.h"
+#include "gax/internal/retry_simulation.h"
+#include "gax/internal/test_clock.h"
+#include "gax/internal/thundering_herd.h"
+#include "gax/method_config.h"
+#include "gax/status.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace {
+using namespace ::google;
+using ms = std::chrono::milliseconds;
+
+constexpr std::uint32_t kTransientCodes =
+    gax::RetryableCode(gax::StatusCode::kAborted) |
+    gax::RetryableCode(gax::StatusCode::kDeadlineExceeded) |
+    gax::RetryableCode(gax::StatusCode::kUnavailable);
+
+// The retry settings to compare. Edit or extend these tables to evaluate the
+// settings of a service config before rolling them out.
+constexpr gax::MethodRetryConfig kRetryConfigs[] = {
+    // No retries at all.
+    {"NoRetries", 0, 1, ms(30000), ms(0), ms(0), 1.0},
+    // What the generator uses for methods without a service config entry.
+    {"GeneratorDefaults", kTransientCodes, 0, ms(500), ms(20), ms(100), 2.0},
+    // A typical service config entry, as in the library example.
+    {"ServiceConfig",
+     gax::RetryableCode(gax::StatusCode::kUnavailable) |
+         gax::RetryableCode(gax::StatusCode::kDeadlineExceeded),
+     5, ms(30000), ms(100), ms(10000), 1.3},
+};
+
+// Calls through a retry loop with the same policies as the generated retry
+// stub, against a service that fails a percentage of the attempts, given by
+// the second argument, with kUnavailable. Attempt latencies have a long tail,
+// a few of them outlive the 500ms timeout of the generator defaults.
+//
+// The simulation runs on virtual time: the interesting output is in the
+// counters rather than in the timings.
+void BM_RetryGoodput(benchmark::State& state) {
+  auto const& config = kRetryConfigs[state.range(0)];
+  auto const failure_percent = static_cast<double>(state.range(1));
+  gax::internal::RetrySimulationResult result{};
+  for (auto _ : state) {
+    std::chrono::steady_clock::time_point now_point;
+    gax::internal::VirtualClock clock(now_point);
+    gax::internal::FaultInjector injector(42, clock);
+    injector.FailWith(gax::StatusCode::kUnavailable, failure_percent / 100.0)
+        .SetLatency(gax::internal::LogNormalLatency(ms(50), 1.0));
+    result = gax::internal::SimulateRetryCalls(
+        1000, injector, clock,
+        gax::MethodConfigRetryPolicy<gax::internal::VirtualClock>(config,
+                                                                  clock),
+        gax::ExponentialBackoffPolicy(
+            config.initial_backoff, config.max_backoff,
+            config.backoff_multiplier,
+            std::make_shared<gax::internal::SeededJitterSource>(42)));
+  }
+  state.SetLabel(config.rpc_name);
+  state.counters["goodput"] = result.goodput();
+  state.counters["amplification"] = result.amplification();
+  state.counters["p50_ms"] =
+      std::chrono::duration<double, std::milli>(result.p50).count();
+  state.counters["p90_ms"] =
+      std::chrono::duration<double, std::milli>(result.p90).count();
+  state.counters["p99_ms"] =
+      std::chrono::duration<double, std::milli>(result.p99).count();
+}
+
+void RetryGoodputArguments(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"config", "failure_percent"});
+  for (std::size_t config = 0; config != sizeof(kRetryConfigs) /
+                                             sizeof(kRetryConfigs[0]);
+       ++config) {
+    for (int failure_percent : {1, 10, 50}) {
+      b->Args({static_cast<int>(config), failure_percent});
+    }
+  }
+}
+BENCHMARK(BM_RetryGoodput)->Apply(RetryGoodputArguments);
+
+}  // namespace
+
+BENCHMARK_MAIN();
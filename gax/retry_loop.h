@@ -17,16 +17,206 @@
 
 #include "gax/backoff_policy.h"
 #include "gax/call_context.h"
+#include "gax/cancellation_token.h"
 #include "gax/internal/invoke_result.h"
+#include "gax/retry_observer.h"
 #include "gax/retry_policy.h"
 #include "gax/status.h"
+#include "gax/status_or.h"
+#include "gax/timer_queue.h"
+#include <algorithm>
+#include <chrono>
 #include <functional>
+#include <future>
+#include <memory>
 #include <thread>
+#include <type_traits>
+#include <utility>
 
 namespace google {
 namespace gax {
 
+namespace internal {
+
+/**
+ * Return the deadline for the next attempt.
+ *
+ * Attempts never outlive the caller's deadline, even if the retry policy
+ * would allow it.
+ */
+template <typename RetryPolicyT>
+std::chrono::steady_clock::time_point AttemptDeadline(
+    gax::CallContext const& context, RetryPolicyT const& retry_policy) {
+  return std::min(context.Deadline(), retry_policy.OperationDeadline());
+}
+
+/**
+ * Decide whether backing off for @p delay still leaves room for an attempt.
+ *
+ * The loop gives up once the next attempt could not start before the earliest
+ * of the caller's deadline and the retry policy's deadline: such an attempt
+ * would fail with DEADLINE_EXCEEDED without doing any useful work.
+ *
+ * @return an OK status if the loop should back off and try again, otherwise
+ *     the status to return to the caller. It describes why the loop stopped
+ *     and includes the last attempt's error.
+ */
+template <typename RetryPolicyT>
+gax::Status CheckBackoff(gax::Status const& last_status,
+                         gax::CallContext const& context,
+                         RetryPolicyT const& retry_policy,
+                         std::chrono::steady_clock::time_point now,
+                         std::chrono::microseconds delay) {
+  auto const deadline =
+      std::min(context.Deadline(), retry_policy.RetryDeadline());
+  if (now < deadline && delay < deadline - now) {
+    return gax::Status{};
+  }
+  return gax::Status(
+      gax::StatusCode::kDeadlineExceeded,
+      "Retry loop stopped: the deadline expires before the next attempt "
+      "could start. Last attempt failed with: " +
+          last_status.message() + " [" +
+          gax::StatusCodeToString(last_status.code()) + "]");
+}
+
+/// Report a successful call to the context's retry budget, if any.
+inline void RecordSuccess(gax::CallContext const& context) {
+  auto budget = context.RetryBudget();
+  if (budget) {
+    budget->OnSuccess();
+  }
+}
+
+/// Return true if the context's retry budget, if any, allows another attempt.
+inline bool AcquireRetry(gax::CallContext const& context) {
+  auto budget = context.RetryBudget();
+  return !budget || budget->TryAcquireRetry();
+}
+
+/// Return true if the call was cancelled through its CancellationToken.
+inline bool IsCancelled(gax::CancellationToken const* token) {
+  return token != nullptr && token->IsCancelled();
+}
+
+/// The status returned by retry loops stopped by a CancellationToken.
+inline gax::Status CancelledStatus() {
+  return gax::Status(gax::StatusCode::kCancelled,
+                     "Retry loop stopped: the call was cancelled");
+}
+
+/**
+ * Wait for @p delay before the next attempt.
+ *
+ * Clocks with a `sleep_for()` member function wait through it, which lets
+ * simulations run the loop on virtual time. Other clocks sleep for real, and
+ * wake up early if @p token, which may be null, is cancelled.
+ */
+template <typename Clock>
+auto SleepFor(Clock& clock, std::chrono::microseconds delay,
+              gax::CancellationToken*, int)
+    -> decltype(clock.sleep_for(delay), void()) {
+  clock.sleep_for(delay);
+}
+
+template <typename Clock>
+void SleepFor(Clock&, std::chrono::microseconds delay,
+              gax::CancellationToken* token, long) {
+  if (token) {
+    token->WaitFor(delay);
+    return;
+  }
+  std::this_thread::sleep_for(delay);
+}
+
+/**
+ * The retry loop shared by both MakeRetryCall overloads.
+ *
+ * The policies are used through their static types: with concrete policy
+ * types the calls need not be virtual.
+ */
+template <typename RequestT, typename ResponseT, typename FunctorT,
+          typename RetryPolicyT, typename BackoffPolicyT, typename Clock>
+gax::Status RetryLoop(gax::CallContext& context, RequestT const& request,
+                      ResponseT* response, FunctorT& next_stub,
+                      RetryPolicyT& retry_policy,
+                      BackoffPolicyT& backoff_policy, Clock& clock) {
+  auto const observer = context.RetryObserver();
+  auto const token = context.CancellationToken();
+  auto const rpc_name = context.Info().rpc_name;
+  for (int attempt = 1;; ++attempt) {
+    if (internal::IsCancelled(token.get())) {
+      return internal::CancelledStatus();
+    }
+    // The next layer stub may add metadata, so create a fresh call context
+    // each time through the loop. The copy shares the caller's settings until
+    // a lower layer modifies them, so it does not allocate.
+    gax::CallContext context_copy(context);
+    context_copy.SetDeadline(internal::AttemptDeadline(context, retry_policy));
+    std::chrono::steady_clock::time_point start;
+    if (observer) {
+      start = clock.now();
+      observer->OnAttemptStart(rpc_name, attempt, start);
+    }
+    gax::Status status = next_stub(context_copy, request, response);
+    auto const now = clock.now();
+    if (observer) {
+      observer->OnAttemptEnd(rpc_name, attempt, start, now, status);
+    }
+    if (status.IsOk()) {
+      internal::RecordSuccess(context);
+      return status;
+    }
+    if (!retry_policy.OnFailure(status) || status.IsRetryDisallowed() ||
+        internal::IsCancelled(token.get())) {
+      return status;
+    }
+
+    auto delay = backoff_policy.OnFailure(status);
+    auto stop =
+        internal::CheckBackoff(status, context, retry_policy, now, delay);
+    if (!stop.IsOk()) {
+      return stop;
+    }
+    if (!internal::AcquireRetry(context)) {
+      return status;
+    }
+    if (observer) {
+      observer->OnBackoff(rpc_name, attempt, now, delay);
+    }
+    internal::SleepFor(clock, delay, token.get(), 0);
+  }
+}
+
+}  // namespace internal
+
+/**
+ * Invoke @p next_stub until it succeeds or the policies stop the loop.
+ *
+ * Between attempts the loop sleeps for the delay returned by
+ * @p backoff_policy, or for the delay requested by the server in the failed
+ * attempt's status. If the server asked the client not to retry, the loop
+ * returns the status right away. The loop never sleeps past the caller's
+ * deadline or the retry policy's deadline: if the next attempt could not start
+ * in time it returns a `kDeadlineExceeded` status right away.
+ *
+ * If @p context has a RetryBudget, successful calls are reported to it and
+ * each re-attempt must be allowed by it. When the budget is exhausted the loop
+ * returns the last error.
+ *
+ * If @p context has a RetryObserver, each attempt and each backoff is reported
+ * to it, with timestamps from @p clock.
+ *
+ * If @p context has a CancellationToken, cancelling it cancels the attempt in
+ * flight, wakes up the loop if it is backing off, and stops the loop with a
+ * `kCancelled` status.
+ *
+ * @tparam Clock the source of the current time, used to compare the backoff
+ *     delay against the deadlines. Tests may inject a fake clock. If the clock
+ *     has a `sleep_for()` member function the loop backs off through it.
+ */
 template <typename RequestT, typename ResponseT, typename FunctorT,
+          typename Clock = gax::DefaultClock,
           typename std::enable_if<
               gax::internal::is_invocable<FunctorT, gax::CallContext&,
                                           RequestT const&, ResponseT*>::value,
@@ -34,19 +224,262 @@ template <typename RequestT, typename ResponseT, typename FunctorT,
 gax::Status MakeRetryCall(gax::CallContext& context, RequestT const& request,
                           ResponseT* response, FunctorT&& next_stub,
                           std::unique_ptr<gax::RetryPolicy> retry_policy,
-                          std::unique_ptr<gax::BackoffPolicy> backoff_policy) {
-  while (true) {
-    // The next layer stub may add metadata, so create a
-    // fresh call context each time through the loop.
-    gax::CallContext context_copy(context);
-    context_copy.SetDeadline(retry_policy->OperationDeadline());
-    gax::Status status = next_stub(context_copy, request, response);
-    if (status.IsOk() || !retry_policy->OnFailure(status)) {
-      return status;
+                          std::unique_ptr<gax::BackoffPolicy> backoff_policy,
+                          Clock clock = Clock{}) {
+  return internal::RetryLoop(context, request, response, next_stub,
+                             *retry_policy, *backoff_policy, clock);
+}
+
+/**
+ * Invoke @p next_stub until it succeeds, with policies held by value.
+ *
+ * The semantics are the same as for the overload taking polymorphic policies.
+ * The holders are typically obtained from CallContext::RetryPolicy() and
+ * CallContext::BackoffPolicy(), and store small policies inline, so no
+ * allocation is needed.
+ */
+template <typename RequestT, typename ResponseT, typename FunctorT,
+          typename Clock = gax::DefaultClock,
+          typename std::enable_if<
+              gax::internal::is_invocable<FunctorT, gax::CallContext&,
+                                          RequestT const&, ResponseT*>::value,
+              int>::type = 0>
+gax::Status MakeRetryCall(gax::CallContext& context, RequestT const& request,
+                          ResponseT* response, FunctorT&& next_stub,
+                          gax::RetryPolicyHolder retry_policy,
+                          gax::BackoffPolicyHolder backoff_policy,
+                          Clock clock = Clock{}) {
+  return internal::RetryLoop(context, request, response, next_stub,
+                             *retry_policy, *backoff_policy, clock);
+}
+
+/**
+ * Invoke @p next_stub until it succeeds, with policies of known types.
+ *
+ * The semantics are the same as for the overload taking polymorphic policies,
+ * but the policies are taken by value: nothing is cloned or allocated, and the
+ * calls to the policies can be resolved at compile time. Use this overload
+ * when the policy types are known, e.g. the defaults of a generated stub.
+ *
+ * @code
+ * gax::MakeRetryCall(context, request, &response, stub,
+ *                    gax::LimitedErrorCountRetryPolicy<>(3, ms(100)),
+ *                    gax::ExponentialBackoffPolicy(ms(10), ms(100)));
+ * @endcode
+ *
+ * @tparam RetryPolicyT a concrete type derived from RetryPolicy.
+ * @tparam BackoffPolicyT a concrete type derived from BackoffPolicy.
+ */
+template <typename RequestT, typename ResponseT, typename FunctorT,
+          typename RetryPolicyT, typename BackoffPolicyT,
+          typename Clock = gax::DefaultClock,
+          typename std::enable_if<
+              gax::internal::is_invocable<FunctorT, gax::CallContext&,
+                                          RequestT const&,
+                                          ResponseT*>::value &&
+                  std::is_base_of<gax::RetryPolicy, RetryPolicyT>::value &&
+                  std::is_base_of<gax::BackoffPolicy, BackoffPolicyT>::value,
+              int>::type = 0>
+gax::Status MakeRetryCall(gax::CallContext& context, RequestT const& request,
+                          ResponseT* response, FunctorT&& next_stub,
+                          RetryPolicyT retry_policy,
+                          BackoffPolicyT backoff_policy,
+                          Clock clock = Clock{}) {
+  return internal::RetryLoop(context, request, response, next_stub,
+                             retry_policy, backoff_policy, clock);
+}
+
+namespace internal {
+
+/**
+ * The state of a single asynchronous retry loop.
+ *
+ * The loop keeps itself alive (via shared_from_this) while an attempt is
+ * outstanding or a backoff timer is pending, and is released once the
+ * completion callback has been invoked.
+ */
+template <typename RequestT, typename ResponseT, typename AsyncFunctorT>
+class AsyncRetryLoop
+    : public std::enable_shared_from_this<
+          AsyncRetryLoop<RequestT, ResponseT, AsyncFunctorT>> {
+ public:
+  AsyncRetryLoop(gax::CallContext const& context, RequestT request,
+                 AsyncFunctorT next_stub,
+                 std::unique_ptr<gax::RetryPolicy> retry_policy,
+                 std::unique_ptr<gax::BackoffPolicy> backoff_policy,
+                 std::shared_ptr<gax::TimerQueue> timers,
+                 std::function<void(gax::StatusOr<ResponseT>)> on_completion)
+      : context_(context),
+        request_(std::move(request)),
+        next_stub_(std::move(next_stub)),
+        retry_policy_(std::move(retry_policy)),
+        backoff_policy_(std::move(backoff_policy)),
+        timers_(std::move(timers)),
+        on_completion_(std::move(on_completion)),
+        observer_(context_.RetryObserver()),
+        token_(context_.CancellationToken()),
+        attempt_(0) {}
+
+  void StartAttempt() {
+    // Same as the synchronous loop: the next layer may modify the context, so
+    // each attempt gets a fresh copy. It must outlive the attempt, so it is
+    // owned by the loop rather than the stack.
+    attempt_context_.reset(new gax::CallContext(context_));
+    attempt_context_->SetDeadline(
+        internal::AttemptDeadline(context_, *retry_policy_));
+    ++attempt_;
+    if (observer_) {
+      attempt_start_ = gax::DefaultClock{}.now();
+      observer_->OnAttemptStart(context_.Info().rpc_name, attempt_,
+                                attempt_start_);
     }
+    auto self = this->shared_from_this();
+    next_stub_(*attempt_context_, request_, &response_,
+               [self](gax::Status status) { self->OnAttempt(status); });
+  }
+
+ private:
+  void OnAttempt(gax::Status const& status) {
+    auto const now = gax::DefaultClock{}.now();
+    if (observer_) {
+      observer_->OnAttemptEnd(context_.Info().rpc_name, attempt_,
+                              attempt_start_, now, status);
+    }
+    if (status.IsOk()) {
+      internal::RecordSuccess(context_);
+      return Complete(gax::StatusOr<ResponseT>(std::move(response_)));
+    }
+    if (!retry_policy_->OnFailure(status) || status.IsRetryDisallowed() ||
+        internal::IsCancelled(token_.get())) {
+      return Complete(gax::StatusOr<ResponseT>(status));
+    }
+
+    auto delay = backoff_policy_->OnFailure(status);
+    auto stop =
+        internal::CheckBackoff(status, context_, *retry_policy_, now, delay);
+    if (!stop.IsOk()) {
+      return Complete(gax::StatusOr<ResponseT>(std::move(stop)));
+    }
+    if (!internal::AcquireRetry(context_)) {
+      return Complete(gax::StatusOr<ResponseT>(status));
+    }
+    if (observer_) {
+      observer_->OnBackoff(context_.Info().rpc_name, attempt_, now, delay);
+    }
+
+    auto self = this->shared_from_this();
+    timers_->Schedule(delay,
+                      [self](gax::Status timer_status) {
+                        if (!timer_status.IsOk()) {
+                          return self->Complete(
+                              gax::StatusOr<ResponseT>(timer_status));
+                        }
+                        if (internal::IsCancelled(self->token_.get())) {
+                          return self->Complete(gax::StatusOr<ResponseT>(
+                              internal::CancelledStatus()));
+                        }
+                        self->StartAttempt();
+                      });
+  }
 
-    std::this_thread::sleep_for(backoff_policy->OnCompletion());
+  void Complete(gax::StatusOr<ResponseT> result) {
+    // Release the callback before invoking it, anything it captured is
+    // destroyed with the loop, and the loop may outlive the call.
+    auto on_completion = std::move(on_completion_);
+    on_completion(std::move(result));
   }
+
+  gax::CallContext const context_;
+  RequestT const request_;
+  ResponseT response_;
+  AsyncFunctorT next_stub_;
+  std::unique_ptr<gax::RetryPolicy> retry_policy_;
+  std::unique_ptr<gax::BackoffPolicy> backoff_policy_;
+  std::shared_ptr<gax::TimerQueue> timers_;
+  std::function<void(gax::StatusOr<ResponseT>)> on_completion_;
+  std::shared_ptr<gax::RetryObserver> const observer_;
+  // The TimerQueue cannot cancel a timer, a cancelled loop stops when the
+  // backoff timer fires.
+  std::shared_ptr<gax::CancellationToken> const token_;
+  std::unique_ptr<gax::CallContext> attempt_context_;
+  int attempt_;
+  std::chrono::steady_clock::time_point attempt_start_;
+};
+
+}  // namespace internal
+
+/**
+ * Asynchronous counterpart of MakeRetryCall.
+ *
+ * Instead of sleeping between attempts the loop schedules the next attempt on
+ * @p timers, so no thread is blocked while the operation backs off. Many
+ * retrying calls can share a single TimerQueue.
+ *
+ * The retry and backoff policies have the same semantics as in MakeRetryCall,
+ * including giving up early when the next attempt could not start before the
+ * deadline, and consulting the context's RetryBudget and RetryObserver.
+ *
+ * @param context the call context, copied for each attempt.
+ * @param request the request, copied into the loop state.
+ * @param next_stub a functor that starts an asynchronous attempt. It is called
+ *     with the attempt context, the request, a pointer to the response, and a
+ *     callback that must be invoked exactly once with the attempt's status.
+ *     The context, request and response remain valid until then. The functor
+ *     must not block, it may be called from the TimerQueue thread.
+ * @param retry_policy decides whether a failed attempt is retried.
+ * @param backoff_policy decides how long to wait between attempts.
+ * @param timers the queue used to schedule attempts after backing off.
+ * @param on_completion invoked exactly once with the result of the operation.
+ */
+template <typename RequestT, typename ResponseT, typename AsyncFunctorT,
+          typename std::enable_if<
+              gax::internal::is_invocable<
+                  AsyncFunctorT, gax::CallContext&, RequestT const&, ResponseT*,
+                  std::function<void(gax::Status)>>::value,
+              int>::type = 0>
+void MakeAsyncRetryCall(
+    gax::CallContext const& context, RequestT request,
+    AsyncFunctorT&& next_stub, std::unique_ptr<gax::RetryPolicy> retry_policy,
+    std::unique_ptr<gax::BackoffPolicy> backoff_policy,
+    std::shared_ptr<gax::TimerQueue> timers,
+    std::function<void(gax::StatusOr<ResponseT>)> on_completion) {
+  using LoopT =
+      internal::AsyncRetryLoop<RequestT, ResponseT,
+                               typename std::decay<AsyncFunctorT>::type>;
+  auto loop = std::make_shared<LoopT>(
+      context, std::move(request), std::forward<AsyncFunctorT>(next_stub),
+      std::move(retry_policy), std::move(backoff_policy), std::move(timers),
+      std::move(on_completion));
+  loop->StartAttempt();
+}
+
+/**
+ * Asynchronous counterpart of MakeRetryCall returning a future.
+ *
+ * @see the callback overload of MakeAsyncRetryCall for the semantics of the
+ *     parameters.
+ */
+template <typename RequestT, typename ResponseT, typename AsyncFunctorT,
+          typename std::enable_if<
+              gax::internal::is_invocable<
+                  AsyncFunctorT, gax::CallContext&, RequestT const&, ResponseT*,
+                  std::function<void(gax::Status)>>::value,
+              int>::type = 0>
+std::future<gax::StatusOr<ResponseT>> MakeAsyncRetryCall(
+    gax::CallContext const& context, RequestT request,
+    AsyncFunctorT&& next_stub, std::unique_ptr<gax::RetryPolicy> retry_policy,
+    std::unique_ptr<gax::BackoffPolicy> backoff_policy,
+    std::shared_ptr<gax::TimerQueue> timers) {
+  auto promise = std::make_shared<std::promise<gax::StatusOr<ResponseT>>>();
+  auto result = promise->get_future();
+  MakeAsyncRetryCall<RequestT, ResponseT>(
+      context, std::move(request), std::forward<AsyncFunctorT>(next_stub),
+      std::move(retry_policy), std::move(backoff_policy), std::move(timers),
+      std::function<void(gax::StatusOr<ResponseT>)>(
+          [promise](gax::StatusOr<ResponseT> r) {
+            promise->set_value(std::move(r));
+          }));
+  return result;
 }
 
 }  // namespace gax
@@ -16,10 +16,20 @@
 #include "google/longrunning/operations.pb.h"
 #include "gax/backoff_policy.h"
 #include "gax/call_context.h"
+#include "gax/cancellation_token.h"
 #include "gax/internal/test_clock.h"
+#include "gax/retry_budget.h"
+#include "gax/retry_observer.h"
 #include "gax/retry_policy.h"
+#include "gax/status_or.h"
+#include "gax/timer_queue.h"
 #include <gtest/gtest.h>
 #include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace {
 using namespace ::google;
@@ -45,8 +55,27 @@ std::unique_ptr<gax::BackoffPolicy> DummyBackoffFactory(int& delay_count) {
       new DummyBackoffPolicy(delay_count));
 }
 
+// Always backs off for the same delay.
+class FixedBackoffPolicy : public gax::BackoffPolicy {
+ public:
+  FixedBackoffPolicy(std::chrono::microseconds delay) : delay_(delay) {}
+
+  std::chrono::microseconds OnCompletion() override { return delay_; }
+  std::unique_ptr<gax::BackoffPolicy> clone() const override {
+    return std::unique_ptr<FixedBackoffPolicy>(new FixedBackoffPolicy(delay_));
+  }
+
+ private:
+  std::chrono::microseconds delay_;
+};
+
+std::unique_ptr<gax::BackoffPolicy> FixedBackoffFactory(
+    std::chrono::microseconds delay) {
+  return std::unique_ptr<FixedBackoffPolicy>(new FixedBackoffPolicy(delay));
+}
+
 std::unique_ptr<gax::RetryPolicy> ErrCountRetryFactory(
-    int n, std::chrono::system_clock::time_point& now_point) {
+    int n, std::chrono::steady_clock::time_point& now_point) {
   return std::unique_ptr<
       gax::LimitedErrorCountRetryPolicy<gax::internal::TestClock>>(
       new gax::LimitedErrorCountRetryPolicy<gax::internal::TestClock>(
@@ -59,7 +88,7 @@ TEST(RetryLoop, Basic) {
   gax::CallContext context(mi);
   longrunning::GetOperationRequest req;
   longrunning::Operation resp;
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
 
   int attempts_remaining = 3;
   auto fail_until = [&attempts_remaining, &context](
@@ -93,6 +122,34 @@ TEST(RetryLoop, Basic) {
   EXPECT_EQ(delay_count, 3);
 }
 
+TEST(RetryLoop, ValuePolicies) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+  std::chrono::steady_clock::time_point now_point;
+
+  int attempts = 0;
+  auto always_fail = [&attempts](gax::CallContext&,
+                                 longrunning::GetOperationRequest const&,
+                                 longrunning::Operation*) {
+    ++attempts;
+    return gax::Status(gax::StatusCode::kUnavailable, "try again");
+  };
+
+  gax::Status status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                          longrunning::Operation>(
+      context, req, &resp, always_fail,
+      gax::LimitedErrorCountRetryPolicy<gax::internal::TestClock>(
+          3, std::chrono::milliseconds(1),
+          gax::internal::TestClock(now_point)),
+      FixedBackoffPolicy(std::chrono::microseconds(0)),
+      gax::internal::TestClock(now_point));
+  EXPECT_EQ(attempts, 4);
+  EXPECT_EQ(status, gax::Status(gax::StatusCode::kUnavailable, "try again"));
+}
+
 TEST(RetryLoop, OperationDeadline) {
   gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::CLIENT_STREAMING,
                      gax::MethodInfo::Idempotency::IDEMPOTENT};
@@ -100,16 +157,12 @@ TEST(RetryLoop, OperationDeadline) {
   longrunning::GetOperationRequest req;
   longrunning::Operation resp;
   int delay_count = 0;
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
 
   auto check_updated_deadline = [&now_point](
       gax::CallContext& ctx, longrunning::GetOperationRequest const& req,
       longrunning::Operation* resp) {
-    grpc::ClientContext test_context;
-    ctx.PrepareGrpcContext(&test_context);
-
-    EXPECT_EQ(test_context.deadline(),
-              now_point + std::chrono::milliseconds(2));
+    EXPECT_EQ(ctx.Deadline(), now_point + std::chrono::milliseconds(2));
     // Double check that we're not setting the deadline from a static
     // target.
     now_point += std::chrono::milliseconds(30);
@@ -122,4 +175,475 @@ TEST(RetryLoop, OperationDeadline) {
       ErrCountRetryFactory(3, now_point), DummyBackoffFactory(delay_count));
 }
 
+TEST(RetryLoop, AttemptDeadlineHonorsCallerDeadline) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+  int delay_count = 0;
+  std::chrono::steady_clock::time_point now_point;
+  // The caller's deadline is earlier than the retry policy's per-attempt
+  // deadline (now_point + 2ms).
+  context.SetDeadline(now_point + std::chrono::milliseconds(1));
+
+  auto check_deadline = [&now_point](gax::CallContext& ctx,
+                                     longrunning::GetOperationRequest const&,
+                                     longrunning::Operation*) {
+    EXPECT_EQ(ctx.Deadline(), now_point + std::chrono::milliseconds(1));
+    return gax::Status{};
+  };
+
+  gax::Status status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                          longrunning::Operation>(
+      context, req, &resp, check_deadline, ErrCountRetryFactory(3, now_point),
+      DummyBackoffFactory(delay_count));
+  EXPECT_TRUE(status.IsOk());
+}
+
+TEST(RetryLoop, SkipsBackoffPastCallerDeadline) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+  std::chrono::steady_clock::time_point now_point;
+  context.SetDeadline(now_point + std::chrono::milliseconds(5));
+
+  int attempts = 0;
+  auto always_fail = [&attempts](gax::CallContext&,
+                                 longrunning::GetOperationRequest const&,
+                                 longrunning::Operation*) {
+    ++attempts;
+    return gax::Status(gax::StatusCode::kUnavailable, "try again");
+  };
+
+  // Backing off for 10ms would overrun the caller's deadline, so the loop must
+  // give up after the first attempt instead of sleeping.
+  gax::Status status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                          longrunning::Operation>(
+      context, req, &resp, always_fail, ErrCountRetryFactory(10, now_point),
+      FixedBackoffFactory(std::chrono::milliseconds(10)),
+      gax::internal::TestClock(now_point));
+  EXPECT_EQ(attempts, 1);
+  EXPECT_EQ(status.code(), gax::StatusCode::kDeadlineExceeded);
+  EXPECT_NE(status.message().find("try again"), std::string::npos);
+  EXPECT_NE(status.message().find("UNAVAILABLE"), std::string::npos);
+}
+
+TEST(RetryLoop, SkipsBackoffPastRetryDeadline) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+  std::chrono::steady_clock::time_point now_point;
+
+  int attempts = 0;
+  auto slow_fail = [&attempts, &now_point](
+      gax::CallContext&, longrunning::GetOperationRequest const&,
+      longrunning::Operation*) {
+    ++attempts;
+    now_point += std::chrono::milliseconds(6);
+    return gax::Status(gax::StatusCode::kUnavailable, "try again");
+  };
+
+  // Each attempt takes 6ms and the loop backs off for 3ms, but the backoff
+  // does not advance the test clock. After three attempts the clock reads
+  // 18ms and another 3ms delay would overrun the 20ms retry deadline.
+  gax::Status status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                          longrunning::Operation>(
+      context, req, &resp, slow_fail,
+      std::unique_ptr<gax::RetryPolicy>(
+          new gax::LimitedDurationRetryPolicy<gax::internal::TestClock>(
+              std::chrono::milliseconds(20), std::chrono::milliseconds(5),
+              gax::internal::TestClock(now_point))),
+      FixedBackoffFactory(std::chrono::milliseconds(3)),
+      gax::internal::TestClock(now_point));
+  EXPECT_EQ(attempts, 3);
+  EXPECT_EQ(status.code(), gax::StatusCode::kDeadlineExceeded);
+}
+
+TEST(RetryLoop, HonorsServerRetryDelay) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+  std::chrono::steady_clock::time_point now_point;
+  context.SetDeadline(now_point + std::chrono::milliseconds(5));
+
+  int attempts = 0;
+  auto pushback = [&attempts](gax::CallContext&,
+                              longrunning::GetOperationRequest const&,
+                              longrunning::Operation*) {
+    ++attempts;
+    return gax::Status(gax::StatusCode::kUnavailable, "overloaded", "",
+                       std::chrono::milliseconds(10));
+  };
+
+  // The backoff policy alone would retry after 1ms, but the server asked for
+  // 10ms, which overruns the caller's deadline.
+  gax::Status status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                          longrunning::Operation>(
+      context, req, &resp, pushback, ErrCountRetryFactory(10, now_point),
+      FixedBackoffFactory(std::chrono::milliseconds(1)),
+      gax::internal::TestClock(now_point));
+  EXPECT_EQ(attempts, 1);
+  EXPECT_EQ(status.code(), gax::StatusCode::kDeadlineExceeded);
+  EXPECT_NE(status.message().find("overloaded"), std::string::npos);
+}
+
+TEST(RetryLoop, ServerDisallowsRetry) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+  std::chrono::steady_clock::time_point now_point;
+
+  int attempts = 0;
+  gax::Status const refused(gax::StatusCode::kUnavailable, "go away", "",
+                            gax::Status::DoNotRetry());
+  auto do_not_retry = [&attempts, &refused](
+      gax::CallContext&, longrunning::GetOperationRequest const&,
+      longrunning::Operation*) {
+    ++attempts;
+    return refused;
+  };
+
+  gax::Status status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                          longrunning::Operation>(
+      context, req, &resp, do_not_retry, ErrCountRetryFactory(10, now_point),
+      FixedBackoffFactory(std::chrono::milliseconds(0)),
+      gax::internal::TestClock(now_point));
+  EXPECT_EQ(attempts, 1);
+  EXPECT_EQ(status, refused);
+}
+
+// Record the callbacks as strings, to compare them in one go.
+class RecordingObserver : public gax::RetryObserver {
+ public:
+  explicit RecordingObserver(std::chrono::steady_clock::time_point origin)
+      : origin_(origin) {}
+
+  void OnAttemptStart(char const* rpc_name, int attempt,
+                      std::chrono::steady_clock::time_point start) override {
+    events.push_back(std::string(rpc_name) + " start " +
+                     std::to_string(attempt) + " at " + Ms(start));
+  }
+  void OnAttemptEnd(char const* rpc_name, int attempt,
+                    std::chrono::steady_clock::time_point start,
+                    std::chrono::steady_clock::time_point end,
+                    gax::Status const& status) override {
+    events.push_back(std::string(rpc_name) + " end " +
+                     std::to_string(attempt) + " after " +
+                     std::to_string((end - start) / ms(1)) + "ms " +
+                     gax::StatusCodeToString(status.code()));
+  }
+  void OnBackoff(char const* rpc_name, int attempt,
+                 std::chrono::steady_clock::time_point now,
+                 std::chrono::microseconds delay) override {
+    events.push_back(std::string(rpc_name) + " backoff " +
+                     std::to_string(attempt) + " at " + Ms(now) + " for " +
+                     std::to_string(delay / ms(1)) + "ms");
+  }
+
+  std::vector<std::string> events;
+
+ private:
+  using ms = std::chrono::milliseconds;
+  std::string Ms(std::chrono::steady_clock::time_point tp) const {
+    return std::to_string((tp - origin_) / ms(1)) + "ms";
+  }
+
+  std::chrono::steady_clock::time_point origin_;
+};
+
+TEST(RetryLoop, RetryObserver) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+  std::chrono::steady_clock::time_point now_point;
+  auto observer = std::make_shared<RecordingObserver>(now_point);
+  context.SetRetryObserver(observer);
+
+  int attempts = 0;
+  auto fail_twice = [&attempts, &now_point](
+      gax::CallContext&, longrunning::GetOperationRequest const&,
+      longrunning::Operation*) {
+    now_point += std::chrono::milliseconds(5);
+    if (++attempts < 3) {
+      return gax::Status(gax::StatusCode::kUnavailable, "try again");
+    }
+    return gax::Status{};
+  };
+
+  gax::Status status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                          longrunning::Operation>(
+      context, req, &resp, fail_twice, ErrCountRetryFactory(10, now_point),
+      FixedBackoffFactory(std::chrono::milliseconds(0)),
+      gax::internal::TestClock(now_point));
+  EXPECT_TRUE(status.IsOk());
+  std::vector<std::string> const expected = {
+      "TestMethod start 1 at 0ms",
+      "TestMethod end 1 after 5ms UNAVAILABLE",
+      "TestMethod backoff 1 at 5ms for 0ms",
+      "TestMethod start 2 at 5ms",
+      "TestMethod end 2 after 5ms UNAVAILABLE",
+      "TestMethod backoff 2 at 10ms for 0ms",
+      "TestMethod start 3 at 10ms",
+      "TestMethod end 3 after 5ms OK",
+  };
+  EXPECT_EQ(observer->events, expected);
+}
+
+TEST(RetryLoop, RetryBudget) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+  std::chrono::steady_clock::time_point now_point;
+  // Two retries in the bucket, and each success earns half a retry.
+  auto budget = std::make_shared<
+      gax::TokenBucketRetryBudget<gax::internal::TestClock>>(
+      0.5, 0, 2, gax::internal::TestClock(now_point));
+  context.SetRetryBudget(budget);
+
+  int attempts = 0;
+  auto always_fail = [&attempts](gax::CallContext&,
+                                 longrunning::GetOperationRequest const&,
+                                 longrunning::Operation*) {
+    ++attempts;
+    return gax::Status(gax::StatusCode::kUnavailable, "try again");
+  };
+  auto succeed = [](gax::CallContext&, longrunning::GetOperationRequest const&,
+                    longrunning::Operation*) { return gax::Status{}; };
+
+  int delay_count = 0;
+  // The retry policy allows 10 retries, but the budget only allows two.
+  gax::Status status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                          longrunning::Operation>(
+      context, req, &resp, always_fail, ErrCountRetryFactory(10, now_point),
+      DummyBackoffFactory(delay_count));
+  EXPECT_EQ(status, gax::Status(gax::StatusCode::kUnavailable, "try again"));
+  EXPECT_EQ(attempts, 3);
+
+  // Once the budget is exhausted failures are not retried at all.
+  attempts = 0;
+  gax::MakeRetryCall<longrunning::GetOperationRequest, longrunning::Operation>(
+      context, req, &resp, always_fail, ErrCountRetryFactory(10, now_point),
+      DummyBackoffFactory(delay_count));
+  EXPECT_EQ(attempts, 1);
+
+  // Successful calls replenish the budget for everybody sharing it.
+  for (int i = 0; i != 2; ++i) {
+    gax::MakeRetryCall<longrunning::GetOperationRequest,
+                       longrunning::Operation>(
+        context, req, &resp, succeed, ErrCountRetryFactory(10, now_point),
+        DummyBackoffFactory(delay_count));
+  }
+  attempts = 0;
+  gax::MakeRetryCall<longrunning::GetOperationRequest, longrunning::Operation>(
+      context, req, &resp, always_fail, ErrCountRetryFactory(10, now_point),
+      DummyBackoffFactory(delay_count));
+  EXPECT_EQ(attempts, 2);
+}
+
+TEST(RetryLoop, CancelWakesBackoff) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  auto token = std::make_shared<gax::CancellationToken>();
+  context.SetCancellationToken(token);
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+
+  int attempts = 0;
+  auto always_fail = [&attempts](gax::CallContext&,
+                                 longrunning::GetOperationRequest const&,
+                                 longrunning::Operation*) {
+    ++attempts;
+    return gax::Status(gax::StatusCode::kUnavailable, "Unavailable");
+  };
+
+  std::thread canceller([token] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    token->Cancel();
+  });
+  auto const start = std::chrono::steady_clock::now();
+  // Without the cancellation the loop would back off for a minute.
+  auto status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                   longrunning::Operation>(
+      context, req, &resp, always_fail,
+      gax::LimitedErrorCountRetryPolicy<>(10, std::chrono::minutes(5)),
+      FixedBackoffPolicy(std::chrono::minutes(1)));
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+  canceller.join();
+  EXPECT_EQ(status.code(), gax::StatusCode::kCancelled);
+  EXPECT_EQ(attempts, 1);
+  EXPECT_LT(elapsed, std::chrono::seconds(30));
+}
+
+TEST(RetryLoop, CancelledCallMakesNoAttempts) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  auto token = std::make_shared<gax::CancellationToken>();
+  context.SetCancellationToken(token);
+  token->Cancel();
+  longrunning::GetOperationRequest req;
+  longrunning::Operation resp;
+
+  int attempts = 0;
+  auto succeed = [&attempts](gax::CallContext&,
+                             longrunning::GetOperationRequest const&,
+                             longrunning::Operation*) {
+    ++attempts;
+    return gax::Status{};
+  };
+  int delay_count = 0;
+  std::chrono::steady_clock::time_point now_point;
+  auto status = gax::MakeRetryCall<longrunning::GetOperationRequest,
+                                   longrunning::Operation>(
+      context, req, &resp, succeed, ErrCountRetryFactory(10, now_point),
+      DummyBackoffFactory(delay_count));
+  EXPECT_EQ(status.code(), gax::StatusCode::kCancelled);
+  EXPECT_EQ(attempts, 0);
+}
+
+TEST(AsyncRetryLoop, Basic) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  req.set_name("test-operation");
+  std::chrono::steady_clock::time_point now_point;
+  auto timers = std::make_shared<gax::TimerQueue>();
+
+  int attempts_remaining = 3;
+  auto fail_until = [&attempts_remaining](
+      gax::CallContext&, longrunning::GetOperationRequest const& req,
+      longrunning::Operation* resp, std::function<void(gax::Status)> done) {
+    if ((attempts_remaining--) > 1) {
+      done(gax::Status(gax::StatusCode::kAborted, "Aborted"));
+    } else {
+      resp->set_name(req.name());
+      done(gax::Status{});
+    }
+  };
+
+  int delay_count = 0;
+  auto succeed = gax::MakeAsyncRetryCall<longrunning::GetOperationRequest,
+                                         longrunning::Operation>(
+      context, req, fail_until, ErrCountRetryFactory(10, now_point),
+      DummyBackoffFactory(delay_count), timers);
+  auto result = succeed.get();
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(result->name(), "test-operation");
+  EXPECT_EQ(attempts_remaining, 0);
+  EXPECT_EQ(delay_count, 2);
+
+  delay_count = 0;
+  attempts_remaining = 10;
+  auto retry_timeout =
+      gax::MakeAsyncRetryCall<longrunning::GetOperationRequest,
+                              longrunning::Operation>(
+          context, req, fail_until, ErrCountRetryFactory(3, now_point),
+          DummyBackoffFactory(delay_count), timers);
+  EXPECT_EQ(retry_timeout.get().status(),
+            gax::Status(gax::StatusCode::kAborted, "Aborted"));
+  EXPECT_EQ(attempts_remaining, 6);
+  EXPECT_EQ(delay_count, 3);
+}
+
+TEST(AsyncRetryLoop, CompletionCallback) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  std::chrono::steady_clock::time_point now_point;
+  auto timers = std::make_shared<gax::TimerQueue>();
+
+  auto permanent_failure = [](gax::CallContext&,
+                              longrunning::GetOperationRequest const&,
+                              longrunning::Operation*,
+                              std::function<void(gax::Status)> done) {
+    done(gax::Status(gax::StatusCode::kNotFound, "NotFound"));
+  };
+
+  int delay_count = 0;
+  int completions = 0;
+  gax::MakeAsyncRetryCall<longrunning::GetOperationRequest,
+                          longrunning::Operation>(
+      context, req, permanent_failure, ErrCountRetryFactory(10, now_point),
+      DummyBackoffFactory(delay_count), timers,
+      [&completions](gax::StatusOr<longrunning::Operation> result) {
+        completions++;
+        EXPECT_EQ(result.status(),
+                  gax::Status(gax::StatusCode::kNotFound, "NotFound"));
+      });
+  // Permanent failures are not retried, so the loop completes inline.
+  EXPECT_EQ(completions, 1);
+  EXPECT_EQ(delay_count, 0);
+}
+
+TEST(AsyncRetryLoop, TimerQueueShutdown) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  longrunning::GetOperationRequest req;
+  std::chrono::steady_clock::time_point now_point;
+  auto timers = std::make_shared<gax::TimerQueue>();
+  timers->Shutdown();
+
+  int attempts = 0;
+  auto always_fail = [&attempts](gax::CallContext&,
+                                 longrunning::GetOperationRequest const&,
+                                 longrunning::Operation*,
+                                 std::function<void(gax::Status)> done) {
+    attempts++;
+    done(gax::Status(gax::StatusCode::kUnavailable, "Unavailable"));
+  };
+
+  int delay_count = 0;
+  auto result = gax::MakeAsyncRetryCall<longrunning::GetOperationRequest,
+                                        longrunning::Operation>(
+      context, req, always_fail, ErrCountRetryFactory(10, now_point),
+      DummyBackoffFactory(delay_count), timers);
+  EXPECT_EQ(result.get().status().code(), gax::StatusCode::kCancelled);
+  EXPECT_EQ(attempts, 1);
+}
+
+TEST(AsyncRetryLoop, CancelDuringBackoff) {
+  gax::MethodInfo mi{"TestMethod", gax::MethodInfo::RpcType::NORMAL_RPC,
+                     gax::MethodInfo::Idempotency::IDEMPOTENT};
+  gax::CallContext context(mi);
+  auto token = std::make_shared<gax::CancellationToken>();
+  context.SetCancellationToken(token);
+  longrunning::GetOperationRequest req;
+  std::chrono::steady_clock::time_point now_point;
+  auto timers = std::make_shared<gax::TimerQueue>();
+
+  int attempts = 0;
+  auto fail_and_cancel = [&attempts, token](
+      gax::CallContext&, longrunning::GetOperationRequest const&,
+      longrunning::Operation*, std::function<void(gax::Status)> done) {
+    attempts++;
+    token->Cancel();
+    done(gax::Status(gax::StatusCode::kUnavailable, "Unavailable"));
+  };
+
+  auto result = gax::MakeAsyncRetryCall<longrunning::GetOperationRequest,
+                                        longrunning::Operation>(
+      context, req, fail_and_cancel, ErrCountRetryFactory(10, now_point),
+      FixedBackoffFactory(std::chrono::milliseconds(1)), timers);
+  EXPECT_EQ(result.get().status().code(), gax::StatusCode::kUnavailable);
+  EXPECT_EQ(attempts, 1);
+  timers->Shutdown();
+}
+
 }  // namespace
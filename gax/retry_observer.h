@@ -0,0 +1,95 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_RETRY_OBSERVER_H_
+#define GAPIC_GENERATOR_CPP_GAX_RETRY_OBSERVER_H_
+
+#include "gax/status.h"
+#include <chrono>
+
+namespace google {
+namespace gax {
+
+/**
+ * Observe the attempts made by a retry loop.
+ *
+ * The retry loops report every attempt, and every backoff between attempts,
+ * to the observer attached to the call's CallContext. This is enough to build
+ * per-attempt latency histograms, count retries, or find calls whose tail
+ * latency is dominated by backoff, without decorating every stub.
+ *
+ * The callbacks run inline in the retry loop, on the thread making the
+ * attempt, so they should be cheap and must not block. A single observer is
+ * usually shared by many concurrent calls, implementations must be
+ * thread-safe. The default implementations do nothing.
+ *
+ * @par Example
+ * @code
+ * class LatencyRecorder : public gax::RetryObserver {
+ *  public:
+ *   void OnAttemptEnd(char const* rpc_name, int attempt,
+ *                     std::chrono::steady_clock::time_point start,
+ *                     std::chrono::steady_clock::time_point end,
+ *                     gax::Status const& status) override {
+ *     histogram_.Record(rpc_name, end - start);
+ *   }
+ *   // ...
+ * };
+ * context.SetRetryObserver(std::make_shared<LatencyRecorder>());
+ * @endcode
+ */
+class RetryObserver {
+ public:
+  virtual ~RetryObserver() = default;
+
+  /**
+   * Called before each attempt.
+   *
+   * @param rpc_name the name of the method, from its MethodInfo.
+   * @param attempt the attempt number, starting at 1.
+   * @param start when the attempt started.
+   */
+  virtual void OnAttemptStart(char const* /* rpc_name */, int /* attempt */,
+                              std::chrono::steady_clock::time_point
+                              /* start */) {}
+
+  /**
+   * Called after each attempt, with its result.
+   *
+   * @param end when the attempt completed, `end - start` is its latency.
+   * @param status the status returned by the attempt.
+   */
+  virtual void OnAttemptEnd(char const* /* rpc_name */, int /* attempt */,
+                            std::chrono::steady_clock::time_point /* start */,
+                            std::chrono::steady_clock::time_point /* end */,
+                            gax::Status const& /* status */) {}
+
+  /**
+   * Called when the loop backs off after a failed attempt.
+   *
+   * Not called if the loop gives up instead.
+   *
+   * @param attempt the attempt that failed.
+   * @param now when the backoff starts.
+   * @param delay how long the loop waits before the next attempt.
+   */
+  virtual void OnBackoff(char const* /* rpc_name */, int /* attempt */,
+                         std::chrono::steady_clock::time_point /* now */,
+                         std::chrono::microseconds /* delay */) {}
+};
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_RETRY_OBSERVER_H_
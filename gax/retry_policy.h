@@ -15,6 +15,8 @@
 #ifndef GAPIC_GENERATOR_CPP_GAX_RETRY_POLICY_H_
 #define GAPIC_GENERATOR_CPP_GAX_RETRY_POLICY_H_
 
+#include "gax/clock.h"
+#include "gax/policy_holder.h"
 #include "gax/status.h"
 #include <algorithm>
 #include <chrono>
@@ -62,16 +64,25 @@ class RetryPolicy {
    *
    * @return the _deadline_ for the next RPC, NOT its maximum _duration_.
    */
-  virtual std::chrono::system_clock::time_point OperationDeadline() const = 0;
-};
+  virtual std::chrono::steady_clock::time_point OperationDeadline() const = 0;
 
-class DefaultClock {
- public:
-  std::chrono::system_clock::time_point now() const {
-    return std::chrono::system_clock::now();
+  /**
+   * Return the time after which no further attempts will be made.
+   *
+   * The retry loop uses this to avoid backing off past the point where the
+   * policy would give up anyway: an attempt that cannot start before this
+   * deadline is never made.
+   *
+   * Policies that are not bounded by time need not override this function.
+   */
+  virtual std::chrono::steady_clock::time_point RetryDeadline() const {
+    return std::chrono::steady_clock::time_point::max();
   }
 };
 
+/// A copyable retry policy, stored inline when it is small enough.
+using RetryPolicyHolder = PolicyHolder<RetryPolicy>;
+
 /**
  * Implement a simple "count errors and then stop" retry policy.
  */
@@ -105,7 +116,7 @@ class LimitedErrorCountRetryPolicy : public RetryPolicy {
     return !status.IsPermanentFailure() && failure_count_++ < max_failures_;
   }
 
-  std::chrono::system_clock::time_point OperationDeadline() const override {
+  std::chrono::steady_clock::time_point OperationDeadline() const override {
     return c_.now() + rpc_duration_;
   }
 
@@ -150,15 +161,19 @@ class LimitedDurationRetryPolicy : public RetryPolicy {
     return !status.IsPermanentFailure() && c_.now() < deadline_;
   }
 
-  std::chrono::system_clock::time_point OperationDeadline() const override {
+  std::chrono::steady_clock::time_point OperationDeadline() const override {
     return std::min(deadline_, c_.now() + rpc_duration_);
   }
 
+  std::chrono::steady_clock::time_point RetryDeadline() const override {
+    return deadline_;
+  }
+
  private:
   Clock c_;
   std::chrono::milliseconds const rpc_duration_;
   std::chrono::milliseconds const max_duration_;
-  std::chrono::system_clock::time_point const deadline_;
+  std::chrono::steady_clock::time_point const deadline_;
 };
 
 }  // namespace gax
@@ -85,7 +85,7 @@ TEST(LimitedErrorCountRetryPolicy, Clone) {
 }
 
 TEST(LimitedErrorCountRetryPolicy, OperationDeadline) {
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
   gax::LimitedErrorCountRetryPolicy<gax::internal::TestClock> tested(
       3, std::chrono::milliseconds(30), gax::internal::TestClock(now_point));
 
@@ -98,7 +98,7 @@ TEST(LimitedErrorCountRetryPolicy, OperationDeadline) {
 }
 
 TEST(LimitedDurationRetryPolicy, Basic) {
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
   gax::LimitedDurationRetryPolicy<gax::internal::TestClock> tested(
       std::chrono::milliseconds(5), std::chrono::milliseconds(30),
       gax::internal::TestClock(now_point));
@@ -113,7 +113,7 @@ TEST(LimitedDurationRetryPolicy, Basic) {
 }
 
 TEST(LimitedDurationRetryPolicy, PermanentFailureCheck) {
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
   gax::LimitedDurationRetryPolicy<gax::internal::TestClock> tested(
       std::chrono::milliseconds(5), std::chrono::milliseconds(30),
       gax::internal::TestClock(now_point));
@@ -123,7 +123,7 @@ TEST(LimitedDurationRetryPolicy, PermanentFailureCheck) {
 }
 
 TEST(LimitedDurationRetryPolicy, CopyConstruct) {
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
   gax::LimitedDurationRetryPolicy<gax::internal::TestClock> tested(
       std::chrono::milliseconds(5), std::chrono::milliseconds(30),
       gax::internal::TestClock(now_point));
@@ -137,7 +137,7 @@ TEST(LimitedDurationRetryPolicy, CopyConstruct) {
 }
 
 TEST(LimitedDurationRetryPolicy, MoveConstruct) {
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
   gax::LimitedDurationRetryPolicy<gax::internal::TestClock> tested(
       std::chrono::milliseconds(5), std::chrono::milliseconds(30),
       gax::internal::TestClock(now_point));
@@ -152,7 +152,7 @@ TEST(LimitedDurationRetryPolicy, MoveConstruct) {
 }
 
 TEST(LimitedDurationRetryPolicy, Clone) {
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
   gax::LimitedDurationRetryPolicy<gax::internal::TestClock> tested(
       std::chrono::milliseconds(5), std::chrono::milliseconds(30),
       gax::internal::TestClock(now_point));
@@ -166,7 +166,7 @@ TEST(LimitedDurationRetryPolicy, Clone) {
 }
 
 TEST(LimitedDurationRetryPolicy, OperationDeadline) {
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
   gax::LimitedDurationRetryPolicy<gax::internal::TestClock> tested(
       std::chrono::milliseconds(500), std::chrono::milliseconds(30),
       gax::internal::TestClock(now_point));
@@ -180,7 +180,7 @@ TEST(LimitedDurationRetryPolicy, OperationDeadline) {
 }
 
 TEST(LimitedDurationRetryPolicy, OperationDeadlineCap) {
-  std::chrono::system_clock::time_point now_point;
+  std::chrono::steady_clock::time_point now_point;
   gax::LimitedDurationRetryPolicy<gax::internal::TestClock> tested(
       std::chrono::milliseconds(500), std::chrono::milliseconds(30),
       gax::internal::TestClock(now_point));
@@ -191,4 +191,23 @@ TEST(LimitedDurationRetryPolicy, OperationDeadlineCap) {
             now_point + std::chrono::milliseconds(10));
 }
 
+TEST(LimitedErrorCountRetryPolicy, RetryDeadline) {
+  gax::LimitedErrorCountRetryPolicy<> tested(3, std::chrono::milliseconds(30));
+  EXPECT_EQ(tested.RetryDeadline(),
+            std::chrono::steady_clock::time_point::max());
+}
+
+TEST(LimitedDurationRetryPolicy, RetryDeadline) {
+  std::chrono::steady_clock::time_point now_point;
+  gax::LimitedDurationRetryPolicy<gax::internal::TestClock> tested(
+      std::chrono::milliseconds(500), std::chrono::milliseconds(30),
+      gax::internal::TestClock(now_point));
+  auto const deadline = now_point + std::chrono::milliseconds(500);
+  EXPECT_EQ(tested.RetryDeadline(), deadline);
+
+  // The deadline is fixed when the policy is created, not when it is queried.
+  now_point += std::chrono::milliseconds(50);
+  EXPECT_EQ(tested.RetryDeadline(), deadline);
+}
+
 }  // namespace
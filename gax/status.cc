@@ -12,14 +12,35 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdlib>
+#include <map>
 #include <ostream>
 #include <string>
 
 #include "gax/status.h"
+#include "google/rpc/error_details.pb.h"
+#include "google/rpc/status.pb.h"
 
 namespace google {
 namespace gax {
 
+Status::Status(StatusCode code, std::string msg, std::string error_details,
+               std::chrono::milliseconds retry_delay)
+    : rep_(nullptr) {
+  // A plain OK status needs no storage.
+  if (code == StatusCode::kOk && msg.empty() && error_details.empty() &&
+      retry_delay == NoRetryDelay()) {
+    return;
+  }
+  rep_ = new Rep{{1}, code, std::move(msg), std::move(error_details),
+                 retry_delay};
+}
+
+std::string const& Status::EmptyString() {
+  static auto const* const kEmpty = new std::string;
+  return *kEmpty;
+}
+
 std::string StatusCodeToString(StatusCode code) {
   switch (code) {
     case StatusCode::kOk:
@@ -69,8 +90,87 @@ std::ostream& operator<<(std::ostream& os, Status const& rhs) {
   return os << rhs.message() << " [" << rhs.code() << "]";
 }
 
+namespace {
+
+// Find the delay in a google.rpc.RetryInfo error detail, if there is one. A
+// negative delay is malformed and treated as no advice, a delay longer than
+// Status::MaxRetryDelay() is clamped to it.
+std::chrono::milliseconds RetryInfoDelay(std::string const& error_details) {
+  google::rpc::Status proto;
+  if (error_details.empty() || !proto.ParseFromString(error_details)) {
+    return Status::NoRetryDelay();
+  }
+  for (auto const& detail : proto.details()) {
+    google::rpc::RetryInfo retry_info;
+    if (!detail.Is<google::rpc::RetryInfo>() ||
+        !detail.UnpackTo(&retry_info) || !retry_info.has_retry_delay()) {
+      continue;
+    }
+    auto const& delay = retry_info.retry_delay();
+    if (delay.seconds() < 0 || delay.nanos() < 0) {
+      return Status::NoRetryDelay();
+    }
+    // Compare before converting, the seconds may overflow nanoseconds.
+    auto const max_seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        Status::MaxRetryDelay());
+    if (delay.seconds() >= max_seconds.count()) {
+      return Status::MaxRetryDelay();
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::seconds(delay.seconds()) +
+        std::chrono::nanoseconds(delay.nanos()));
+  }
+  return Status::NoRetryDelay();
+}
+
+// Parse the grpc-retry-pushback-ms trailing metadata. A negative value, or
+// one that is not a number, means the server does not want the call retried.
+// A value longer than Status::MaxRetryDelay() is clamped to it.
+std::chrono::milliseconds PushbackDelay(
+    std::multimap<grpc::string_ref, grpc::string_ref> const& metadata) {
+  auto it = metadata.find("grpc-retry-pushback-ms");
+  if (it == metadata.end()) {
+    return Status::NoRetryDelay();
+  }
+  std::string const value(it->second.data(), it->second.size());
+  char* end = nullptr;
+  auto const ms = std::strtoll(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || ms < 0) {
+    return Status::DoNotRetry();
+  }
+  // strtoll() saturates at LLONG_MAX on overflow, which is clamped too.
+  if (ms >= Status::MaxRetryDelay().count()) {
+    return Status::MaxRetryDelay();
+  }
+  return std::chrono::milliseconds(ms);
+}
+
+}  // namespace
+
 Status GrpcStatusToGaxStatus(grpc::Status s) {
-  return Status(static_cast<StatusCode>(s.error_code()), s.error_message());
+  auto retry_delay = RetryInfoDelay(s.error_details());
+  return Status(static_cast<StatusCode>(s.error_code()), s.error_message(),
+                s.error_details(), retry_delay);
+}
+
+Status GrpcStatusToGaxStatus(
+    grpc::Status s,
+    std::multimap<grpc::string_ref, grpc::string_ref> const& trailing_metadata) {
+  if (s.ok()) {
+    return Status{};
+  }
+  auto retry_delay = PushbackDelay(trailing_metadata);
+  if (retry_delay == Status::NoRetryDelay()) {
+    retry_delay = RetryInfoDelay(s.error_details());
+  }
+  return Status(static_cast<StatusCode>(s.error_code()), s.error_message(),
+                s.error_details(), retry_delay);
+}
+
+Status GrpcStatusToGaxStatus(grpc::Status s,
+                             grpc::ClientContext const& context) {
+  return GrpcStatusToGaxStatus(std::move(s),
+                               context.GetServerTrailingMetadata());
 }
 
 }  // namespace gax
@@ -15,9 +15,14 @@
 #ifndef GAPIC_GENERATOR_CPP_GAX_STATUS_H_
 #define GAPIC_GENERATOR_CPP_GAX_STATUS_H_
 
+#include "grpcpp/client_context.h"
 #include "grpcpp/impl/codegen/status.h"
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <ostream>
 #include <string>
+#include <utility>
 
 namespace google {
 namespace gax {
@@ -54,37 +59,137 @@ enum class StatusCode {
  *
  * This class is modeled after `grpc::Status`.
  * It contains the status code and error message(if applicable) from an RPC.
+ *
+ * A failed RPC may also carry the server's advice on retrying it: either a
+ * delay to wait before the next attempt, or a request not to retry at all.
+ * Servers send this advice in the `grpc-retry-pushback-ms` trailing metadata
+ * or in a `google.rpc.RetryInfo` error detail.
+ *
+ * A Status is a single pointer, null for OK. Errors keep their code, message
+ * and details in an immutable, reference-counted block: creating an error
+ * allocates once, while returning, copying and moving a Status never does.
  */
 class Status {
  public:
-  Status() : code_(StatusCode::kOk) {}
+  Status() noexcept : rep_(nullptr) {}
   Status(StatusCode code, std::string msg)
-      : code_(code), msg_(std::move(msg)) {}
-  Status(Status const& rhs) : Status(rhs.code_, rhs.msg_) {}
-  Status(Status&& rhs) : Status(rhs.code_, std::move(rhs.msg_)) {}
+      : Status(code, std::move(msg), std::string{}, NoRetryDelay()) {}
+  /**
+   * @param error_details the serialized `google.rpc.Status` sent by the
+   *     server, if any.
+   * @param retry_delay the delay requested by the server before the next
+   *     attempt, `NoRetryDelay()` if the server did not request any, or
+   *     `DoNotRetry()` if the server asked the client not to retry.
+   */
+  Status(StatusCode code, std::string msg, std::string error_details,
+         std::chrono::milliseconds retry_delay);
+
+  Status(Status const& rhs) noexcept : rep_(rhs.rep_) { Ref(); }
+  Status(Status&& rhs) noexcept : rep_(rhs.rep_) { rhs.rep_ = nullptr; }
+
+  Status& operator=(Status const& rhs) noexcept {
+    Status tmp(rhs);
+    std::swap(rep_, tmp.rep_);
+    return *this;
+  }
+  Status& operator=(Status&& rhs) noexcept {
+    Status tmp(std::move(rhs));
+    std::swap(rep_, tmp.rep_);
+    return *this;
+  }
 
-  inline bool IsOk() const { return code_ == StatusCode::kOk; }
+  ~Status() { Unref(); }
+
+  /// The server did not say when to retry.
+  static std::chrono::milliseconds NoRetryDelay() {
+    return std::chrono::milliseconds::min();
+  }
+  /// The server asked the client not to retry.
+  static std::chrono::milliseconds DoNotRetry() {
+    return std::chrono::milliseconds(-1);
+  }
+  /**
+   * The longest delay accepted from a server, longer requests are clamped.
+   *
+   * Retry advice comes from the server and is not trusted: an unbounded
+   * value would overflow when converted to finer durations.
+   */
+  static std::chrono::milliseconds MaxRetryDelay() {
+    return std::chrono::hours(1);
+  }
+
+  inline bool IsOk() const { return code() == StatusCode::kOk; }
   inline bool IsTransientFailure() const {
-    return (code_ == StatusCode::kAborted ||
-            code_ == StatusCode::kUnavailable ||
-            code_ == StatusCode::kDeadlineExceeded);
+    auto const c = code();
+    return (c == StatusCode::kAborted || c == StatusCode::kUnavailable ||
+            c == StatusCode::kDeadlineExceeded);
   }
   inline bool IsPermanentFailure() const {
     return !IsOk() && !IsTransientFailure();
   }
 
-  inline StatusCode code() const { return code_; }
+  inline StatusCode code() const {
+    return rep_ ? rep_->code : StatusCode::kOk;
+  }
 
-  inline std::string const& message() const { return msg_; }
+  inline std::string const& message() const {
+    return rep_ ? rep_->message : EmptyString();
+  }
+
+  /// The serialized `google.rpc.Status` sent by the server, if any.
+  inline std::string const& error_details() const {
+    return rep_ ? rep_->error_details : EmptyString();
+  }
+
+  /// True if the server requested a delay before the next attempt.
+  inline bool HasRetryDelay() const {
+    return retry_delay() >= std::chrono::milliseconds::zero();
+  }
+  /// True if the server asked the client not to retry.
+  inline bool IsRetryDisallowed() const {
+    auto const delay = retry_delay();
+    return delay < std::chrono::milliseconds::zero() &&
+           delay != NoRetryDelay();
+  }
+  /// The delay requested by the server, only meaningful if HasRetryDelay().
+  inline std::chrono::milliseconds retry_delay() const {
+    return rep_ ? rep_->retry_delay : NoRetryDelay();
+  }
 
   bool operator==(Status const& rhs) const {
-    return code_ == rhs.code_ && msg_ == rhs.msg_;
+    if (rep_ == rhs.rep_) {
+      return true;
+    }
+    return code() == rhs.code() && message() == rhs.message() &&
+           error_details() == rhs.error_details() &&
+           retry_delay() == rhs.retry_delay();
   }
   bool operator!=(Status const& rhs) const { return !(*this == rhs); }
 
  private:
-  StatusCode const code_;
-  std::string const msg_;
+  // Shared by the copies of a Status, and never modified once created.
+  struct Rep {
+    std::atomic<int> refs;
+    StatusCode const code;
+    std::string const message;
+    std::string const error_details;
+    std::chrono::milliseconds const retry_delay;
+  };
+
+  static std::string const& EmptyString();
+
+  void Ref() noexcept {
+    if (rep_) {
+      rep_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  void Unref() noexcept {
+    if (rep_ && rep_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete rep_;
+    }
+  }
+
+  Rep* rep_;
 };
 
 std::string StatusCodeToString(StatusCode code);
@@ -93,6 +198,21 @@ std::ostream& operator<<(std::ostream& os, Status const& rhs);
 
 Status GrpcStatusToGaxStatus(grpc::Status s);
 
+/**
+ * Convert the result of an RPC, including the server's retry advice.
+ *
+ * The retry advice is taken from the `grpc-retry-pushback-ms` entry in
+ * @p trailing_metadata or, failing that, from a `google.rpc.RetryInfo` in the
+ * status error details.
+ */
+Status GrpcStatusToGaxStatus(
+    grpc::Status s,
+    std::multimap<grpc::string_ref, grpc::string_ref> const& trailing_metadata);
+
+/// Convert the result of an RPC made with @p context.
+Status GrpcStatusToGaxStatus(grpc::Status s,
+                             grpc::ClientContext const& context);
+
 }  // namespace gax
 }  // namespace google
 
@@ -0,0 +1,123 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/status.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <string>
+#include <utility>
+
+namespace {
+using namespace ::google;
+
+// The layout gax::Status had before it became a single pointer, kept to
+// compare against.
+class LegacyStatus {
+ public:
+  LegacyStatus() : LegacyStatus(gax::StatusCode::kOk, std::string{}) {}
+  LegacyStatus(gax::StatusCode code, std::string msg)
+      : code_(code),
+        msg_(std::move(msg)),
+        error_details_(),
+        retry_delay_(gax::Status::NoRetryDelay()) {}
+  LegacyStatus(LegacyStatus const& rhs) = default;
+  // The const members turn moves into copies.
+  LegacyStatus(LegacyStatus&& rhs) = default;
+
+  bool IsOk() const { return code_ == gax::StatusCode::kOk; }
+  gax::StatusCode code() const { return code_; }
+
+ private:
+  gax::StatusCode const code_;
+  std::string const msg_;
+  std::string const error_details_;
+  std::chrono::milliseconds const retry_delay_;
+};
+
+// Long enough to defeat the small string optimization, as most server
+// error messages are.
+std::string const& ErrorMessage() {
+  static auto const* const kMessage = new std::string(
+      "The service is currently unavailable, try again later");
+  return *kMessage;
+}
+
+template <typename StatusT>
+StatusT MakeStatus(bool ok) {
+  return ok ? StatusT{}
+            : StatusT(gax::StatusCode::kUnavailable, ErrorMessage());
+}
+
+// A status returned through a few stub layers, by value, as the decorator
+// stubs do.
+template <typename StatusT>
+StatusT Layer(int depth, bool ok) {
+  if (depth == 0) {
+    return MakeStatus<StatusT>(ok);
+  }
+  StatusT status = Layer<StatusT>(depth - 1, ok);
+  return status;
+}
+
+template <typename StatusT>
+void BM_StatusSize(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(StatusT{});
+  }
+  state.counters["bytes"] = sizeof(StatusT);
+}
+BENCHMARK_TEMPLATE(BM_StatusSize, LegacyStatus);
+BENCHMARK_TEMPLATE(BM_StatusSize, gax::Status);
+
+// The common case: every layer returns OK.
+template <typename StatusT>
+void BM_ReturnOk(benchmark::State& state) {
+  int depth = 4;
+  benchmark::DoNotOptimize(depth);
+  for (auto _ : state) {
+    auto status = Layer<StatusT>(depth, true);
+    benchmark::DoNotOptimize(status.IsOk());
+  }
+}
+BENCHMARK_TEMPLATE(BM_ReturnOk, LegacyStatus);
+BENCHMARK_TEMPLATE(BM_ReturnOk, gax::Status);
+
+// An error created once and passed up the layers.
+template <typename StatusT>
+void BM_ReturnError(benchmark::State& state) {
+  int depth = 4;
+  benchmark::DoNotOptimize(depth);
+  for (auto _ : state) {
+    auto status = Layer<StatusT>(depth, false);
+    benchmark::DoNotOptimize(status.code());
+  }
+}
+BENCHMARK_TEMPLATE(BM_ReturnError, LegacyStatus);
+BENCHMARK_TEMPLATE(BM_ReturnError, gax::Status);
+
+// Copying an error, e.g. when a retry loop keeps the last failure.
+template <typename StatusT>
+void BM_CopyError(benchmark::State& state) {
+  auto const error = MakeStatus<StatusT>(false);
+  for (auto _ : state) {
+    StatusT copy(error);
+    benchmark::DoNotOptimize(copy.code());
+  }
+}
+BENCHMARK_TEMPLATE(BM_CopyError, LegacyStatus);
+BENCHMARK_TEMPLATE(BM_CopyError, gax::Status);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -19,10 +19,24 @@
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace google {
 namespace gax {
 
+/**
+ * Tag type selecting the in-place constructor of `StatusOr<T>`.
+ *
+ * @see StatusOr::StatusOr(InPlaceT, Args&&...)
+ */
+struct InPlaceT {
+  explicit InPlaceT() = default;
+};
+
+/// The `InPlaceT` tag value.
+constexpr InPlaceT kInPlace{};
+
 /**
  * Holds a value or a `Status` indicating why there is no value.
  *
@@ -72,6 +86,16 @@ namespace gax {
  * }
  * @endcode
  *
+ * Large values can be built directly in the `StatusOr<T>` storage, either with
+ * the `kInPlace` constructor or `emplace()`, and filled through a pointer:
+ *
+ * @code
+ * StatusOr<Response> response(kInPlace);
+ * Status status = FillResponse(&*response);
+ * if (!status.IsOk()) response = std::move(status);
+ * return response;
+ * @endcode
+ *
  * TODO(...) - the current implementation is fairly naive with respect to `T`,
  *   it is unlikely to work correctly for reference types, arrays, and so forth.
  *
@@ -119,22 +143,114 @@ class StatusOr final {
 
   StatusOr(T&& rhs) : status_() { new (&value_) T(std::move(rhs)); }
 
+  /**
+   * Creates a new `StatusOr<T>` holding a `T` constructed from @p args,
+   * without any intermediate copy or move.
+   *
+   * @par Post-conditions
+   * `ok() == true`.
+   */
+  template <typename... Args>
+  explicit StatusOr(InPlaceT, Args&&... args) : status_() {
+    new (&value_) T(std::forward<Args>(args)...);
+  }
+
   StatusOr(StatusOr const& rhs) : status_(rhs.status_) {
     if (ok()) {
       new (&value_) T(rhs.value_);
     }
   }
 
-  StatusOr(StatusOr&& rhs) : status_(std::move(rhs.status_)) {
+  /**
+   * Moves the value or the status out of @p rhs.
+   *
+   * @p rhs keeps its status, and if it held a value it still holds the
+   * moved-from value.
+   */
+  StatusOr(StatusOr&& rhs) noexcept(
+      std::is_nothrow_move_constructible<T>::value)
+      : status_(rhs.status_) {
     if (ok()) {
       new (&value_) T(std::move(rhs.value_));
     }
   }
 
-  ~StatusOr() {
+  ~StatusOr() { reset(); }
+
+  StatusOr& operator=(StatusOr const& rhs) {
+    if (this == &rhs) {
+      return *this;
+    }
+    if (rhs.ok()) {
+      assign(rhs.value_);
+    } else {
+      reset();
+      status_ = rhs.status_;
+    }
+    return *this;
+  }
+
+  /// Moves the value or the status out of @p rhs, see the move constructor.
+  StatusOr& operator=(StatusOr&& rhs) noexcept(
+      std::is_nothrow_move_constructible<T>::value&&
+          std::is_nothrow_move_assignable<T>::value) {
+    if (this == &rhs) {
+      return *this;
+    }
+    if (rhs.ok()) {
+      assign(std::move(rhs.value_));
+    } else {
+      reset();
+      status_ = rhs.status_;
+    }
+    return *this;
+  }
+
+  /**
+   * Replaces the contents with the error condition @p rhs, destroying any
+   * value. Assigning an OK status is not permitted and invokes `std::abort()`.
+   */
+  StatusOr& operator=(Status rhs) {
+    if (rhs.IsOk()) {
+      std::cerr << "Assigning OK status to StatusOr<T> is not allowed"
+                << std::endl;
+      std::abort();
+    }
+    reset();
+    status_ = std::move(rhs);
+    return *this;
+  }
+
+  StatusOr& operator=(T const& rhs) {
+    assign(rhs);
+    return *this;
+  }
+
+  StatusOr& operator=(T&& rhs) {
+    assign(std::move(rhs));
+    return *this;
+  }
+
+  /**
+   * Destroys any current value and constructs a new one in place from
+   * @p args.
+   *
+   * @par Post-conditions
+   * `ok() == true`. If the constructor of `T` throws, `ok() == false` and the
+   * exception propagates.
+   *
+   * @return a reference to the new value.
+   */
+  template <typename... Args>
+  T& emplace(Args&&... args) {
     if (ok()) {
       value_.~T();
+      // Until the new value exists the object must not claim to hold one.
+      status_ = NoValueStatus();
     }
+    new (&value_) T(std::forward<Args>(args)...);
+    status_ = Status();
+    return value_;
   }
 
   /**
@@ -198,6 +314,28 @@ class StatusOr final {
   }
 
  private:
+  void reset() {
+    if (ok()) {
+      value_.~T();
+    }
+  }
+
+  template <typename U>
+  void assign(U&& rhs) {
+    if (ok()) {
+      value_ = std::forward<U>(rhs);
+    } else {
+      new (&value_) T(std::forward<U>(rhs));
+      status_ = Status();
+    }
+  }
+
+  static Status const& NoValueStatus() {
+    static auto const* const kStatus = new Status(
+        StatusCode::kUnknown, "StatusOr<T>::emplace() did not construct T");
+    return *kStatus;
+  }
+
   void check_value() const {
     if (!ok()) {
       std::cerr << status_ << std::endl;
@@ -205,7 +343,7 @@ class StatusOr final {
     }
   }
 
-  Status const status_;
+  Status status_;
   union {
     T value_;
   };
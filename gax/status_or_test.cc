@@ -17,6 +17,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 
@@ -30,6 +31,8 @@ class Observable {
   static int value_constructor;
   static int copy_constructor;
   static int move_constructor;
+  static int copy_assignment;
+  static int move_assignment;
   static int destructor;
 
   static void reset_counters() {
@@ -37,6 +40,8 @@ class Observable {
     value_constructor = 0;
     copy_constructor = 0;
     move_constructor = 0;
+    copy_assignment = 0;
+    move_assignment = 0;
     destructor = 0;
   }
   Observable() { ++default_constructor; }
@@ -48,6 +53,17 @@ class Observable {
     rhs.str_ = "moved-out";
     ++move_constructor;
   }
+  Observable& operator=(Observable const& rhs) {
+    str_ = rhs.str_;
+    ++copy_assignment;
+    return *this;
+  }
+  Observable& operator=(Observable&& rhs) {
+    str_ = std::move(rhs.str_);
+    rhs.str_ = "moved-out";
+    ++move_assignment;
+    return *this;
+  }
   ~Observable() { ++destructor; }
 
   bool operator==(Observable const& rhs) const { return str_ == rhs.str_; }
@@ -64,10 +80,16 @@ int Observable::default_constructor;
 int Observable::value_constructor;
 int Observable::copy_constructor;
 int Observable::move_constructor;
+int Observable::copy_assignment;
+int Observable::move_assignment;
 int Observable::destructor;
 
 static_assert(!std::is_default_constructible<gax::StatusOr<int>>::value,
               "Default constructed StatusOr is unhelpful.");
+static_assert(std::is_nothrow_move_constructible<gax::StatusOr<int>>::value,
+              "StatusOr moves should not throw for nothrow T.");
+static_assert(std::is_nothrow_move_assignable<gax::StatusOr<int>>::value,
+              "StatusOr moves should not throw for nothrow T.");
 
 // Although production use is not going to use simple types,
 // testing StatusOr<int> is useful for very basic tests.
@@ -241,4 +263,153 @@ TEST(StatusOrObservableTest, MoveValue) {
   EXPECT_EQ("moved-out", tested->str());
 }
 
+TEST(StatusOr, ConstructInPlace) {
+  Observable::reset_counters();
+  gax::StatusOr<Observable> tested(gax::kInPlace, "in place");
+  EXPECT_TRUE(tested.ok());
+  EXPECT_EQ(tested->str(), "in place");
+  EXPECT_EQ(Observable::value_constructor, 1);
+  EXPECT_EQ(Observable::copy_constructor, 0);
+  EXPECT_EQ(Observable::move_constructor, 0);
+
+  gax::StatusOr<Observable> defaulted(gax::kInPlace);
+  EXPECT_TRUE(defaulted.ok());
+  EXPECT_EQ(Observable::default_constructor, 1);
+}
+
+TEST(StatusOr, Emplace) {
+  gax::StatusOr<Observable> tested(
+      gax::Status(gax::StatusCode::kUnknown, "Because"));
+  Observable::reset_counters();
+  auto& value = tested.emplace("first");
+  EXPECT_TRUE(tested.ok());
+  EXPECT_EQ(&value, &*tested);
+  EXPECT_EQ(tested->str(), "first");
+  EXPECT_EQ(Observable::value_constructor, 1);
+  EXPECT_EQ(Observable::destructor, 0);
+
+  // Replacing a value destroys the old one.
+  tested.emplace("second");
+  EXPECT_EQ(tested->str(), "second");
+  EXPECT_EQ(Observable::value_constructor, 2);
+  EXPECT_EQ(Observable::destructor, 1);
+  EXPECT_EQ(Observable::copy_constructor, 0);
+  EXPECT_EQ(Observable::move_constructor, 0);
+}
+
+TEST(StatusOr, AssignStatus) {
+  gax::StatusOr<Observable> tested(gax::kInPlace, "value");
+  Observable::reset_counters();
+  tested = gax::Status(gax::StatusCode::kNotFound, "Missing");
+  EXPECT_FALSE(tested.ok());
+  EXPECT_EQ(tested.status().code(), gax::StatusCode::kNotFound);
+  EXPECT_EQ(Observable::destructor, 1);
+
+  tested = gax::Status(gax::StatusCode::kCancelled, "Because");
+  EXPECT_EQ(tested.status().code(), gax::StatusCode::kCancelled);
+  EXPECT_EQ(Observable::destructor, 1);
+}
+
+TEST(StatusOr, AssignOkStatusFails) {
+  gax::StatusOr<int> tested(42);
+  EXPECT_DEATH(tested = gax::Status(),
+               "Assigning OK status to StatusOr<T> is not allowed");
+}
+
+TEST(StatusOr, AssignValue) {
+  gax::StatusOr<Observable> tested(
+      gax::Status(gax::StatusCode::kUnknown, "Because"));
+  Observable::reset_counters();
+  tested = Observable("first");
+  EXPECT_TRUE(tested.ok());
+  EXPECT_EQ(tested->str(), "first");
+  EXPECT_EQ(Observable::move_constructor, 1);
+
+  // With a value present the value is assigned, not reconstructed.
+  Observable second("second");
+  tested = second;
+  EXPECT_EQ(tested->str(), "second");
+  EXPECT_EQ(Observable::copy_assignment, 1);
+  EXPECT_EQ(Observable::copy_constructor, 0);
+}
+
+TEST(StatusOr, CopyAssign) {
+  gax::StatusOr<Observable> failed(
+      gax::Status(gax::StatusCode::kUnknown, "Because"));
+  gax::StatusOr<Observable> succeeded(gax::kInPlace, "value");
+  gax::StatusOr<Observable> tested(failed);
+
+  Observable::reset_counters();
+  tested = succeeded;
+  EXPECT_TRUE(tested.ok());
+  EXPECT_EQ(tested->str(), "value");
+  EXPECT_EQ(Observable::copy_constructor, 1);
+
+  tested = succeeded;
+  EXPECT_EQ(Observable::copy_assignment, 1);
+
+  tested = failed;
+  EXPECT_FALSE(tested.ok());
+  EXPECT_EQ(tested.status(), failed.status());
+  EXPECT_EQ(Observable::destructor, 1);
+}
+
+TEST(StatusOr, MoveAssign) {
+  gax::StatusOr<Observable> tested(
+      gax::Status(gax::StatusCode::kUnknown, "Because"));
+  gax::StatusOr<Observable> succeeded(gax::kInPlace, "value");
+
+  Observable::reset_counters();
+  tested = std::move(succeeded);
+  EXPECT_TRUE(tested.ok());
+  EXPECT_EQ(tested->str(), "value");
+  EXPECT_EQ(succeeded->str(), "moved-out");
+  EXPECT_EQ(Observable::move_constructor, 1);
+  EXPECT_EQ(Observable::copy_constructor, 0);
+
+  tested = gax::StatusOr<Observable>(gax::kInPlace, "other");
+  EXPECT_EQ(tested->str(), "other");
+  EXPECT_EQ(Observable::move_assignment, 1);
+
+  gax::StatusOr<Observable> failed(
+      gax::Status(gax::StatusCode::kCancelled, "Why not?"));
+  tested = std::move(failed);
+  EXPECT_FALSE(tested.ok());
+  EXPECT_EQ(tested.status().code(), gax::StatusCode::kCancelled);
+  // A moved-from StatusOr keeps its status.
+  EXPECT_EQ(failed.status().code(), gax::StatusCode::kCancelled);
+}
+
+class ThrowOnConstruct {
+ public:
+  static int live;
+  explicit ThrowOnConstruct(bool fail) {
+    if (fail) throw std::runtime_error("construction failed");
+    ++live;
+  }
+  ThrowOnConstruct(ThrowOnConstruct const&) { ++live; }
+  ~ThrowOnConstruct() { --live; }
+};
+
+int ThrowOnConstruct::live;
+
+TEST(StatusOr, EmplaceThrows) {
+  ThrowOnConstruct::live = 0;
+  {
+    gax::StatusOr<ThrowOnConstruct> tested(gax::kInPlace, false);
+    EXPECT_EQ(ThrowOnConstruct::live, 1);
+    EXPECT_THROW(tested.emplace(true), std::runtime_error);
+    // The old value is gone, and the object no longer claims to hold one.
+    EXPECT_EQ(ThrowOnConstruct::live, 0);
+    EXPECT_FALSE(tested.ok());
+    EXPECT_EQ(tested.status().code(), gax::StatusCode::kUnknown);
+
+    tested.emplace(false);
+    EXPECT_TRUE(tested.ok());
+    EXPECT_EQ(ThrowOnConstruct::live, 1);
+  }
+  // The destructor ran exactly once for each constructed value.
+  EXPECT_EQ(ThrowOnConstruct::live, 0);
+}
+
 }  // namespace
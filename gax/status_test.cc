@@ -13,9 +13,17 @@
 // limitations under the License.
 
 #include "gax/status.h"
+#include "google/rpc/error_details.pb.h"
+#include "google/rpc/status.pb.h"
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 namespace {
 
@@ -241,4 +249,158 @@ TEST(Status, CopyCtor) {
   EXPECT_EQ(cancelled1, cancelled2);
 }
 
+static_assert(sizeof(gax::Status) == sizeof(void*),
+              "Status must be a single pointer");
+static_assert(std::is_nothrow_move_constructible<gax::Status>::value,
+              "Status moves must not throw");
+static_assert(std::is_nothrow_move_assignable<gax::Status>::value,
+              "Status moves must not throw");
+
+TEST(Status, Assignment) {
+  gax::Status s;
+  gax::Status const cancelled(gax::StatusCode::kCancelled, "Because");
+  s = cancelled;
+  EXPECT_EQ(s, cancelled);
+  // Copies share the message.
+  EXPECT_EQ(&s.message(), &cancelled.message());
+
+  s = gax::Status(gax::StatusCode::kNotFound, "Missing");
+  EXPECT_EQ(s.code(), gax::StatusCode::kNotFound);
+  EXPECT_EQ(s.message(), "Missing");
+  EXPECT_EQ(cancelled.code(), gax::StatusCode::kCancelled);
+
+  s = gax::Status{};
+  EXPECT_TRUE(s.IsOk());
+  EXPECT_TRUE(s.message().empty());
+  EXPECT_TRUE(s.error_details().empty());
+  EXPECT_FALSE(s.HasRetryDelay());
+}
+
+TEST(Status, Move) {
+  gax::Status cancelled(gax::StatusCode::kCancelled, "Because");
+  auto const* message = &cancelled.message();
+  gax::Status moved(std::move(cancelled));
+  EXPECT_EQ(moved.code(), gax::StatusCode::kCancelled);
+  EXPECT_EQ(&moved.message(), message);
+  // The moved-from status is OK, and can be assigned again.
+  EXPECT_TRUE(cancelled.IsOk());
+  cancelled = std::move(moved);
+  EXPECT_EQ(cancelled.message(), "Because");
+  EXPECT_TRUE(moved.IsOk());
+
+  // An OK status may still carry a message.
+  gax::Status ok(gax::StatusCode::kOk, "Because");
+  gax::Status ok_moved(std::move(ok));
+  EXPECT_TRUE(ok_moved.IsOk());
+  EXPECT_EQ(ok_moved.message(), "Because");
+}
+
+TEST(Status, RetryAdvice) {
+  gax::Status none(gax::StatusCode::kUnavailable, "");
+  EXPECT_FALSE(none.HasRetryDelay());
+  EXPECT_FALSE(none.IsRetryDisallowed());
+
+  gax::Status delay(gax::StatusCode::kUnavailable, "", "",
+                    std::chrono::milliseconds(10));
+  EXPECT_TRUE(delay.HasRetryDelay());
+  EXPECT_FALSE(delay.IsRetryDisallowed());
+  EXPECT_EQ(delay.retry_delay(), std::chrono::milliseconds(10));
+  EXPECT_NE(none, delay);
+
+  gax::Status refused(gax::StatusCode::kUnavailable, "", "",
+                      gax::Status::DoNotRetry());
+  EXPECT_FALSE(refused.HasRetryDelay());
+  EXPECT_TRUE(refused.IsRetryDisallowed());
+
+  gax::Status copy(delay);
+  EXPECT_EQ(copy, delay);
+}
+
+TEST(Status, GrpcRetryInfo) {
+  rpc::RetryInfo retry_info;
+  retry_info.mutable_retry_delay()->set_seconds(2);
+  retry_info.mutable_retry_delay()->set_nanos(500000000);
+  rpc::Status proto;
+  proto.set_code(grpc::StatusCode::UNAVAILABLE);
+  proto.set_message("overloaded");
+  proto.add_details()->PackFrom(retry_info);
+  std::string details;
+  ASSERT_TRUE(proto.SerializeToString(&details));
+
+  auto s = gax::GrpcStatusToGaxStatus(
+      grpc::Status(grpc::StatusCode::UNAVAILABLE, "overloaded", details));
+  EXPECT_EQ(s.code(), gax::StatusCode::kUnavailable);
+  EXPECT_EQ(s.message(), "overloaded");
+  EXPECT_EQ(s.error_details(), details);
+  EXPECT_TRUE(s.HasRetryDelay());
+  EXPECT_EQ(s.retry_delay(), std::chrono::milliseconds(2500));
+}
+
+gax::Status RetryInfoStatus(std::int64_t seconds, std::int32_t nanos) {
+  rpc::RetryInfo retry_info;
+  retry_info.mutable_retry_delay()->set_seconds(seconds);
+  retry_info.mutable_retry_delay()->set_nanos(nanos);
+  rpc::Status proto;
+  proto.set_code(grpc::StatusCode::UNAVAILABLE);
+  proto.add_details()->PackFrom(retry_info);
+  std::string details;
+  proto.SerializeToString(&details);
+  return gax::GrpcStatusToGaxStatus(
+      grpc::Status(grpc::StatusCode::UNAVAILABLE, "overloaded", details));
+}
+
+TEST(Status, GrpcRetryInfoHuge) {
+  auto s = RetryInfoStatus(std::numeric_limits<std::int64_t>::max(), 0);
+  EXPECT_TRUE(s.HasRetryDelay());
+  EXPECT_EQ(s.retry_delay(), gax::Status::MaxRetryDelay());
+
+  // Converting the clamped delay for the backoff loop does not overflow.
+  std::chrono::microseconds const us = s.retry_delay();
+  EXPECT_GT(us, std::chrono::microseconds::zero());
+
+  s = RetryInfoStatus(3 * 3600, 0);
+  EXPECT_EQ(s.retry_delay(), gax::Status::MaxRetryDelay());
+}
+
+TEST(Status, GrpcRetryInfoNegative) {
+  // Negative delays are malformed, they are not advice to stop retrying.
+  for (auto const& s :
+       {RetryInfoStatus(-1, 0), RetryInfoStatus(0, -1000000),
+        RetryInfoStatus(std::numeric_limits<std::int64_t>::min(), 0)}) {
+    EXPECT_FALSE(s.HasRetryDelay());
+    EXPECT_FALSE(s.IsRetryDisallowed());
+  }
+}
+
+TEST(Status, GrpcRetryPushback) {
+  grpc::Status const unavailable(grpc::StatusCode::UNAVAILABLE, "overloaded");
+  std::multimap<grpc::string_ref, grpc::string_ref> metadata;
+  auto s = gax::GrpcStatusToGaxStatus(unavailable, metadata);
+  EXPECT_FALSE(s.HasRetryDelay());
+  EXPECT_FALSE(s.IsRetryDisallowed());
+
+  metadata.emplace("grpc-retry-pushback-ms", "250");
+  EXPECT_EQ(gax::GrpcStatusToGaxStatus(unavailable, metadata).retry_delay(),
+            std::chrono::milliseconds(250));
+
+  metadata.clear();
+  metadata.emplace("grpc-retry-pushback-ms", "-1");
+  EXPECT_TRUE(
+      gax::GrpcStatusToGaxStatus(unavailable, metadata).IsRetryDisallowed());
+
+  // Huge values are clamped, including ones that overflow strtoll().
+  for (auto const* value : {"3600001", "9223372036854775807",
+                            "99999999999999999999999"}) {
+    metadata.clear();
+    metadata.emplace("grpc-retry-pushback-ms", value);
+    auto huge = gax::GrpcStatusToGaxStatus(unavailable, metadata);
+    EXPECT_TRUE(huge.HasRetryDelay()) << value;
+    EXPECT_EQ(huge.retry_delay(), gax::Status::MaxRetryDelay()) << value;
+  }
+
+  // Successful calls carry no advice.
+  EXPECT_EQ(gax::GrpcStatusToGaxStatus(grpc::Status::OK, metadata),
+            gax::Status{});
+}
+
 }  // namespace
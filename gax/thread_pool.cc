@@ -0,0 +1,94 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gax/thread_pool.h"
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace google {
+namespace gax {
+
+ThreadPool::ThreadPool(std::size_t threads, std::size_t max_queued)
+    : state_(std::make_shared<State>(threads == 0 ? 1 : threads,
+                                     max_queued)) {
+  if (threads == 0) {
+    threads = 1;
+  }
+  workers_.reserve(threads);
+  for (std::size_t i = 0; i != threads; ++i) {
+    workers_.emplace_back(&ThreadPool::Run, state_);
+  }
+}
+
+ThreadPool::~ThreadPool() { Shutdown(); }
+
+bool ThreadPool::TrySubmit(Task task) {
+  {
+    std::lock_guard<std::mutex> lk(state_->mu);
+    if (state_->shutdown ||
+        state_->tasks.size() >= state_->max_queued + state_->idle) {
+      return false;
+    }
+    state_->tasks.push_back(std::move(task));
+  }
+  state_->cv.notify_one();
+  return true;
+}
+
+void ThreadPool::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lk(state_->mu);
+    state_->shutdown = true;
+  }
+  state_->cv.notify_all();
+  std::vector<std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lk(workers_mu_);
+    workers.swap(workers_);
+  }
+  for (auto& worker : workers) {
+    // A task may release the last reference to the pool, a thread cannot
+    // join itself.
+    if (worker.get_id() == std::this_thread::get_id()) {
+      worker.detach();
+    } else {
+      worker.join();
+    }
+  }
+}
+
+void ThreadPool::Run(std::shared_ptr<State> state) {
+  std::unique_lock<std::mutex> lk(state->mu);
+  while (true) {
+    state->cv.wait(
+        lk, [&state] { return state->shutdown || !state->tasks.empty(); });
+    if (state->tasks.empty()) {
+      // Only reached once shut down, after the queue is drained.
+      return;
+    }
+    Task task = std::move(state->tasks.front());
+    state->tasks.pop_front();
+    --state->idle;
+    lk.unlock();
+    task();
+    // Destroy the task before taking the lock, it may own the pool.
+    task = nullptr;
+    lk.lock();
+    ++state->idle;
+  }
+}
+
+}  // namespace gax
+}  // namespace google
@@ -0,0 +1,108 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef GAPIC_GENERATOR_CPP_GAX_THREAD_POOL_H_
+#define GAPIC_GENERATOR_CPP_GAX_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace gax {
+
+/**
+ * A fixed set of worker threads with a bounded queue of tasks.
+ *
+ * Work that must run off the calling thread, e.g. the backup attempts of
+ * hedged calls, is submitted here instead of starting a thread per task, so
+ * the number of threads stays fixed however many calls fan out. A single
+ * ThreadPool is intended to be shared by many stubs.
+ *
+ * A task that cannot be queued is rejected, never blocked on: callers decide
+ * what to do without it, e.g. skip an optional backup attempt.
+ *
+ * Every accepted task runs exactly once, even if the pool is shut down while
+ * it is queued.
+ *
+ * @par Example
+ * @code
+ * auto pool = std::make_shared<gax::ThreadPool>(4, 64);
+ * if (!pool->TrySubmit([] { std::cout << "on a worker" << std::endl; })) {
+ *   // The queue is full, or the pool is shut down.
+ * }
+ * @endcode
+ */
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  /**
+   * @param threads the number of worker threads, at least 1.
+   * @param max_queued the maximum number of tasks waiting for a busy worker.
+   *     Tasks an idle worker can take right away are always accepted.
+   */
+  ThreadPool(std::size_t threads, std::size_t max_queued);
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  /**
+   * Queue @p task to run on a worker thread.
+   *
+   * @return false, without running the task, if the queue is full or the pool
+   *     has been shut down.
+   */
+  bool TrySubmit(Task task);
+
+  /**
+   * Stop accepting tasks, run the queued ones, and stop the workers.
+   *
+   * Calling Shutdown() more than once is harmless. If called from a task, the
+   * calling worker is detached instead of joined, and exits once the task
+   * returns.
+   */
+  void Shutdown();
+
+ private:
+  // Shared with the workers, so a worker detached by Shutdown() can finish
+  // after the pool is gone.
+  struct State {
+    State(std::size_t threads, std::size_t max)
+        : max_queued(max), shutdown(false), idle(threads) {}
+    std::size_t const max_queued;
+    std::mutex mu;
+    std::condition_variable cv;
+    bool shutdown;
+    // The workers not running a task.
+    std::size_t idle;
+    std::deque<Task> tasks;
+  };
+
+  static void Run(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+  std::mutex workers_mu_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_THREAD_POOL_H_
@@ -0,0 +1,102 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/thread_pool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+using namespace ::google;
+
+TEST(ThreadPool, RunsTasksOnWorkers) {
+  gax::ThreadPool pool(2, 16);
+  std::mutex mu;
+  std::set<std::thread::id> threads;
+  std::vector<std::future<void>> done;
+  for (int i = 0; i != 8; ++i) {
+    auto promise = std::make_shared<std::promise<void>>();
+    done.push_back(promise->get_future());
+    EXPECT_TRUE(pool.TrySubmit([&mu, &threads, promise] {
+      std::lock_guard<std::mutex> lk(mu);
+      threads.insert(std::this_thread::get_id());
+      promise->set_value();
+    }));
+  }
+  for (auto& f : done) {
+    f.wait();
+  }
+  std::lock_guard<std::mutex> lk(mu);
+  // No more threads than workers, and never the caller's.
+  EXPECT_LE(threads.size(), 2U);
+  EXPECT_EQ(threads.count(std::this_thread::get_id()), 0U);
+}
+
+TEST(ThreadPool, RejectsWhenFull) {
+  gax::ThreadPool pool(1, 1);
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::promise<void> started;
+  // Occupy the only worker, then fill the queue.
+  ASSERT_TRUE(pool.TrySubmit([&started, released] {
+    started.set_value();
+    released.wait();
+  }));
+  started.get_future().wait();
+  std::atomic<int> ran{0};
+  EXPECT_TRUE(pool.TrySubmit([&ran] { ++ran; }));
+  EXPECT_FALSE(pool.TrySubmit([&ran] { ++ran; }));
+
+  release.set_value();
+  pool.Shutdown();
+  EXPECT_EQ(ran.load(), 1);
+}
+
+TEST(ThreadPool, ShutdownRunsQueuedTasks) {
+  std::atomic<int> ran{0};
+  {
+    gax::ThreadPool pool(1, 100);
+    for (int i = 0; i != 50; ++i) {
+      EXPECT_TRUE(pool.TrySubmit([&ran] { ++ran; }));
+    }
+  }
+  EXPECT_EQ(ran.load(), 50);
+}
+
+TEST(ThreadPool, RejectsAfterShutdown) {
+  gax::ThreadPool pool(1, 1);
+  pool.Shutdown();
+  pool.Shutdown();
+  EXPECT_FALSE(pool.TrySubmit([] {}));
+}
+
+TEST(ThreadPool, TaskReleasesLastReference) {
+  auto pool = std::make_shared<gax::ThreadPool>(1, 1);
+  std::promise<void> done;
+  auto* raw = pool.get();
+  // The task owns the only reference, the pool is destroyed on its worker.
+  ASSERT_TRUE(raw->TrySubmit([pool, &done]() mutable {
+    pool.reset();
+    done.set_value();
+  }));
+  pool.reset();
+  done.get_future().wait();
+}
+
+}  // namespace
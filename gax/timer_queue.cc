@@ -0,0 +1,106 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/timer_queue.h"
+#include "gax/status.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace google {
+namespace gax {
+
+TimerQueue::TimerQueue()
+    : state_(std::make_shared<State>()), thread_(&TimerQueue::Run, state_) {}
+
+TimerQueue::~TimerQueue() { Shutdown(); }
+
+void TimerQueue::Schedule(std::chrono::microseconds delay, Callback callback) {
+  auto deadline = std::chrono::steady_clock::now() + delay;
+  {
+    std::lock_guard<std::mutex> lk(state_->mu);
+    if (!state_->shutdown) {
+      auto& timers = state_->timers;
+      bool earliest = timers.empty() || deadline < timers.top().deadline;
+      timers.push(Timer{deadline, state_->next_sequence++,
+                        std::move(callback)});
+      if (earliest) {
+        state_->cv.notify_one();
+      }
+      return;
+    }
+  }
+  callback(gax::Status(gax::StatusCode::kCancelled, "TimerQueue shut down"));
+}
+
+void TimerQueue::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lk(state_->mu);
+    state_->shutdown = true;
+  }
+  state_->cv.notify_one();
+  if (!thread_.joinable()) {
+    return;
+  }
+  // A callback may release the last reference to the queue, a thread cannot
+  // join itself.
+  if (thread_.get_id() == std::this_thread::get_id()) {
+    thread_.detach();
+  } else {
+    thread_.join();
+  }
+}
+
+void TimerQueue::Run(std::shared_ptr<State> state) {
+  std::unique_lock<std::mutex> lk(state->mu);
+  auto& timers = state->timers;
+  while (true) {
+    if (state->shutdown) {
+      break;
+    }
+    if (timers.empty()) {
+      state->cv.wait(lk);
+      continue;
+    }
+    auto const deadline = timers.top().deadline;
+    if (std::chrono::steady_clock::now() < deadline) {
+      state->cv.wait_until(lk, deadline);
+      continue;
+    }
+    // std::priority_queue::top() is const, the const_cast lets us move the
+    // callback out instead of copying it; the element is popped right away.
+    Callback callback = std::move(const_cast<Timer&>(timers.top()).callback);
+    timers.pop();
+    lk.unlock();
+    callback(gax::Status{});
+    // Destroy the callback before taking the lock, it may own the queue, or
+    // schedule timers from a destructor.
+    callback = nullptr;
+    lk.lock();
+  }
+
+  while (!timers.empty()) {
+    Callback callback = std::move(const_cast<Timer&>(timers.top()).callback);
+    timers.pop();
+    lk.unlock();
+    callback(gax::Status(gax::StatusCode::kCancelled, "TimerQueue shut down"));
+    callback = nullptr;
+    lk.lock();
+  }
+}
+
+}  // namespace gax
+}  // namespace google
@@ -0,0 +1,124 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GAPIC_GENERATOR_CPP_GAX_TIMER_QUEUE_H_
+#define GAPIC_GENERATOR_CPP_GAX_TIMER_QUEUE_H_
+
+#include "gax/status.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace gax {
+
+/**
+ * A queue of timers serviced by a single background thread.
+ *
+ * Asynchronous operations, e.g. the asynchronous retry loop, need to wait
+ * between attempts without parking a thread per operation. Instead they
+ * schedule a callback on a TimerQueue, and a single thread runs the callbacks
+ * as their deadlines expire. A single TimerQueue is intended to be shared by
+ * many operations, usually by all the calls made through a client.
+ *
+ * Callbacks are run on the background thread and must not block: they should
+ * start the next step of the operation and return.
+ *
+ * Callbacks receive an OK status when the timer expires normally. If the queue
+ * is shut down before the timer expires the callback receives a `kCancelled`
+ * status instead; every scheduled callback is invoked exactly once.
+ *
+ * @par Example
+ * @code
+ * auto timers = std::make_shared<gax::TimerQueue>();
+ * timers->Schedule(std::chrono::milliseconds(10), [](gax::Status s) {
+ *   if (s.IsOk()) {
+ *     std::cout << "timer expired" << std::endl;
+ *   }
+ * });
+ * @endcode
+ */
+class TimerQueue {
+ public:
+  using Callback = std::function<void(gax::Status)>;
+
+  TimerQueue();
+  ~TimerQueue();
+
+  TimerQueue(TimerQueue const&) = delete;
+  TimerQueue& operator=(TimerQueue const&) = delete;
+
+  /**
+   * Schedule @p callback to run after @p delay has elapsed.
+   *
+   * If the queue has already been shut down the callback is invoked
+   * immediately, on the calling thread, with a `kCancelled` status.
+   */
+  void Schedule(std::chrono::microseconds delay, Callback callback);
+
+  /**
+   * Stop the background thread.
+   *
+   * Pending callbacks are run with a `kCancelled` status before this function
+   * returns. Calling Shutdown() more than once is harmless.
+   *
+   * If called from a timer callback, e.g. because the callback released the
+   * last reference to the queue, the background thread is detached instead
+   * of joined, and runs the pending callbacks once the current one returns.
+   */
+  void Shutdown();
+
+ private:
+  struct Timer {
+    std::chrono::steady_clock::time_point deadline;
+    // Breaks ties so that timers with the same deadline run in FIFO order.
+    std::uint64_t sequence;
+    Callback callback;
+  };
+
+  struct LaterTimer {
+    bool operator()(Timer const& lhs, Timer const& rhs) const {
+      return lhs.deadline > rhs.deadline ||
+             (lhs.deadline == rhs.deadline && lhs.sequence > rhs.sequence);
+    }
+  };
+
+  // Shared with the background thread, which may outlive the queue if it is
+  // destroyed from a callback.
+  struct State {
+    State() : shutdown(false), next_sequence(0) {}
+
+    std::mutex mu;
+    std::condition_variable cv;
+    bool shutdown;
+    std::uint64_t next_sequence;
+    std::priority_queue<Timer, std::vector<Timer>, LaterTimer> timers;
+  };
+
+  static void Run(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+  std::thread thread_;
+};
+
+}  // namespace gax
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GAX_TIMER_QUEUE_H_
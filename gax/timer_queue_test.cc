@@ -0,0 +1,126 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gax/timer_queue.h"
+#include "gax/status.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+using namespace ::google;
+
+TEST(TimerQueue, RunsInDeadlineOrder) {
+  gax::TimerQueue timers;
+  std::mutex mu;
+  std::vector<int> order;
+  std::promise<void> done;
+
+  auto record = [&mu, &order](int id) {
+    std::lock_guard<std::mutex> lk(mu);
+    order.push_back(id);
+  };
+  timers.Schedule(std::chrono::milliseconds(30), [&](gax::Status s) {
+    EXPECT_TRUE(s.IsOk());
+    record(3);
+    done.set_value();
+  });
+  timers.Schedule(std::chrono::milliseconds(10), [&](gax::Status s) {
+    EXPECT_TRUE(s.IsOk());
+    record(2);
+  });
+  timers.Schedule(std::chrono::milliseconds(0), [&](gax::Status s) {
+    EXPECT_TRUE(s.IsOk());
+    record(1);
+  });
+
+  done.get_future().wait();
+  std::lock_guard<std::mutex> lk(mu);
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(TimerQueue, ShutdownCancelsPendingTimers) {
+  gax::TimerQueue timers;
+  int cancelled = 0;
+  timers.Schedule(std::chrono::hours(1), [&cancelled](gax::Status s) {
+    EXPECT_EQ(s.code(), gax::StatusCode::kCancelled);
+    cancelled++;
+  });
+  timers.Shutdown();
+  EXPECT_EQ(cancelled, 1);
+
+  // Timers scheduled after shutdown are cancelled right away.
+  timers.Schedule(std::chrono::milliseconds(0), [&cancelled](gax::Status s) {
+    EXPECT_EQ(s.code(), gax::StatusCode::kCancelled);
+    cancelled++;
+  });
+  EXPECT_EQ(cancelled, 2);
+
+  // Shutdown is idempotent.
+  timers.Shutdown();
+}
+
+TEST(TimerQueue, ScheduleFromCallback) {
+  gax::TimerQueue timers;
+  std::promise<int> done;
+  timers.Schedule(std::chrono::milliseconds(0), [&](gax::Status) {
+    timers.Schedule(std::chrono::milliseconds(1),
+                    [&](gax::Status s) { done.set_value(s.IsOk() ? 2 : 0); });
+  });
+  EXPECT_EQ(done.get_future().get(), 2);
+}
+
+// Owns the last reference to a TimerQueue, and schedules one more timer from
+// its destructor before releasing it.
+struct ReleaseLast {
+  ~ReleaseLast() {
+    auto released = released_;
+    timers->Schedule(std::chrono::hours(1), [released](gax::Status s) {
+      released->set_value(s.IsOk() ? 1 : 2);
+    });
+    timers.reset();
+  }
+
+  std::shared_ptr<gax::TimerQueue> timers;
+  std::shared_ptr<std::promise<int>> released_;
+};
+
+TEST(TimerQueue, ReleasedFromCallback) {
+  auto released = std::make_shared<std::promise<int>>();
+  auto result = released->get_future();
+  std::promise<void> go;
+  std::shared_future<void> go_future = go.get_future().share();
+  {
+    auto guard = std::make_shared<ReleaseLast>();
+    guard->timers = std::make_shared<gax::TimerQueue>();
+    guard->released_ = released;
+    guard->timers->Schedule(std::chrono::milliseconds(0),
+                            [guard, go_future](gax::Status) {
+                              go_future.wait();
+                            });
+  }
+  go.set_value();
+  // Once the callback returns it is destroyed with the last reference to the
+  // queue, so the queue is destroyed on its own thread, which must neither
+  // deadlock nor join itself. The timer scheduled by the destructor is
+  // cancelled.
+  ASSERT_EQ(result.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_EQ(result.get(), 2);
+}
+
+}  // namespace
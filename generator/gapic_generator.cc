@@ -12,8 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fstream>
+#include <iterator>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
@@ -25,6 +28,7 @@
 #include "generator/internal/data_model.h"
 #include "generator/internal/gapic_utils.h"
 #include "generator/internal/printer.h"
+#include "generator/internal/service_config.h"
 #include "generator/internal/stub_cc_generator.h"
 #include "generator/internal/stub_header_generator.h"
 
@@ -36,8 +40,33 @@ namespace google {
 namespace api {
 namespace codegen {
 
+namespace {
+
+// Load the service config named in the generator parameters, if any.
+bool LoadServiceConfig(std::string const& parameter, std::string* json,
+                       std::string* error) {
+  std::vector<std::pair<std::string, std::string>> options;
+  pb::compiler::ParseGeneratorParameter(parameter, &options);
+  for (auto const& option : options) {
+    if (option.first != "grpc_service_config") {
+      *error = absl::StrCat("unknown generator parameter: ", option.first);
+      return false;
+    }
+    std::ifstream ifs(option.second);
+    if (!ifs) {
+      *error = absl::StrCat("cannot open service config ", option.second);
+      return false;
+    }
+    json->assign(std::istreambuf_iterator<char>(ifs),
+                 std::istreambuf_iterator<char>());
+  }
+  return true;
+}
+
+}  // namespace
+
 bool GapicGenerator::Generate(pb::FileDescriptor const* file,
-                              std::string const& /* parameter */,
+                              std::string const& parameter,
                               pb::compiler::GeneratorContext* generator_context,
                               std::string* error) const {
   if (file->options().cc_generic_services()) {
@@ -48,6 +77,18 @@ bool GapicGenerator::Generate(pb::FileDescriptor const* file,
     return false;
   }
 
+  std::string service_config_json = grpc_service_config_;
+  if (service_config_json.empty() &&
+      !LoadServiceConfig(parameter, &service_config_json, error)) {
+    return false;
+  }
+  internal::ServiceConfig service_config;
+  if (!service_config_json.empty() &&
+      !internal::ServiceConfig::Parse(service_config_json, &service_config,
+                                      error)) {
+    return false;
+  }
+
   for (int i = 0; i < file->service_count(); i++) {
     pb::ServiceDescriptor const* service = file->service(i);
 
@@ -76,15 +117,16 @@ bool GapicGenerator::Generate(pb::FileDescriptor const* file,
 
     std::string cc_file_path = absl::StrCat(service_file_path, ".gapic.cc");
     internal::Printer cc_printer(generator_context, cc_file_path);
-    if (!internal::GenerateClientCC(service, vars, cc_printer, error)) {
+    if (!internal::GenerateClientCC(service, vars, service_config, cc_printer,
+                                    error)) {
       return false;
     }
 
     std::string cc_stub_file_path =
         absl::StrCat(service_file_path, "_stub", ".gapic.cc");
     internal::Printer cc_stub_printer(generator_context, cc_stub_file_path);
-    if (!internal::GenerateClientStubCC(service, vars, cc_stub_printer,
-                                        error)) {
+    if (!internal::GenerateClientStubCC(service, vars, service_config,
+                                        cc_stub_printer, error)) {
       return false;
     }
   }
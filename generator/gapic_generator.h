@@ -17,6 +17,7 @@
 #include <google/protobuf/compiler/code_generator.h>
 #include <google/protobuf/descriptor.h>
 #include <string>
+#include <utility>
 
 namespace google {
 namespace api {
@@ -27,10 +28,31 @@ namespace codegen {
  */
 class GapicGenerator : public google::protobuf::compiler::CodeGenerator {
  public:
+  GapicGenerator() = default;
+
+  /**
+   * Generate stubs that use the retry settings in @p grpc_service_config.
+   *
+   * @param grpc_service_config a gRPC service config, in JSON. It takes
+   *     precedence over the `grpc_service_config` parameter.
+   */
+  explicit GapicGenerator(std::string grpc_service_config)
+      : grpc_service_config_(std::move(grpc_service_config)) {}
+
+  /**
+   * Generate the client for the services in @p file.
+   *
+   * @param parameter a comma separated list of `key=value` options. The only
+   *     option is `grpc_service_config`, the path of a gRPC service config
+   *     in JSON. The generated stubs use its per-method retry settings.
+   */
   bool Generate(google::protobuf::FileDescriptor const* file,
                 std::string const& parameter,
                 google::protobuf::compiler::GeneratorContext* generator_context,
                 std::string* error) const override;
+
+ private:
+  std::string grpc_service_config_;
 };
 
 }  // namespace codegen
@@ -43,14 +43,21 @@ TEST(GapicGeneratorBaselineTest, StandaloneTest) {
       input_dir +
           "com_google_gapic_generator_cpp/generator/testdata/"
           "library_proto-descriptor-set.proto.bin",
+      input_dir +
+          "com_google_googleapis/google/api/"
+          "annotations_proto-descriptor-set.proto.bin",
       input_dir +
           "com_google_googleapis/google/api/"
           "client_proto-descriptor-set.proto.bin",
+      input_dir +
+          "com_google_googleapis/google/api/"
+          "http_proto-descriptor-set.proto.bin",
       input_dir +
           "com_google_protobuf/descriptor_proto-descriptor-set.proto.bin"};
   std::string package = "google.example.library.v1";
 
-  GapicGenerator generator;
+  GapicGenerator generator(
+      LoadContent(data_dir + "library_grpc_service_config.json"));
 
   int res = StandaloneMain(descriptors, package, output_dir, &generator);
   EXPECT_EQ(0, res) << "StandaloneMain failed";
@@ -38,7 +38,9 @@ std::vector<std::string> BuildClientCCIncludes(
           absl::StrCat(internal::ServiceNameToFilePath(service->full_name()),
                        "_stub.gapic.h")),
       LocalInclude("gax/call_context.h"), LocalInclude("gax/status.h"),
-      LocalInclude("gax/status_or.h"),
+      LocalInclude("gax/status_or.h"), LocalInclude("gax/pagination.h"),
+      SystemInclude("chrono"),
+      SystemInclude("utility"),
   };
 }
 
@@ -49,7 +51,8 @@ std::vector<std::string> BuildClientCCNamespaces(
 
 bool GenerateClientCC(pb::ServiceDescriptor const* service,
                       std::map<std::string, std::string> const& vars,
-                      Printer& p, std::string* /* error */) {
+                      ServiceConfig const& service_config, Printer& p,
+                      std::string* /* error */) {
   auto includes = BuildClientCCIncludes(service);
   auto namespaces = BuildClientCCNamespaces(service);
 
@@ -67,29 +70,102 @@ bool GenerateClientCC(pb::ServiceDescriptor const* service,
 
   p->Print("\n");
 
-  DataModel::PrintMethods(
-      service, vars, p,
-      "google::gax::StatusOr<$response_object$>\n"
-      "$class_name$::$method_name$(\n"
-      "$request_object$ const& request) {\n"
-      "  google::gax::CallContext context($method_name_snake$_info);\n"
-      "  if (retry_policy_) {\n"
-      "    context.SetRetryPolicy(*retry_policy_);\n"
-      "  }\n"
-      "  if (backoff_policy_) {\n"
-      "    context.SetBackoffPolicy(*backoff_policy_);\n"
-      "  }\n"
-      "  $response_object$ response;\n"
-      "  google::gax::Status status = stub_->$method_name$(context, request, "
-      "&response);\n"
-      "  if (status.IsOk()) {\n"
-      "    return response;\n"
-      "  } else {\n"
-      "    return status;\n"
-      "  }\n"
-      "}\n"
-      "\n",
-      NoStreamingPredicate);
+  for (int i = 0; i < service->method_count(); i++) {
+    auto const* method = service->method(i);
+    if (!NoStreamingPredicate(method)) {
+      continue;
+    }
+    auto method_vars = vars;
+    DataModel::SetMethodVars(method, method_vars);
+    // The service config timeout bounds each call, with or without retries.
+    auto const timeout_ms = service_config.ForMethod(method).call_timeout_ms;
+    method_vars["set_timeout"] =
+        timeout_ms == 0
+            ? ""
+            : absl::StrCat("  context.SetTimeout(std::chrono::milliseconds(",
+                           timeout_ms, "));\n");
+    bool const paginated = PaginatedPredicate(method);
+    if (paginated) {
+      // Each page is a separate call, made through the private Page method.
+      p->Print(method_vars,
+               "google::gax::Status\n"
+               "$class_name$::$method_name$Page(\n"
+               "$request_object$ const& request,\n"
+               "$response_object$* response,\n"
+               "std::shared_ptr<google::gax::CancellationToken> const& "
+               "cancellation_token) {\n");
+    } else {
+      p->Print(method_vars,
+               "google::gax::StatusOr<$response_object$>\n"
+               "$class_name$::$method_name$(\n"
+               "$request_object$ const& request,\n"
+               "std::shared_ptr<google::gax::CancellationToken> "
+               "cancellation_token) {\n");
+    }
+    p->Print(
+        method_vars,
+        "  google::gax::CallContext context($method_name_snake$_info);\n"
+        "$set_timeout$"
+        "  if (retry_policy_) {\n"
+        "    context.SetRetryPolicy(*retry_policy_);\n"
+        "  }\n"
+        "  if (backoff_policy_) {\n"
+        "    context.SetBackoffPolicy(*backoff_policy_);\n"
+        "  }\n"
+        "  if (retry_budget_) {\n"
+        "    context.SetRetryBudget(retry_budget_);\n"
+        "  }\n"
+        "  if (retry_observer_) {\n"
+        "    context.SetRetryObserver(retry_observer_);\n"
+        "  }\n"
+        "  if (cancellation_token_ || cancellation_token) {\n"
+        "    context.SetCancellationToken(\n"
+        "        google::gax::CancellationToken::AnyOf(cancellation_token_,\n"
+        "                                              "
+        "cancellation_token));\n"
+        "  }\n");
+    if (paginated) {
+      p->Print(
+          method_vars,
+          "  return stub_->$method_name$(context, request, response);\n"
+          "}\n"
+          "\n"
+          "google::gax::PaginatedRange<$element_object$>\n"
+          "$class_name$::$method_name$(\n"
+          "$request_object$ const& request,\n"
+          "std::shared_ptr<google::gax::CancellationToken> "
+          "cancellation_token) {\n"
+          "  $request_object$ page_request(request);\n"
+          "  return google::gax::MakePaginatedRange<\n"
+          "      $element_object$,\n"
+          "      $response_object$>(\n"
+          "      [this, page_request, cancellation_token](\n"
+          "          $response_object$* page) mutable {\n"
+          "        google::gax::Status status =\n"
+          "            $method_name$Page(page_request, page, "
+          "cancellation_token);\n"
+          "        page_request.set_page_token(page->next_page_token());\n"
+          "        return status;\n"
+          "      },\n"
+          "      []($response_object$& page) {\n"
+          "        return page.mutable_$element_field$();\n"
+          "      });\n"
+          "}\n"
+          "\n");
+    } else {
+      p->Print(method_vars,
+               "  google::gax::StatusOr<$response_object$> response(\n"
+               "      google::gax::kInPlace);\n"
+               "  google::gax::Status status = stub_->$method_name$(context, "
+               "request, &*response);\n"
+               "  if (!status.IsOk()) {\n"
+               "    response = std::move(status);\n"
+               "  }\n"
+               "  return response;\n"
+               "}\n"
+               "\n");
+    }
+  }
 
   DataModel::PrintMethods(service, vars, p,
                           "constexpr google::gax::MethodInfo "
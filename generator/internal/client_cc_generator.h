@@ -15,6 +15,7 @@
 #define GAPIC_GENERATOR_CPP_GENERATOR_INTERNAL_CLIENT_CC_GENERATOR_H_
 
 #include "generator/internal/printer.h"
+#include "generator/internal/service_config.h"
 #include <google/protobuf/descriptor.h>
 #include <memory>
 #include <sstream>
@@ -29,7 +30,8 @@ namespace internal {
 
 bool GenerateClientCC(pb::ServiceDescriptor const* service,
                       std::map<std::string, std::string> const& vars,
-                      Printer& p, std::string* /* error */);
+                      ServiceConfig const& service_config, Printer& p,
+                      std::string* /* error */);
 
 }  // namespace internal
 }  // namespace codegen
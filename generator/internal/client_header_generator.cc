@@ -38,7 +38,10 @@ std::vector<std::string> BuildClientHeaderIncludes(
           absl::StripSuffix(service->file()->name(), ".proto"), ".pb.h")),
 
       LocalInclude("gax/status_or.h"), LocalInclude("gax/retry_policy.h"),
-      LocalInclude("gax/backoff_policy.h"),
+      LocalInclude("gax/backoff_policy.h"), LocalInclude("gax/retry_budget.h"),
+      LocalInclude("gax/retry_observer.h"),
+      LocalInclude("gax/cancellation_token.h"),
+      LocalInclude("gax/pagination.h"),
   };
 }
 
@@ -89,11 +92,39 @@ bool GenerateClientHeader(pb::ServiceDescriptor const* service,
            "  std::shared_ptr<$stub_class_name$> Stub() { return stub_; }\n"
            "\n");
 
-  DataModel::PrintMethods(service, vars, p,
-                          "  google::gax::StatusOr<$response_object$> \n"
-                          "  $method_name$($request_object$ const& request);\n"
-                          "\n",
-                          NoStreamingPredicate);
+  p->Print(vars,
+           "  // Cancelling the optional cancellation_token of a method "
+           "cancels that call\n"
+           "  // only. The client-wide token set with the constructor cancels "
+           "all of them.\n"
+           "\n");
+
+  for (int i = 0; i < service->method_count(); i++) {
+    auto const* method = service->method(i);
+    if (!NoStreamingPredicate(method)) {
+      continue;
+    }
+    auto method_vars = vars;
+    DataModel::SetMethodVars(method, method_vars);
+    if (PaginatedPredicate(method)) {
+      p->Print(method_vars,
+               "  // Lists the elements of all pages, fetching each page when "
+               "the previous\n"
+               "  // one runs out. The range must not outlive this client.\n"
+               "  google::gax::PaginatedRange<$element_object$> \n"
+               "  $method_name$($request_object$ const& request,\n"
+               "      std::shared_ptr<google::gax::CancellationToken> "
+               "cancellation_token = nullptr);\n"
+               "\n");
+    } else {
+      p->Print(method_vars,
+               "  google::gax::StatusOr<$response_object$> \n"
+               "  $method_name$($request_object$ const& request,\n"
+               "      std::shared_ptr<google::gax::CancellationToken> "
+               "cancellation_token = nullptr);\n"
+               "\n");
+    }
+  }
 
   p->Print(vars,
            "\n"
@@ -104,6 +135,19 @@ bool GenerateClientHeader(pb::ServiceDescriptor const* service,
            "  void ChangePolicy(google::gax::BackoffPolicy const& policy) {\n"
            "    backoff_policy_ = policy.clone();\n"
            "  }\n"
+           "  void ChangePolicy(std::shared_ptr<google::gax::RetryBudget> "
+           "const& budget) {\n"
+           "    retry_budget_ = budget;\n"
+           "  }\n"
+           "  void ChangePolicy(std::shared_ptr<google::gax::RetryObserver> "
+           "const& observer) {\n"
+           "    retry_observer_ = observer;\n"
+           "  }\n"
+           "  void ChangePolicy(\n"
+           "      std::shared_ptr<google::gax::CancellationToken> const& token) "
+           "{\n"
+           "    cancellation_token_ = token;\n"
+           "  }\n"
            "  void ChangePolicies() {}\n"
            "\n"
            "  template <typename Policy, typename... Policies>\n"
@@ -111,20 +155,38 @@ bool GenerateClientHeader(pb::ServiceDescriptor const* service,
            "    ChangePolicy(policy);\n"
            "    ChangePolicies(std::forward<Policies>(policies)...);\n"
            "  }\n"
-           "\n"
+           "\n");
+
+  DataModel::PrintMethods(
+      service, vars, p,
+      "  // Retrieves a single page of $method_name$.\n"
+      "  google::gax::Status $method_name$Page(\n"
+      "      $request_object$ const& request,\n"
+      "      $response_object$* response,\n"
+      "      std::shared_ptr<google::gax::CancellationToken> const& "
+      "cancellation_token);\n"
+      "\n",
+      PaginatedPredicate);
+
+  p->Print(vars,
            "  std::shared_ptr<$stub_class_name$> stub_;\n"
            "  std::unique_ptr<google::gax::RetryPolicy> retry_policy_;\n"
            "  std::unique_ptr<google::gax::BackoffPolicy> backoff_policy_;\n"
+           "  std::shared_ptr<google::gax::RetryBudget> retry_budget_;\n"
+           "  std::shared_ptr<google::gax::RetryObserver> retry_observer_;\n"
+           "  // Cancels all the calls made by this client, and their retries.\n"
+           "  std::shared_ptr<google::gax::CancellationToken> "
+           "cancellation_token_;\n"
            "\n"
-           "  // Note: conservatively assume no methods are idempotent.\n"
-           "  //       This will eventually be set from annotations.\n");
+           "  // GET and PUT methods are idempotent, per their google.api.http "
+           "verb.\n");
 
   DataModel::PrintMethods(
       service, vars, p,
       "  static constexpr google::gax::MethodInfo $method_name_snake$_info = {"
       "\n"
       "      \"$method_name$\", google::gax::MethodInfo::RpcType::NORMAL_RPC,\n"
-      "      google::gax::MethodInfo::Idempotency::NON_IDEMPOTENT};\n",
+      "      google::gax::MethodInfo::Idempotency::$method_idempotency$};\n",
       NoStreamingPredicate);
 
   p->Print(vars,
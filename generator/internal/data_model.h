@@ -21,6 +21,7 @@
 #include "google/api/client.pb.h"
 #include "generator/internal/gapic_utils.h"
 #include "generator/internal/printer.h"
+#include "generator/internal/request_params.h"
 #include <google/protobuf/compiler/code_generator.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/descriptor.pb.h>
@@ -54,11 +55,21 @@ struct DataModel {
   static void SetMethodVars(pb::MethodDescriptor const* method,
                             std::map<std::string, std::string>& vars) {
     vars["method_name"] = method->name();
+    vars["method_index"] = std::to_string(method->index());
     vars["method_name_snake"] = CamelCaseToSnakeCase(method->name());
     vars["request_object"] =
         internal::ProtoNameToCppName(method->input_type()->full_name());
     vars["response_object"] =
         internal::ProtoNameToCppName(method->output_type()->full_name());
+    vars["method_idempotency"] = internal::MethodIsIdempotent(method)
+                                     ? "IDEMPOTENT"
+                                     : "NON_IDEMPOTENT";
+    auto const* elements = PaginatedElementField(method);
+    if (elements != nullptr) {
+      vars["element_object"] = internal::ProtoNameToCppName(
+          elements->message_type()->full_name());
+      vars["element_field"] = elements->name();
+    }
   }
 
   static void PrintMethods(
@@ -32,6 +32,45 @@ bool NoStreamingPredicate(pb::MethodDescriptor const* m) {
   return !m->client_streaming() && !m->server_streaming();
 }
 
+namespace {
+bool HasField(pb::Descriptor const* message, std::string const& name,
+              pb::FieldDescriptor::Type type) {
+  auto const* field = message->FindFieldByName(name);
+  return field != nullptr && !field->is_repeated() && field->type() == type;
+}
+}  // namespace
+
+pb::FieldDescriptor const* PaginatedElementField(
+    pb::MethodDescriptor const* m) {
+  if (!NoStreamingPredicate(m) ||
+      !HasField(m->input_type(), "page_token",
+                pb::FieldDescriptor::TYPE_STRING) ||
+      !HasField(m->input_type(), "page_size",
+                pb::FieldDescriptor::TYPE_INT32) ||
+      !HasField(m->output_type(), "next_page_token",
+                pb::FieldDescriptor::TYPE_STRING)) {
+    return nullptr;
+  }
+  pb::FieldDescriptor const* elements = nullptr;
+  auto const* response = m->output_type();
+  for (int i = 0; i != response->field_count(); ++i) {
+    auto const* field = response->field(i);
+    if (field->is_repeated() &&
+        (elements == nullptr || field->number() < elements->number())) {
+      elements = field;
+    }
+  }
+  if (elements == nullptr || elements->is_map() ||
+      elements->type() != pb::FieldDescriptor::TYPE_MESSAGE) {
+    return nullptr;
+  }
+  return elements;
+}
+
+bool PaginatedPredicate(pb::MethodDescriptor const* m) {
+  return PaginatedElementField(m) != nullptr;
+}
+
 std::string CamelCaseToSnakeCase(std::string const& input) {
   std::string output;
   for (auto i = 0u; i < input.size(); ++i) {
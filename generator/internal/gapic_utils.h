@@ -32,6 +32,20 @@ namespace pb = google::protobuf;
 
 bool NoStreamingPredicate(pb::MethodDescriptor const* m);
 
+/**
+ * Find the repeated field a paginated method lists, or nullptr if the method
+ * is not paginated.
+ *
+ * A method is paginated (see https://google.aip.dev/158) if it is not
+ * streaming, its request has `string page_token` and `int32 page_size`
+ * fields, and its response has a `string next_page_token` field. The listed
+ * field is the response's first repeated field by field number, which must
+ * have a message type.
+ */
+pb::FieldDescriptor const* PaginatedElementField(pb::MethodDescriptor const* m);
+
+bool PaginatedPredicate(pb::MethodDescriptor const* m);
+
 // Convenience functions for wrapping include headers with the correct
 // delimiting characters (either <> or "")
 std::string LocalInclude(std::string header);
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "generator/internal/gapic_utils.h"
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
 #include <gtest/gtest.h>
 #include <string>
 #include <utility>
@@ -39,6 +41,105 @@ TEST(GapicUtils, CamelCaseToSnakeCase) {
   }
 }
 
+class PaginatedElementFieldTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    pb::FileDescriptorProto file;
+    file.set_name("test/service.proto");
+    file.set_package("test.v1");
+    auto* book = file.add_message_type();
+    book->set_name("Book");
+    AddField(book, "name", 1, pb::FieldDescriptorProto::TYPE_STRING);
+
+    auto* request = file.add_message_type();
+    request->set_name("ListRequest");
+    AddField(request, "page_size", 1, pb::FieldDescriptorProto::TYPE_INT32);
+    AddField(request, "page_token", 2, pb::FieldDescriptorProto::TYPE_STRING);
+
+    auto* response = file.add_message_type();
+    response->set_name("ListResponse");
+    AddField(response, "next_page_token", 1,
+             pb::FieldDescriptorProto::TYPE_STRING);
+    AddRepeated(response, "tags", 3, pb::FieldDescriptorProto::TYPE_STRING);
+    AddRepeated(response, "books", 2, pb::FieldDescriptorProto::TYPE_MESSAGE)
+        ->set_type_name(".test.v1.Book");
+
+    auto* strings = file.add_message_type();
+    strings->set_name("ListStringsResponse");
+    AddField(strings, "next_page_token", 1,
+             pb::FieldDescriptorProto::TYPE_STRING);
+    AddRepeated(strings, "names", 2, pb::FieldDescriptorProto::TYPE_STRING);
+
+    auto* service = file.add_service();
+    service->set_name("TestService");
+    AddMethod(service, "List", ".test.v1.ListRequest", ".test.v1.ListResponse");
+    AddMethod(service, "Get", ".test.v1.ListRequest", ".test.v1.Book");
+    AddMethod(service, "ListStrings", ".test.v1.ListRequest",
+              ".test.v1.ListStringsResponse");
+    AddMethod(service, "WrongRequest", ".test.v1.Book",
+              ".test.v1.ListResponse");
+    AddMethod(service, "Stream", ".test.v1.ListRequest",
+              ".test.v1.ListResponse")
+        ->set_server_streaming(true);
+    auto const* descriptor = pool_.BuildFile(file);
+    ASSERT_NE(descriptor, nullptr);
+    service_ = descriptor->service(0);
+  }
+
+  static pb::FieldDescriptorProto* AddField(
+      pb::DescriptorProto* message, std::string name, int number,
+      pb::FieldDescriptorProto::Type type) {
+    auto* field = message->add_field();
+    field->set_name(std::move(name));
+    field->set_number(number);
+    field->set_type(type);
+    field->set_label(pb::FieldDescriptorProto::LABEL_OPTIONAL);
+    return field;
+  }
+
+  static pb::FieldDescriptorProto* AddRepeated(
+      pb::DescriptorProto* message, std::string name, int number,
+      pb::FieldDescriptorProto::Type type) {
+    auto* field = AddField(message, std::move(name), number, type);
+    field->set_label(pb::FieldDescriptorProto::LABEL_REPEATED);
+    return field;
+  }
+
+  static pb::MethodDescriptorProto* AddMethod(pb::ServiceDescriptorProto* s,
+                                              std::string name,
+                                              std::string input,
+                                              std::string output) {
+    auto* method = s->add_method();
+    method->set_name(std::move(name));
+    method->set_input_type(std::move(input));
+    method->set_output_type(std::move(output));
+    return method;
+  }
+
+  pb::FieldDescriptor const* Elements(std::string const& method) const {
+    return PaginatedElementField(service_->FindMethodByName(method));
+  }
+
+  pb::DescriptorPool pool_;
+  pb::ServiceDescriptor const* service_ = nullptr;
+};
+
+TEST_F(PaginatedElementFieldTest, FirstRepeatedFieldByNumber) {
+  auto const* field = Elements("List");
+  ASSERT_NE(field, nullptr);
+  EXPECT_EQ(field->name(), "books");
+  EXPECT_TRUE(PaginatedPredicate(service_->FindMethodByName("List")));
+}
+
+TEST_F(PaginatedElementFieldTest, NotPaginated) {
+  EXPECT_EQ(Elements("Get"), nullptr);
+  EXPECT_EQ(Elements("WrongRequest"), nullptr);
+  EXPECT_EQ(Elements("Stream"), nullptr);
+  // Only message elements are supported.
+  EXPECT_EQ(Elements("ListStrings"), nullptr);
+  EXPECT_FALSE(PaginatedPredicate(service_->FindMethodByName("Get")));
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace codegen
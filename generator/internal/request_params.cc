@@ -0,0 +1,134 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "generator/internal/request_params.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "google/api/annotations.pb.h"
+#include "google/api/http.pb.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace google {
+namespace api {
+namespace codegen {
+namespace internal {
+
+namespace {
+
+std::string const& HttpPath(google::api::HttpRule const& rule) {
+  switch (rule.pattern_case()) {
+    case google::api::HttpRule::kGet:
+      return rule.get();
+    case google::api::HttpRule::kPut:
+      return rule.put();
+    case google::api::HttpRule::kPost:
+      return rule.post();
+    case google::api::HttpRule::kDelete:
+      return rule.delete_();
+    case google::api::HttpRule::kPatch:
+      return rule.patch();
+    case google::api::HttpRule::kCustom:
+      return rule.custom().path();
+    default:
+      break;
+  }
+  static auto const* const kEmpty = new std::string;
+  return *kEmpty;
+}
+
+// Resolve @p path in @p message, returning false if it does not name a
+// singular string, integer, or enum field.
+bool ResolveField(pb::Descriptor const* message, std::string const& path,
+                  RequestParam& param) {
+  param.name = path;
+  param.accessor = "request";
+  pb::FieldDescriptor const* field = nullptr;
+  for (auto const& component : absl::StrSplit(path, '.')) {
+    if (message == nullptr) {
+      return false;
+    }
+    field = message->FindFieldByName(std::string(component));
+    if (field == nullptr || field->is_repeated()) {
+      return false;
+    }
+    absl::StrAppend(&param.accessor, ".", field->name(), "()");
+    message = field->message_type();
+  }
+  switch (field->cpp_type()) {
+    case pb::FieldDescriptor::CPPTYPE_STRING:
+      param.is_string = field->type() == pb::FieldDescriptor::TYPE_STRING;
+      return param.is_string;
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+    case pb::FieldDescriptor::CPPTYPE_ENUM:
+      param.is_string = false;
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+std::vector<std::string> PathTemplateFields(std::string const& path_template) {
+  std::vector<std::string> fields;
+  std::string::size_type pos = 0;
+  while ((pos = path_template.find('{', pos)) != std::string::npos) {
+    auto const end = path_template.find('}', pos);
+    if (end == std::string::npos) {
+      break;
+    }
+    auto variable = path_template.substr(pos + 1, end - pos - 1);
+    auto const name = variable.substr(0, variable.find('='));
+    if (!name.empty() &&
+        std::find(fields.begin(), fields.end(), name) == fields.end()) {
+      fields.push_back(name);
+    }
+    pos = end + 1;
+  }
+  return fields;
+}
+
+std::vector<RequestParam> MethodRequestParams(
+    pb::MethodDescriptor const* method) {
+  std::vector<RequestParam> params;
+  if (!method->options().HasExtension(google::api::http)) {
+    return params;
+  }
+  auto const& rule = method->options().GetExtension(google::api::http);
+  for (auto const& path : PathTemplateFields(HttpPath(rule))) {
+    RequestParam param;
+    if (ResolveField(method->input_type(), path, param)) {
+      params.push_back(std::move(param));
+    }
+  }
+  return params;
+}
+
+bool MethodIsIdempotent(pb::MethodDescriptor const* method) {
+  if (!method->options().HasExtension(google::api::http)) {
+    return false;
+  }
+  auto const& rule = method->options().GetExtension(google::api::http);
+  return rule.pattern_case() == google::api::HttpRule::kGet ||
+         rule.pattern_case() == google::api::HttpRule::kPut;
+}
+
+}  // namespace internal
+}  // namespace codegen
+}  // namespace api
+}  // namespace google
@@ -0,0 +1,69 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef GAPIC_GENERATOR_CPP_GENERATOR_INTERNAL_REQUEST_PARAMS_H_
+#define GAPIC_GENERATOR_CPP_GENERATOR_INTERNAL_REQUEST_PARAMS_H_
+
+#include <google/protobuf/descriptor.h>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace api {
+namespace codegen {
+namespace internal {
+
+namespace pb = google::protobuf;
+
+/**
+ * A request field sent in the `x-goog-request-params` header.
+ */
+struct RequestParam {
+  /// The field path, e.g. "name" or "book.name".
+  std::string name;
+  /// The C++ expression that reads the field from `request`.
+  std::string accessor;
+  /// True for string fields, false for integer and enum fields.
+  bool is_string;
+};
+
+/**
+ * Return the field paths in a `google.api.http` path template.
+ *
+ * Example: "/v1/{name=shelves/*}/books/{book.id}" -> {"name", "book.id"}
+ */
+std::vector<std::string> PathTemplateFields(std::string const& path_template);
+
+/**
+ * Return the request fields a method sends in `x-goog-request-params`.
+ *
+ * These are the fields in the path of the method's `google.api.http`
+ * annotation. Fields that do not exist, are repeated, or are not strings,
+ * integers, or enums are ignored. Methods without the annotation have none.
+ */
+std::vector<RequestParam> MethodRequestParams(pb::MethodDescriptor const* method);
+
+/**
+ * Return true if the method's `google.api.http` verb is idempotent.
+ *
+ * Following the HTTP semantics, GET and PUT methods are idempotent. All other
+ * verbs, and methods without the annotation, are assumed not to be.
+ */
+bool MethodIsIdempotent(pb::MethodDescriptor const* method);
+
+}  // namespace internal
+}  // namespace codegen
+}  // namespace api
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GENERATOR_INTERNAL_REQUEST_PARAMS_H_
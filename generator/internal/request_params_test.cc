@@ -0,0 +1,158 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "generator/internal/request_params.h"
+#include "google/api/annotations.pb.h"
+#include "google/api/http.pb.h"
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace api {
+namespace codegen {
+namespace internal {
+namespace {
+
+TEST(PathTemplateFields, Basic) {
+  EXPECT_EQ(PathTemplateFields("/v1/shelves"), std::vector<std::string>{});
+  EXPECT_EQ(PathTemplateFields("/v1/{name=shelves/*/books/*}"),
+            std::vector<std::string>{"name"});
+  EXPECT_EQ(PathTemplateFields("/v1/{parent=shelves/*}/books/{book.id}:get"),
+            (std::vector<std::string>{"parent", "book.id"}));
+  EXPECT_EQ(PathTemplateFields("/v1/{name}/{name}"),
+            std::vector<std::string>{"name"});
+  EXPECT_EQ(PathTemplateFields("/v1/{unterminated"),
+            std::vector<std::string>{});
+}
+
+class MethodRequestParamsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    pb::FileDescriptorProto file;
+    file.set_name("test/service.proto");
+    file.set_package("test.v1");
+    auto* book = file.add_message_type();
+    book->set_name("Book");
+    AddField(book, "id", 1, pb::FieldDescriptorProto::TYPE_INT64);
+    auto* request = file.add_message_type();
+    request->set_name("Request");
+    AddField(request, "name", 1, pb::FieldDescriptorProto::TYPE_STRING);
+    AddField(request, "book", 2, pb::FieldDescriptorProto::TYPE_MESSAGE)
+        ->set_type_name(".test.v1.Book");
+    AddField(request, "data", 3, pb::FieldDescriptorProto::TYPE_BYTES);
+    AddField(request, "tags", 4, pb::FieldDescriptorProto::TYPE_STRING)
+        ->set_label(pb::FieldDescriptorProto::LABEL_REPEATED);
+
+    auto* service = file.add_service();
+    service->set_name("TestService");
+    AddMethod(service, "NoHttp");
+    AddMethod(service, "Get")
+        ->mutable_options()
+        ->MutableExtension(google::api::http)
+        ->set_get("/v1/{name=shelves/*}/books/{book.id}");
+    AddMethod(service, "Custom")
+        ->mutable_options()
+        ->MutableExtension(google::api::http)
+        ->mutable_custom()
+        ->set_path("/v1/{name=shelves/*}:custom");
+    AddMethod(service, "Unsupported")
+        ->mutable_options()
+        ->MutableExtension(google::api::http)
+        ->set_post("/v1/{data}/{tags}/{missing}/{book}");
+    AddMethod(service, "Put")
+        ->mutable_options()
+        ->MutableExtension(google::api::http)
+        ->set_put("/v1/{name=shelves/*}");
+    AddMethod(service, "Delete")
+        ->mutable_options()
+        ->MutableExtension(google::api::http)
+        ->set_delete_("/v1/{name=shelves/*}");
+    auto const* descriptor = pool_.BuildFile(file);
+    ASSERT_NE(descriptor, nullptr);
+    service_ = descriptor->service(0);
+  }
+
+  static pb::FieldDescriptorProto* AddField(
+      pb::DescriptorProto* message, std::string name, int number,
+      pb::FieldDescriptorProto::Type type) {
+    auto* field = message->add_field();
+    field->set_name(std::move(name));
+    field->set_number(number);
+    field->set_type(type);
+    field->set_label(pb::FieldDescriptorProto::LABEL_OPTIONAL);
+    return field;
+  }
+
+  static pb::MethodDescriptorProto* AddMethod(pb::ServiceDescriptorProto* s,
+                                              std::string name) {
+    auto* method = s->add_method();
+    method->set_name(std::move(name));
+    method->set_input_type(".test.v1.Request");
+    method->set_output_type(".test.v1.Book");
+    return method;
+  }
+
+  std::vector<RequestParam> Params(std::string const& method) const {
+    return MethodRequestParams(service_->FindMethodByName(method));
+  }
+
+  pb::DescriptorPool pool_;
+  pb::ServiceDescriptor const* service_ = nullptr;
+};
+
+TEST_F(MethodRequestParamsTest, NoAnnotation) {
+  EXPECT_TRUE(Params("NoHttp").empty());
+}
+
+TEST_F(MethodRequestParamsTest, StringAndNestedFields) {
+  auto params = Params("Get");
+  ASSERT_EQ(params.size(), 2U);
+  EXPECT_EQ(params[0].name, "name");
+  EXPECT_EQ(params[0].accessor, "request.name()");
+  EXPECT_TRUE(params[0].is_string);
+  EXPECT_EQ(params[1].name, "book.id");
+  EXPECT_EQ(params[1].accessor, "request.book().id()");
+  EXPECT_FALSE(params[1].is_string);
+}
+
+TEST_F(MethodRequestParamsTest, CustomPattern) {
+  auto params = Params("Custom");
+  ASSERT_EQ(params.size(), 1U);
+  EXPECT_EQ(params[0].name, "name");
+}
+
+TEST_F(MethodRequestParamsTest, UnsupportedFieldsAreIgnored) {
+  EXPECT_TRUE(Params("Unsupported").empty());
+}
+
+TEST_F(MethodRequestParamsTest, Idempotency) {
+  auto idempotent = [this](std::string const& method) {
+    return MethodIsIdempotent(service_->FindMethodByName(method));
+  };
+  EXPECT_TRUE(idempotent("Get"));
+  EXPECT_TRUE(idempotent("Put"));
+  EXPECT_FALSE(idempotent("Unsupported"));
+  EXPECT_FALSE(idempotent("Delete"));
+  EXPECT_FALSE(idempotent("Custom"));
+  EXPECT_FALSE(idempotent("NoHttp"));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace codegen
+}  // namespace api
+}  // namespace google
@@ -0,0 +1,249 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "generator/internal/service_config.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include <google/protobuf/struct.pb.h>
+#include <google/protobuf/util/json_util.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace google {
+namespace api {
+namespace codegen {
+namespace internal {
+
+namespace {
+
+// The gax::StatusCode enumerators, in the order of their values.
+char const* const kStatusCodes[] = {
+    "kOk",
+    "kCancelled",
+    "kUnknown",
+    "kInvalidArgument",
+    "kDeadlineExceeded",
+    "kNotFound",
+    "kAlreadyExists",
+    "kPermissionDenied",
+    "kResourceExhausted",
+    "kFailedPrecondition",
+    "kAborted",
+    "kOutOfRange",
+    "kUnimplemented",
+    "kInternal",
+    "kUnavailable",
+    "kDataLoss",
+    "kUnauthenticated",
+};
+
+// The names used in service configs, in the same order.
+char const* const kStatusCodeNames[] = {
+    "OK",
+    "CANCELLED",
+    "UNKNOWN",
+    "INVALID_ARGUMENT",
+    "DEADLINE_EXCEEDED",
+    "NOT_FOUND",
+    "ALREADY_EXISTS",
+    "PERMISSION_DENIED",
+    "RESOURCE_EXHAUSTED",
+    "FAILED_PRECONDITION",
+    "ABORTED",
+    "OUT_OF_RANGE",
+    "UNIMPLEMENTED",
+    "INTERNAL",
+    "UNAVAILABLE",
+    "DATA_LOSS",
+    "UNAUTHENTICATED",
+};
+
+constexpr int kStatusCodeCount =
+    sizeof(kStatusCodes) / sizeof(kStatusCodes[0]);
+
+MethodRetrySettings DefaultSettings() {
+  return MethodRetrySettings{{"kAborted", "kDeadlineExceeded", "kUnavailable"},
+                             0,
+                             500,
+                             0,
+                             20,
+                             100,
+                             2.0};
+}
+
+// Parse a google.protobuf.Duration in its JSON form, e.g. "1.5s".
+bool ParseDuration(pb::Value const& value, std::int64_t* ms,
+                   std::string* error) {
+  absl::string_view text = value.string_value();
+  double seconds;
+  if (value.kind_case() != pb::Value::kStringValue || text.empty() ||
+      text.back() != 's' ||
+      !absl::SimpleAtod(text.substr(0, text.size() - 1), &seconds) ||
+      seconds < 0) {
+    *error = absl::StrCat("invalid duration in service config: \"",
+                          value.string_value(), "\"");
+    return false;
+  }
+  *ms = static_cast<std::int64_t>(std::llround(seconds * 1000));
+  return true;
+}
+
+bool ParseStatusCode(pb::Value const& value, std::string* code,
+                     std::string* error) {
+  if (value.kind_case() == pb::Value::kNumberValue) {
+    auto number = static_cast<int>(value.number_value());
+    if (number >= 0 && number < kStatusCodeCount &&
+        number == value.number_value()) {
+      *code = kStatusCodes[number];
+      return true;
+    }
+  }
+  for (int i = 0; i != kStatusCodeCount; ++i) {
+    if (value.string_value() == kStatusCodeNames[i]) {
+      *code = kStatusCodes[i];
+      return true;
+    }
+  }
+  *error = absl::StrCat("invalid status code in service config: \"",
+                        value.string_value(), "\"");
+  return false;
+}
+
+bool ParseRetryPolicy(pb::Struct const& policy, MethodRetrySettings* settings,
+                      std::string* error) {
+  auto const& fields = policy.fields();
+  // As in gRPC, maxAttempts is required, must be at least 2, and values above
+  // 5 are treated as 5.
+  auto it = fields.find("maxAttempts");
+  if (it == fields.end() || it->second.kind_case() != pb::Value::kNumberValue ||
+      it->second.number_value() < 2) {
+    *error = "retryPolicy.maxAttempts must be a number greater than 1";
+    return false;
+  }
+  settings->max_attempts =
+      static_cast<int>(std::min(it->second.number_value(), 5.0));
+  it = fields.find("initialBackoff");
+  if (it != fields.end() &&
+      !ParseDuration(it->second, &settings->initial_backoff_ms, error)) {
+    return false;
+  }
+  it = fields.find("maxBackoff");
+  if (it != fields.end() &&
+      !ParseDuration(it->second, &settings->max_backoff_ms, error)) {
+    return false;
+  }
+  it = fields.find("backoffMultiplier");
+  if (it != fields.end()) {
+    settings->backoff_multiplier = it->second.number_value();
+  }
+  settings->retryable_codes.clear();
+  it = fields.find("retryableStatusCodes");
+  if (it != fields.end()) {
+    for (auto const& value : it->second.list_value().values()) {
+      std::string code;
+      if (!ParseStatusCode(value, &code, error)) {
+        return false;
+      }
+      settings->retryable_codes.push_back(code);
+    }
+  }
+  return true;
+}
+
+bool ParseMethodConfig(pb::Struct const& method_config,
+                       std::map<std::string, MethodRetrySettings>* settings,
+                       std::string* error) {
+  auto const& fields = method_config.fields();
+  auto entry = DefaultSettings();
+  // Without a retry policy the method is not retried, and without a timeout
+  // neither the call nor its retries have a time limit.
+  entry.retryable_codes.clear();
+  entry.max_attempts = 1;
+  entry.timeout_ms = 0;
+  entry.call_timeout_ms = 0;
+
+  auto it = fields.find("timeout");
+  if (it != fields.end()) {
+    if (!ParseDuration(it->second, &entry.timeout_ms, error)) {
+      return false;
+    }
+    entry.call_timeout_ms = entry.timeout_ms;
+  }
+  it = fields.find("retryPolicy");
+  if (it != fields.end() &&
+      !ParseRetryPolicy(it->second.struct_value(), &entry, error)) {
+    return false;
+  }
+
+  it = fields.find("name");
+  if (it == fields.end()) {
+    return true;
+  }
+  for (auto const& name : it->second.list_value().values()) {
+    auto const& name_fields = name.struct_value().fields();
+    std::string key;
+    auto service = name_fields.find("service");
+    if (service != name_fields.end()) {
+      key = absl::StrCat(service->second.string_value(), "/");
+      auto method = name_fields.find("method");
+      if (method != name_fields.end()) {
+        absl::StrAppend(&key, method->second.string_value());
+      }
+    }
+    (*settings)[key] = entry;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ServiceConfig::Parse(std::string const& json, ServiceConfig* config,
+                          std::string* error) {
+  pb::Struct parsed;
+  auto status = pb::util::JsonStringToMessage(json, &parsed);
+  if (!status.ok()) {
+    *error = absl::StrCat("cannot parse service config: ", status.ToString());
+    return false;
+  }
+  auto it = parsed.fields().find("methodConfig");
+  if (it == parsed.fields().end()) {
+    return true;
+  }
+  for (auto const& method_config : it->second.list_value().values()) {
+    if (!ParseMethodConfig(method_config.struct_value(), &config->settings_,
+                           error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+MethodRetrySettings ServiceConfig::ForMethod(
+    pb::MethodDescriptor const* method) const {
+  auto const service = absl::StrCat(method->service()->full_name(), "/");
+  for (auto const& key :
+       {absl::StrCat(service, method->name()), service, std::string{}}) {
+    auto it = settings_.find(key);
+    if (it != settings_.end()) {
+      return it->second;
+    }
+  }
+  return DefaultSettings();
+}
+
+}  // namespace internal
+}  // namespace codegen
+}  // namespace api
+}  // namespace google
@@ -0,0 +1,92 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef GAPIC_GENERATOR_CPP_GENERATOR_INTERNAL_SERVICE_CONFIG_H_
+#define GAPIC_GENERATOR_CPP_GENERATOR_INTERNAL_SERVICE_CONFIG_H_
+
+#include <google/protobuf/descriptor.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace api {
+namespace codegen {
+namespace internal {
+
+namespace pb = google::protobuf;
+
+/**
+ * The retry settings for one method.
+ *
+ * Mirrors gax::MethodRetryConfig, the generated code initializes one of
+ * those from each of these.
+ */
+struct MethodRetrySettings {
+  /// The gax::StatusCode enumerators to retry, e.g. "kUnavailable".
+  std::vector<std::string> retryable_codes;
+  /// Including the first attempt, 0 means no limit other than the timeout.
+  int max_attempts;
+  std::int64_t timeout_ms;
+  /// The default timeout for each call, 0 if the service config does not
+  /// set one. Unlike `timeout_ms` this applies with or without retries.
+  std::int64_t call_timeout_ms;
+  std::int64_t initial_backoff_ms;
+  std::int64_t max_backoff_ms;
+  double backoff_multiplier;
+};
+
+/**
+ * The parts of a gRPC service config the generated stubs use.
+ *
+ * Each `methodConfig` entry applies to the methods named in its `name`
+ * list. A name with a service but no method applies to all the methods of
+ * that service, and the most specific name wins.
+ *
+ * @see https://github.com/grpc/grpc/blob/master/doc/service_config.md
+ */
+class ServiceConfig {
+ public:
+  /// A config without any entries, all methods get the defaults.
+  ServiceConfig() = default;
+
+  /**
+   * Parse a service config in its JSON form.
+   *
+   * @return false, and set @p error, if @p json is not a valid service config.
+   */
+  static bool Parse(std::string const& json, ServiceConfig* config,
+                    std::string* error);
+
+  /**
+   * The retry settings for @p method.
+   *
+   * Methods without an entry keep the defaults used before service configs
+   * were supported: retry transient failures for up to 500ms, without a
+   * default call timeout. Methods with an entry but no `retryPolicy` are not
+   * retried.
+   */
+  MethodRetrySettings ForMethod(pb::MethodDescriptor const* method) const;
+
+ private:
+  // Indexed by "service/method", "service/", or "" for the default entry.
+  std::map<std::string, MethodRetrySettings> settings_;
+};
+
+}  // namespace internal
+}  // namespace codegen
+}  // namespace api
+}  // namespace google
+
+#endif  // GAPIC_GENERATOR_CPP_GENERATOR_INTERNAL_SERVICE_CONFIG_H_
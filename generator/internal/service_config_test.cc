@@ -0,0 +1,191 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "generator/internal/service_config.h"
+#include "absl/strings/str_cat.h"
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace api {
+namespace codegen {
+namespace internal {
+namespace {
+
+class ServiceConfigTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    pb::FileDescriptorProto file;
+    file.set_name("test/service.proto");
+    file.set_package("test.v1");
+    auto* message = file.add_message_type();
+    message->set_name("Empty");
+    auto* service = file.add_service();
+    service->set_name("TestService");
+    for (auto const* name : {"Get", "List", "Delete"}) {
+      auto* method = service->add_method();
+      method->set_name(name);
+      method->set_input_type(".test.v1.Empty");
+      method->set_output_type(".test.v1.Empty");
+    }
+    auto const* descriptor = pool_.BuildFile(file);
+    ASSERT_NE(descriptor, nullptr);
+    service_ = descriptor->service(0);
+  }
+
+  pb::MethodDescriptor const* Method(std::string const& name) const {
+    return service_->FindMethodByName(name);
+  }
+
+  pb::DescriptorPool pool_;
+  pb::ServiceDescriptor const* service_ = nullptr;
+};
+
+TEST_F(ServiceConfigTest, Empty) {
+  ServiceConfig config;
+  auto settings = config.ForMethod(Method("Get"));
+  EXPECT_EQ(settings.retryable_codes,
+            (std::vector<std::string>{"kAborted", "kDeadlineExceeded",
+                                      "kUnavailable"}));
+  EXPECT_EQ(settings.max_attempts, 0);
+  EXPECT_EQ(settings.timeout_ms, 500);
+  EXPECT_EQ(settings.call_timeout_ms, 0);
+  EXPECT_EQ(settings.initial_backoff_ms, 20);
+  EXPECT_EQ(settings.max_backoff_ms, 100);
+  EXPECT_EQ(settings.backoff_multiplier, 2.0);
+}
+
+TEST_F(ServiceConfigTest, MostSpecificNameWins) {
+  std::string const json = R"""({
+    "methodConfig": [{
+      "name": [{"service": "test.v1.TestService"}],
+      "timeout": "60s"
+    }, {
+      "name": [{"service": "test.v1.TestService", "method": "Get"},
+               {"service": "test.v1.TestService", "method": "List"}],
+      "timeout": "1.5s",
+      "retryPolicy": {
+        "maxAttempts": 4,
+        "initialBackoff": "0.1s",
+        "maxBackoff": "30s",
+        "backoffMultiplier": 1.3,
+        "retryableStatusCodes": ["UNAVAILABLE", 10]
+      }
+    }]
+  })""";
+  ServiceConfig config;
+  std::string error;
+  ASSERT_TRUE(ServiceConfig::Parse(json, &config, &error)) << error;
+
+  auto get = config.ForMethod(Method("Get"));
+  EXPECT_EQ(get.retryable_codes,
+            (std::vector<std::string>{"kUnavailable", "kAborted"}));
+  EXPECT_EQ(get.max_attempts, 4);
+  EXPECT_EQ(get.timeout_ms, 1500);
+  EXPECT_EQ(get.call_timeout_ms, 1500);
+  EXPECT_EQ(get.initial_backoff_ms, 100);
+  EXPECT_EQ(get.max_backoff_ms, 30000);
+  EXPECT_EQ(get.backoff_multiplier, 1.3);
+  EXPECT_EQ(config.ForMethod(Method("List")).max_attempts, 4);
+
+  // The service-wide entry has no retry policy.
+  auto remove = config.ForMethod(Method("Delete"));
+  EXPECT_TRUE(remove.retryable_codes.empty());
+  EXPECT_EQ(remove.max_attempts, 1);
+  EXPECT_EQ(remove.timeout_ms, 60000);
+  EXPECT_EQ(remove.call_timeout_ms, 60000);
+}
+
+TEST_F(ServiceConfigTest, DefaultEntry) {
+  ServiceConfig config;
+  std::string error;
+  ASSERT_TRUE(ServiceConfig::Parse(
+      R"""({"methodConfig": [{"name": [{}], "timeout": "2s"}]})""", &config,
+      &error))
+      << error;
+  EXPECT_EQ(config.ForMethod(Method("Get")).timeout_ms, 2000);
+  EXPECT_EQ(config.ForMethod(Method("Get")).call_timeout_ms, 2000);
+
+  // An entry without a timeout has no default call timeout.
+  ServiceConfig no_timeout;
+  ASSERT_TRUE(ServiceConfig::Parse(
+      R"""({"methodConfig": [{"name": [{}],
+            "retryPolicy": {"maxAttempts": 3,
+                            "retryableStatusCodes": ["UNAVAILABLE"]}}]})""",
+      &no_timeout, &error))
+      << error;
+  EXPECT_EQ(no_timeout.ForMethod(Method("Get")).call_timeout_ms, 0);
+  // Nor a time limit on its retries, only the attempts bound them.
+  EXPECT_EQ(no_timeout.ForMethod(Method("Get")).timeout_ms, 0);
+  EXPECT_EQ(no_timeout.ForMethod(Method("Get")).max_attempts, 3);
+}
+
+TEST_F(ServiceConfigTest, MaxAttempts) {
+  auto parse = [](std::string const& retry_policy, ServiceConfig* config,
+                  std::string* error) {
+    return ServiceConfig::Parse(
+        absl::StrCat(R"""({"methodConfig": [{"name": [{}], "retryPolicy": )""",
+                     retry_policy, "}]}"),
+        config, error);
+  };
+  ServiceConfig config;
+  std::string error;
+  // Values above 5 are capped, as gRPC does.
+  ASSERT_TRUE(parse(R"""({"maxAttempts": 100})""", &config, &error)) << error;
+  EXPECT_EQ(config.ForMethod(Method("Get")).max_attempts, 5);
+
+  ServiceConfig two;
+  ASSERT_TRUE(parse(R"""({"maxAttempts": 2})""", &two, &error)) << error;
+  EXPECT_EQ(two.ForMethod(Method("Get")).max_attempts, 2);
+
+  // Values below 2, and a missing value, are rejected.
+  for (auto const* policy :
+       {R"""({"maxAttempts": 1})""", R"""({"maxAttempts": 0})""",
+        R"""({"maxAttempts": -3})""", R"""({"maxAttempts": "3"})""",
+        R"""({"retryableStatusCodes": ["UNAVAILABLE"]})"""}) {
+    ServiceConfig rejected;
+    error.clear();
+    EXPECT_FALSE(parse(policy, &rejected, &error)) << policy;
+    EXPECT_NE(error.find("maxAttempts"), std::string::npos) << policy;
+  }
+}
+
+TEST_F(ServiceConfigTest, Errors) {
+  ServiceConfig config;
+  std::string error;
+  EXPECT_FALSE(ServiceConfig::Parse("not json", &config, &error));
+  EXPECT_FALSE(error.empty());
+
+  error.clear();
+  EXPECT_FALSE(ServiceConfig::Parse(
+      R"""({"methodConfig": [{"name": [{}], "timeout": "2m"}]})""", &config,
+      &error));
+  EXPECT_NE(error.find("2m"), std::string::npos);
+
+  error.clear();
+  EXPECT_FALSE(ServiceConfig::Parse(R"""({"methodConfig": [{
+      "name": [{}],
+      "retryPolicy": {"maxAttempts": 2, "retryableStatusCodes": ["TRY_AGAIN"]}
+    }]})""",
+                                    &config, &error));
+  EXPECT_NE(error.find("TRY_AGAIN"), std::string::npos);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace codegen
+}  // namespace api
+}  // namespace google
@@ -16,7 +16,10 @@
 #include "generator/internal/data_model.h"
 #include "generator/internal/gapic_utils.h"
 #include "generator/internal/printer.h"
+#include "generator/internal/request_params.h"
+#include "generator/internal/service_config.h"
 #include <google/protobuf/descriptor.h>
+#include <string>
 
 namespace pb = google::protobuf;
 
@@ -33,10 +36,18 @@ std::vector<std::string> BuildClientStubCCIncludes(
                        "_stub.gapic.h")),
       LocalInclude(absl::StrCat(
           absl::StripSuffix(service->file()->name(), ".proto"), ".grpc.pb.h")),
-      LocalInclude("gax/call_context.h"), LocalInclude("gax/retry_loop.h"),
-      LocalInclude("gax/status.h"), LocalInclude("grpcpp/client_context.h"),
+      LocalInclude("gax/adaptive_throttler.h"),
+      LocalInclude("gax/call_context.h"),
+      LocalInclude("gax/cancellation_token.h"),
+      LocalInclude("gax/circuit_breaker.h"), LocalInclude("gax/hedging.h"),
+      LocalInclude("gax/internal/request_params.h"),
+      LocalInclude("gax/method_config.h"),
+      LocalInclude("gax/retry_budget.h"), LocalInclude("gax/retry_loop.h"),
+      LocalInclude("gax/status.h"), LocalInclude("gax/thread_pool.h"),
+      LocalInclude("gax/timer_queue.h"),
+      LocalInclude("grpcpp/client_context.h"),
       LocalInclude("grpcpp/channel.h"), LocalInclude("grpcpp/create_channel.h"),
-      SystemInclude("chrono"), SystemInclude("thread")};
+      SystemInclude("chrono"), SystemInclude("cstdint")};
 }
 
 std::vector<std::string> BuildClientStubCCNamespaces(
@@ -44,9 +55,62 @@ std::vector<std::string> BuildClientStubCCNamespaces(
   return {};
 }
 
+namespace {
+
+void SetMethodRetryVars(MethodRetrySettings const& settings,
+                        std::map<std::string, std::string>& vars) {
+  std::vector<std::string> codes;
+  for (auto const& code : settings.retryable_codes) {
+    codes.push_back(absl::StrCat("google::gax::RetryableCode(\n"
+                                 "         google::gax::StatusCode::",
+                                 code, ")"));
+  }
+  vars["retryable_codes"] =
+      codes.empty() ? "0" : absl::StrJoin(codes, " |\n     ");
+  vars["max_attempts"] = std::to_string(settings.max_attempts);
+  vars["timeout_ms"] = std::to_string(settings.timeout_ms);
+  vars["initial_backoff_ms"] = std::to_string(settings.initial_backoff_ms);
+  vars["max_backoff_ms"] = std::to_string(settings.max_backoff_ms);
+  // Print a double literal, even for whole numbers.
+  auto multiplier = absl::StrCat(settings.backoff_multiplier);
+  if (multiplier.find_first_of(".e") == std::string::npos) {
+    multiplier += ".0";
+  }
+  vars["backoff_multiplier"] = multiplier;
+}
+
+// Set "prepare_grpc_context" to the code that initializes `grpc_ctx`,
+// sending the request fields in the method's http path as the
+// x-goog-request-params header.
+void SetMethodRequestParamsVars(pb::MethodDescriptor const* method,
+                                std::map<std::string, std::string>& vars) {
+  auto const params = MethodRequestParams(method);
+  if (params.empty()) {
+    vars["prepare_grpc_context"] =
+        "    context.PrepareGrpcContext(&grpc_ctx);\n";
+    return;
+  }
+  std::string code =
+      "    google::gax::internal::RequestParamsBuilder params;\n";
+  for (auto const& param : params) {
+    auto value = param.is_string
+                     ? param.accessor
+                     : absl::StrCat("static_cast<std::int64_t>(",
+                                    param.accessor, ")");
+    absl::StrAppend(&code, "    params.Add(\"", param.name, "\", ", value,
+                    ");\n");
+  }
+  absl::StrAppend(&code,
+                  "    context.PrepareGrpcContext(&grpc_ctx, params.str());\n");
+  vars["prepare_grpc_context"] = code;
+}
+
+}  // namespace
+
 bool GenerateClientStubCC(pb::ServiceDescriptor const* service,
                           std::map<std::string, std::string> const& vars,
-                          Printer& p, std::string* /* error */) {
+                          ServiceConfig const& service_config, Printer& p,
+                          std::string* /* error */) {
   auto includes = BuildClientStubCCIncludes(service);
   auto namespaces = BuildClientStubCCNamespaces(service);
 
@@ -99,19 +163,31 @@ bool GenerateClientStubCC(pb::ServiceDescriptor const* service,
            "const&) = delete;\n"
            "\n");
 
-  DataModel::PrintMethods(
-      service, vars, p,
-      "  google::gax::Status\n"
-      "  $method_name$(google::gax::CallContext& context,\n"
-      "    $request_object$ const& request,\n"
-      "    $response_object$* response) override {\n"
-      "    grpc::ClientContext grpc_ctx;\n"
-      "    context.PrepareGrpcContext(&grpc_ctx);\n"
-      "    return google::gax::GrpcStatusToGaxStatus("
-      "grpc_stub_->$method_name$(&grpc_ctx, request, response));\n"
-      "  }\n"
-      "\n",
-      NoStreamingPredicate);
+  for (int i = 0; i < service->method_count(); i++) {
+    auto const* method = service->method(i);
+    if (!NoStreamingPredicate(method)) {
+      continue;
+    }
+    auto method_vars = vars;
+    DataModel::SetMethodVars(method, method_vars);
+    SetMethodRequestParamsVars(method, method_vars);
+    p->Print(
+        method_vars,
+        "  google::gax::Status\n"
+        "  $method_name$(google::gax::CallContext& context,\n"
+        "    $request_object$ const& request,\n"
+        "    $response_object$* response) override {\n"
+        "    grpc::ClientContext grpc_ctx;\n"
+        "$prepare_grpc_context$"
+        "    google::gax::ScopedGrpcCancellation cancellation(\n"
+        "        context.CancellationToken(), &grpc_ctx);\n"
+        "    auto status = grpc_stub_->$method_name$(&grpc_ctx, request, "
+        "response);\n"
+        "    return google::gax::GrpcStatusToGaxStatus(std::move(status), "
+        "grpc_ctx);\n"
+        "  }\n"
+        "\n");
+  }
 
   p->Print(vars,
            " private:\n"
@@ -119,18 +195,42 @@ bool GenerateClientStubCC(pb::ServiceDescriptor const* service,
            "};  // Default$stub_class_name$\n"
            "\n");
 
+  // Per-method retry settings, from the service config. The table has a row
+  // for every method, so the rows can be indexed by method.
+  p->Print(vars,
+           "// The retry settings for each method, in declaration order.\n"
+           "constexpr google::gax::MethodRetryConfig "
+           "k$class_name$RetryConfig[] = {\n");
+  for (int i = 0; i < service->method_count(); i++) {
+    auto method_vars = vars;
+    DataModel::SetMethodVars(service->method(i), method_vars);
+    SetMethodRetryVars(service_config.ForMethod(service->method(i)),
+                       method_vars);
+    p->Print(method_vars,
+             "    {\"$method_name$\",\n"
+             "     $retryable_codes$,\n"
+             "     $max_attempts$, std::chrono::milliseconds($timeout_ms$),\n"
+             "     std::chrono::milliseconds($initial_backoff_ms$),\n"
+             "     std::chrono::milliseconds($max_backoff_ms$), "
+             "$backoff_multiplier$},\n");
+  }
+  p->Print("};\n"
+           "\n");
+
   // Retrying stub that decorates another stub
   p->Print(vars,
            "class Retry$stub_class_name$ : public $stub_class_name$ {\n"
            " public:\n"
+           "  using DefaultRetryPolicy = "
+           "google::gax::MethodConfigRetryPolicy<>;\n"
+           "  using DefaultBackoffPolicy = "
+           "google::gax::ExponentialBackoffPolicy;\n"
+           "\n"
            "  Retry$stub_class_name$(std::unique_ptr<$stub_class_name$> stub,\n"
-           "                          google::gax::RetryPolicy const& "
-           "retry_policy,\n"
-           "                          google::gax::BackoffPolicy const& "
-           "backoff_policy) :\n"
+           "                          std::shared_ptr<google::gax::RetryBudget> "
+           "retry_budget) :\n"
            "            next_stub_(std::move(stub)),\n"
-           "            default_retry_policy_(retry_policy.clone()),\n"
-           "            default_backoff_policy_(backoff_policy.clone()) {}\n"
+           "            default_retry_budget_(std::move(retry_budget)) {}\n"
            "\n");
 
   DataModel::PrintMethods(
@@ -139,16 +239,30 @@ bool GenerateClientStubCC(pb::ServiceDescriptor const* service,
       "  $method_name$(google::gax::CallContext& context,\n"
       "             $request_object$ const& request,\n"
       "             $response_object$* response) override {\n"
+      "    if (default_retry_budget_ && !context.RetryBudget()) {\n"
+      "      context.SetRetryBudget(default_retry_budget_);\n"
+      "    }\n"
+      "    auto const& config = k$class_name$RetryConfig[$method_index$];\n"
       "    auto invoke_stub = [this](google::gax::CallContext& c,\n"
       "                $request_object$ const& req,\n"
       "                $response_object$* resp) {\n"
       "              return this->next_stub_->$method_name$(c, req, resp);\n"
       "            };\n"
+      "    if (context.HasRetryPolicy() || context.HasBackoffPolicy()) {\n"
+      "      return google::gax::MakeRetryCall<$request_object$,\n"
+      "                                        $response_object$,\n"
+      "                                        decltype(invoke_stub)>(\n"
+      "          context, request, response, std::move(invoke_stub),\n"
+      "          clone_retry(context, config), clone_backoff(context, "
+      "config));\n"
+      "    }\n"
+      "    // The default policies have known types, build them on the stack\n"
+      "    // instead of cloning.\n"
       "    return google::gax::MakeRetryCall<$request_object$,\n"
       "                                      $response_object$,\n"
       "                                      decltype(invoke_stub)>(\n"
       "        context, request, response, std::move(invoke_stub),\n"
-      "        clone_retry(context), clone_backoff(context));\n"
+      "        DefaultRetryPolicy(config), DefaultBackoff(config));\n"
       "  }\n"
       "\n",
       NoStreamingPredicate);
@@ -156,27 +270,172 @@ bool GenerateClientStubCC(pb::ServiceDescriptor const* service,
   p->Print(
       vars,
       " private:\n"
-      "  std::unique_ptr<google::gax::RetryPolicy>\n"
-      "  clone_retry(google::gax::CallContext const &context) const {\n"
+      "  static DefaultBackoffPolicy DefaultBackoff(\n"
+      "      google::gax::MethodRetryConfig const& config) {\n"
+      "    return DefaultBackoffPolicy(config.initial_backoff, "
+      "config.max_backoff,\n"
+      "                                config.backoff_multiplier);\n"
+      "  }\n"
+      "\n"
+      "  google::gax::RetryPolicyHolder\n"
+      "  clone_retry(google::gax::CallContext const &context,\n"
+      "              google::gax::MethodRetryConfig const& config) const {\n"
       "    auto context_retry = context.RetryPolicy();\n"
-      "    return context_retry ? std::move(context_retry)\n"
-      "                         : std::move(default_retry_policy_->clone());\n"
+      "    return context_retry ? context_retry\n"
+      "                         : google::gax::RetryPolicyHolder(\n"
+      "                               DefaultRetryPolicy(config));\n"
       "  }\n"
       "\n"
-      "  std::unique_ptr<google::gax::BackoffPolicy>\n"
-      "  clone_backoff(google::gax::CallContext const &context) const {\n"
+      "  google::gax::BackoffPolicyHolder\n"
+      "  clone_backoff(google::gax::CallContext const &context,\n"
+      "                google::gax::MethodRetryConfig const& config) const {\n"
       "    auto context_backoff = context.BackoffPolicy();\n"
-      "    return context_backoff ? std::move(context_backoff)\n"
-      "                           : "
-      "std::move(default_backoff_policy_->clone());\n"
+      "    return context_backoff ? context_backoff\n"
+      "                           : google::gax::BackoffPolicyHolder(\n"
+      "                                 DefaultBackoff(config));\n"
       "  }\n"
       "\n"
       "  std::unique_ptr<$stub_class_name$> next_stub_;\n"
-      "  const std::unique_ptr<google::gax::RetryPolicy const> "
-      "default_retry_policy_;\n"
-      "  const std::unique_ptr<google::gax::BackoffPolicy const>  "
-      "default_backoff_policy_;\n"
-      "};  // Retry$stub_class_name$\n");
+      "  const std::shared_ptr<google::gax::RetryBudget> "
+      "default_retry_budget_;\n"
+      "};  // Retry$stub_class_name$\n"
+      "\n");
+
+  // Hedging stub that decorates another stub
+  p->Print(vars,
+           "class Hedging$stub_class_name$ : public $stub_class_name$ {\n"
+           " public:\n"
+           "  Hedging$stub_class_name$(std::unique_ptr<$stub_class_name$> "
+           "stub,\n"
+           "                            google::gax::HedgingPolicy const& "
+           "policy,\n"
+           "                            std::shared_ptr<google::gax::TimerQueue> "
+           "timers,\n"
+           "                            std::shared_ptr<google::gax::ThreadPool> "
+           "executor,\n"
+           "                            std::shared_ptr<google::gax::HedgingStats> "
+           "stats) :\n"
+           "            next_stub_(std::move(stub))");
+  DataModel::PrintMethods(
+      service, vars, p,
+      ",\n"
+      "            $method_name_snake$_hedger_(\n"
+      "                std::make_shared<google::gax::Hedger>(policy, timers, "
+      "executor,\n"
+      "                                                      stats, "
+      "\"$method_name$\"))",
+      NoStreamingPredicate);
+  p->Print(vars,
+           " {}\n"
+           "\n");
+
+  DataModel::PrintMethods(
+      service, vars, p,
+      "  google::gax::Status\n"
+      "  $method_name$(google::gax::CallContext& context,\n"
+      "             $request_object$ const& request,\n"
+      "             $response_object$* response) override {\n"
+      "    if (context.Info().idempotency !=\n"
+      "        google::gax::MethodInfo::Idempotency::IDEMPOTENT) {\n"
+      "      return next_stub_->$method_name$(context, request, response);\n"
+      "    }\n"
+      "    auto next_stub = next_stub_;\n"
+      "    auto invoke_stub = [next_stub](google::gax::CallContext& c,\n"
+      "                $request_object$ const& req,\n"
+      "                $response_object$* resp) {\n"
+      "              return next_stub->$method_name$(c, req, resp);\n"
+      "            };\n"
+      "    return google::gax::MakeHedgedCall<$request_object$,\n"
+      "                                       $response_object$>(\n"
+      "        context, request, response, std::move(invoke_stub),\n"
+      "        $method_name_snake$_hedger_);\n"
+      "  }\n"
+      "\n",
+      NoStreamingPredicate);
+
+  p->Print(vars,
+           " private:\n"
+           "  std::shared_ptr<$stub_class_name$> next_stub_;\n");
+  DataModel::PrintMethods(service, vars, p,
+                          "  std::shared_ptr<google::gax::Hedger> "
+                          "$method_name_snake$_hedger_;\n",
+                          NoStreamingPredicate);
+  p->Print(vars,
+           "};  // Hedging$stub_class_name$\n"
+           "\n");
+
+  // Circuit breaking stub that decorates another stub
+  p->Print(vars,
+           "class CircuitBreaker$stub_class_name$ : public $stub_class_name$ "
+           "{\n"
+           " public:\n"
+           "  CircuitBreaker$stub_class_name$("
+           "std::unique_ptr<$stub_class_name$> stub,\n"
+           "      google::gax::CircuitBreakerPolicy const& policy) :\n"
+           "            next_stub_(std::move(stub))");
+  DataModel::PrintMethods(service, vars, p,
+                          ",\n"
+                          "            $method_name_snake$_breaker_(policy, "
+                          "\"$method_name$\")",
+                          NoStreamingPredicate);
+  p->Print(vars,
+           " {}\n"
+           "\n");
+
+  DataModel::PrintMethods(
+      service, vars, p,
+      "  google::gax::Status\n"
+      "  $method_name$(google::gax::CallContext& context,\n"
+      "             $request_object$ const& request,\n"
+      "             $response_object$* response) override {\n"
+      "    return $method_name_snake$_breaker_.Call([&] {\n"
+      "      return next_stub_->$method_name$(context, request, response);\n"
+      "    });\n"
+      "  }\n"
+      "\n",
+      NoStreamingPredicate);
+
+  p->Print(vars,
+           " private:\n"
+           "  std::unique_ptr<$stub_class_name$> next_stub_;\n");
+  DataModel::PrintMethods(service, vars, p,
+                          "  google::gax::CircuitBreaker<> "
+                          "$method_name_snake$_breaker_;\n",
+                          NoStreamingPredicate);
+  p->Print(vars,
+           "};  // CircuitBreaker$stub_class_name$\n"
+           "\n");
+
+  // Adaptive throttling stub that decorates another stub
+  p->Print(vars,
+           "class Throttling$stub_class_name$ : public $stub_class_name$ {\n"
+           " public:\n"
+           "  Throttling$stub_class_name$(std::unique_ptr<$stub_class_name$> "
+           "stub,\n"
+           "      std::shared_ptr<google::gax::AdaptiveThrottler<>> "
+           "throttler) :\n"
+           "            next_stub_(std::move(stub)),\n"
+           "            throttler_(std::move(throttler)) {}\n"
+           "\n");
+
+  DataModel::PrintMethods(
+      service, vars, p,
+      "  google::gax::Status\n"
+      "  $method_name$(google::gax::CallContext& context,\n"
+      "             $request_object$ const& request,\n"
+      "             $response_object$* response) override {\n"
+      "    return throttler_->Call([&] {\n"
+      "      return next_stub_->$method_name$(context, request, response);\n"
+      "    });\n"
+      "  }\n"
+      "\n",
+      NoStreamingPredicate);
+
+  p->Print(vars,
+           " private:\n"
+           "  std::unique_ptr<$stub_class_name$> next_stub_;\n"
+           "  std::shared_ptr<google::gax::AdaptiveThrottler<>> throttler_;\n"
+           "};  // Throttling$stub_class_name$\n");
 
   p->Print(vars,
            "}  // namespace\n"
@@ -189,23 +448,55 @@ bool GenerateClientStubCC(pb::ServiceDescriptor const* service,
            "std::unique_ptr<$stub_class_name$>\n"
            "Create$stub_class_name$(std::shared_ptr<grpc::ChannelCredentials> "
            "creds) {\n"
+           "  return Create$stub_class_name$(std::move(creds), nullptr);\n"
+           "}\n"
+           "\n"
+           "std::unique_ptr<$stub_class_name$>\n"
+           "Create$stub_class_name$(std::shared_ptr<grpc::ChannelCredentials> "
+           "creds,\n"
+           "    std::shared_ptr<google::gax::RetryBudget> retry_budget) {\n"
            "  auto channel = grpc::CreateChannel(\"$service_endpoint$\",\n"
            "    std::move(creds));\n"
            "  auto grpc_stub = $grpc_stub_fqn$::NewStub(std::move(channel));\n"
            "  auto default_stub = std::unique_ptr<$stub_class_name$>(new\n"
            "    Default$stub_class_name$(std::move(grpc_stub)));\n"
-           "  using ms = std::chrono::milliseconds;\n"
-           "  // Note: these retry and backoff times are dummy stand ins.\n"
-           "  // More appopriate default values will be chosen later.\n"
-           "  google::gax::LimitedDurationRetryPolicy<> retry_policy(ms(500), "
-           "ms(500));\n"
-           "  google::gax::ExponentialBackoffPolicy backoff_policy(ms(20), "
-           "ms(100));\n"
            "  return std::unique_ptr<$stub_class_name$>(new "
            "Retry$stub_class_name$(\n"
            "                       std::move(default_stub),\n"
-           "                       retry_policy,\n"
-           "                       backoff_policy));\n"
+           "                       std::move(retry_budget)));\n"
+           "}\n"
+           "\n"
+           "std::unique_ptr<$stub_class_name$>\n"
+           "CreateHedging$stub_class_name$(std::unique_ptr<$stub_class_name$> "
+           "stub,\n"
+           "    google::gax::HedgingPolicy const& policy,\n"
+           "    std::shared_ptr<google::gax::TimerQueue> timers,\n"
+           "    std::shared_ptr<google::gax::ThreadPool> executor,\n"
+           "    std::shared_ptr<google::gax::HedgingStats> stats) {\n"
+           "  return std::unique_ptr<$stub_class_name$>(new "
+           "Hedging$stub_class_name$(\n"
+           "                       std::move(stub), policy, "
+           "std::move(timers),\n"
+           "                       std::move(executor), std::move(stats)));\n"
+           "}\n"
+           "\n"
+           "std::unique_ptr<$stub_class_name$>\n"
+           "CreateCircuitBreaker$stub_class_name$("
+           "std::unique_ptr<$stub_class_name$> stub,\n"
+           "    google::gax::CircuitBreakerPolicy const& policy) {\n"
+           "  return std::unique_ptr<$stub_class_name$>(new "
+           "CircuitBreaker$stub_class_name$(\n"
+           "                       std::move(stub), policy));\n"
+           "}\n"
+           "\n"
+           "std::unique_ptr<$stub_class_name$>\n"
+           "CreateThrottling$stub_class_name$("
+           "std::unique_ptr<$stub_class_name$> stub,\n"
+           "    std::shared_ptr<google::gax::AdaptiveThrottler<>> throttler) "
+           "{\n"
+           "  return std::unique_ptr<$stub_class_name$>(new "
+           "Throttling$stub_class_name$(\n"
+           "                       std::move(stub), std::move(throttler)));\n"
            "}\n"
            "\n");
 
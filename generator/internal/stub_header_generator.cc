@@ -31,7 +31,11 @@ std::vector<std::string> BuildClientStubHeaderIncludes(
     pb::ServiceDescriptor const* service) {
   return {LocalInclude(absl::StrCat(
               absl::StripSuffix(service->file()->name(), ".proto"), ".pb.h")),
-          LocalInclude("gax/call_context.h"), LocalInclude("gax/status.h"),
+          LocalInclude("gax/adaptive_throttler.h"),
+          LocalInclude("gax/call_context.h"),
+          LocalInclude("gax/circuit_breaker.h"), LocalInclude("gax/hedging.h"),
+          LocalInclude("gax/retry_budget.h"), LocalInclude("gax/status.h"),
+          LocalInclude("gax/thread_pool.h"), LocalInclude("gax/timer_queue.h"),
           LocalInclude("grpcpp/security/credentials.h"),
           SystemInclude("memory")};
 }
@@ -90,6 +94,65 @@ bool GenerateClientStubHeader(pb::ServiceDescriptor const* service,
            "Create$stub_class_name$(std::shared_ptr<grpc::ChannelCredentials> "
            "creds);\n"
            "\n"
+           "/// Create a stub whose retries are limited by @p retry_budget.\n"
+           "std::unique_ptr<$stub_class_name$>\n"
+           "Create$stub_class_name$(std::shared_ptr<grpc::ChannelCredentials> "
+           "creds,\n"
+           "    std::shared_ptr<google::gax::RetryBudget> retry_budget);\n"
+           "\n"
+           "/**\n"
+           " * Decorate @p stub so that calls to idempotent methods are "
+           "hedged.\n"
+           " *\n"
+           " * If an attempt has not completed after the policy's delay, a "
+           "backup attempt\n"
+           " * is sent and the first successful response is used. Per-method "
+           "counters of\n"
+           " * hedges sent and won are kept in @p stats, if not null.\n"
+           " *\n"
+           " * The backup attempts are scheduled on @p timers and run on "
+           "@p executor,\n"
+           " * both usually shared by all the stubs of an application. The "
+           "executor's\n"
+           " * size bounds the threads used for hedging. Shut both down only "
+           "after the\n"
+           " * stubs using them are gone.\n"
+           " */\n"
+           "std::unique_ptr<$stub_class_name$>\n"
+           "CreateHedging$stub_class_name$(std::unique_ptr<$stub_class_name$> "
+           "stub,\n"
+           "    google::gax::HedgingPolicy const& policy,\n"
+           "    std::shared_ptr<google::gax::TimerQueue> timers,\n"
+           "    std::shared_ptr<google::gax::ThreadPool> executor,\n"
+           "    std::shared_ptr<google::gax::HedgingStats> stats = nullptr);\n"
+           "\n"
+           "/**\n"
+           " * Decorate @p stub with a per-method circuit breaker.\n"
+           " *\n"
+           " * While a method's breaker is open its calls fail fast with "
+           "UNAVAILABLE. Wrap\n"
+           " * the stub returned by Create$stub_class_name$(), so that "
+           "rejected calls are\n"
+           " * not retried.\n"
+           " */\n"
+           "std::unique_ptr<$stub_class_name$>\n"
+           "CreateCircuitBreaker$stub_class_name$("
+           "std::unique_ptr<$stub_class_name$> stub,\n"
+           "    google::gax::CircuitBreakerPolicy const& policy);\n"
+           "\n"
+           "/**\n"
+           " * Decorate @p stub with client-side adaptive throttling.\n"
+           " *\n"
+           " * When the service rejects too many requests, some calls are "
+           "rejected locally\n"
+           " * with RESOURCE_EXHAUSTED. The same throttler may be shared by "
+           "several stubs.\n"
+           " */\n"
+           "std::unique_ptr<$stub_class_name$>\n"
+           "CreateThrottling$stub_class_name$("
+           "std::unique_ptr<$stub_class_name$> stub,\n"
+           "    std::shared_ptr<google::gax::AdaptiveThrottler<>> throttler);\n"
+           "\n"
            "#endif  // $stub_header_include_guard_const$\n");
 
   return true;
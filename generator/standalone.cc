@@ -69,7 +69,8 @@ bool ExtractFileNames(std::vector<std::string> const& desc_sets,
 }
 
 // Converts arguments from what is required by GAPIC generator standalone mode
-// specification (--descriptor, --package, --output) to what is understood by
+// specification (--descriptor, --package, --output, and the optional
+// --grpc_service_config) to what is understood by
 // google::protobuf::CommandLineInterface. CommandLineInterface seems like the
 // preferred way of writing GAPIC generator in C++:
 // - it is what is used by protoc main() itself;
@@ -87,11 +88,14 @@ bool ConvertCommandLineArgs(int argc, char const* const argv[],
   std::string const desc_arg("--descriptor");
   std::string const output_arg("--output");
   std::string const package_arg("--package");
+  std::string const service_config_arg("--grpc_service_config");
 
   std::string const desc_set_in_arg("--descriptor_set_in=");
 
   std::vector<std::string> desc_set_in;
   std::vector<std::string> packages;
+  std::string output;
+  std::string service_config;
 
   for (int i = 0; i < argc; i++) {
     std::vector<std::string> arg =
@@ -110,7 +114,9 @@ bool ConvertCommandLineArgs(int argc, char const* const argv[],
           absl::StrSplit(arg_val, absl::ByAnyChar(":;"));
       std::move(spl.begin(), spl.end(), std::back_inserter(desc_set_in));
     } else if (arg_name == output_arg) {
-      args->emplace_back("--cpp_gapic_out=" + arg_val);
+      output = arg_val;
+    } else if (arg_name == service_config_arg) {
+      service_config = arg_val;
     } else if (arg_name == package_arg) {
       std::vector<std::string> const& spl =
           absl::StrSplit(arg_val, absl::ByAnyChar(":;"));
@@ -120,6 +126,15 @@ bool ConvertCommandLineArgs(int argc, char const* const argv[],
     }
   }
 
+  if (!output.empty()) {
+    // Generator parameters go before the output directory, separated by ':'.
+    args->emplace_back(
+        "--cpp_gapic_out=" +
+        (service_config.empty() ? "" : "grpc_service_config=" +
+                                           service_config + ":") +
+        output);
+  }
+
   if (!desc_set_in.empty()) {
     std::vector<std::string> file_names;
     if (!ExtractFileNames(desc_set_in, packages, &file_names, error_msg)) {